@@ -0,0 +1,122 @@
+// measures reads through the bus, comparing the ways an address got resolved to its device
+//   search: a binary search of the regions for every read, the way the bus did it before its page table
+//   device: the page table, reading through the device functions, the slow path of bus_read
+//   read:   bus_read, reading memory straight from the page table
+// build and run from the root of the repository:
+//   cc -O2 -std=gnu11 -I. -o bench_bus bench/bench_bus.c $(ls *.c | grep -v main.c) && ./bench_bus
+// every way runs several times in turn, the fastest run of each counts, as the others mostly measure the host
+
+#include "bus.h"
+#include "memory.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define RUNS 7
+#define READS 100000000
+// the addresses are read in a random order, so branch prediction doesn't learn the layout
+#define ADDRESS_COUNT 0x10000
+// a small device placed over the ram this many times in the second layout, each place splits the ram around it
+#define DEVICE_COUNT 16
+#define DEVICE_SIZE 0x100
+
+enum way { WAY_SEARCH, WAY_DEVICE, WAY_READ, WAY_COUNT };
+
+static const char* const wayNames[WAY_COUNT] = { "search", "device", "read" };
+
+static uint16_t addresses[ADDRESS_COUNT];
+
+static int compareRegion(const void* key, const void* element) {
+	const uint16_t addr = *(const uint16_t*) key;
+	const region_t* region = element;
+	if (addr < region->begin)
+		return -1;
+	if (addr > region->end)
+		return 1;
+	return 0;
+}
+
+// the lookup of the bus before the page table
+static uint8_t searchRead(const bus_t* bus, const uint16_t fullAddr) {
+	const region_t* region = bsearch(&fullAddr, bus->regions, bus->size, sizeof(region_t), compareRegion);
+	if (region == NULL || region->device->readFunc == NULL)
+		return 0;
+
+	const addr_t addr = { .full = fullAddr, .relative = (uint16_t) (fullAddr - region->begin + region->base) };
+	return region->device->readFunc(region->device, addr);
+}
+
+// returns the reads per second of the fastest run
+static double measure(const bus_t* bus, const enum way way, unsigned* checksum) {
+	double best = 0;
+	for (int run = 0; run < RUNS; run++) {
+		unsigned sum = 0;
+		const clock_t start = clock();
+		for (size_t i = 0; i < READS; i++) {
+			const uint16_t addr = addresses[i & (ADDRESS_COUNT - 1)];
+			switch (way) {
+			case WAY_SEARCH: sum += searchRead(bus, addr); break;
+			case WAY_DEVICE: sum += bus_readDevice(bus, addr); break;
+			default: sum += bus_read(bus, addr); break;
+			}
+		}
+		const double seconds = (double) (clock() - start) / CLOCKS_PER_SEC;
+
+		*checksum += sum;
+		if (seconds > 0 && READS / seconds > best)
+			best = READS / seconds;
+	}
+
+	return best;
+}
+
+static void report(const char* layout, const bus_t* bus) {
+	unsigned checksum = 0;
+	double rates[WAY_COUNT];
+	for (enum way way = 0; way < WAY_COUNT; way++)
+		rates[way] = measure(bus, way, &checksum);
+
+	printf("%s, %zu regions\n", layout, bus->size);
+	for (enum way way = 0; way < WAY_COUNT; way++)
+		printf("  %-6s %7.1f M reads/s, %.2fx search\n", wayNames[way], rates[way] / 1e6, rates[way] / rates[WAY_SEARCH]);
+	// keeps the reads from being optimized away
+	printf("  checksum %08X\n", checksum);
+}
+
+int main() {
+	uint32_t state = 0x2545F491;
+	for (size_t i = 0; i < ADDRESS_COUNT; i++) {
+		state ^= state << 13;
+		state ^= state >> 17;
+		state ^= state << 5;
+		addresses[i] = (uint16_t) state;
+	}
+
+	bus_t bus = { 0 };
+	if (!bus_init(&bus))
+		return -1;
+
+	device_t ram = memory_init(0x10000, true);
+	device_t device = memory_init(DEVICE_SIZE, true);
+
+	// the layout of main.c
+	if (!bus_add(&bus, &ram, 0x0000, 0xFFFF) || !memory_randomize(&ram))
+		return -1;
+	report("64K of ram", &bus);
+
+	// every other block of DEVICE_SIZE in the upper half holds the device
+	if (!memory_randomize(&device))
+		return -1;
+	for (size_t i = 0; i < DEVICE_COUNT; i++) {
+		const uint16_t begin = (uint16_t) (0x8000 + i * 2 * DEVICE_SIZE);
+		if (!bus_add(&bus, &device, begin, begin + DEVICE_SIZE - 1))
+			return -1;
+	}
+	report("ram with small devices", &bus);
+
+	memory_destroy(device);
+	memory_destroy(ram);
+	bus_destroy(&bus);
+	return 0;
+}
@@ -0,0 +1,74 @@
+// runs the functional test of Klaus Dormann to its success loop with the interpreter, the block cache and the jit
+// build and run from the root of the repository:
+//   cc -O2 -std=gnu11 -I. -o bench_cpu bench/bench_cpu.c $(ls *.c | grep -v main.c) && ./bench_cpu
+// every mode runs several times in turn, the fastest run of each counts, as the others mostly measure the host
+
+#include "machine.h"
+#include "memory.h"
+#include "clock.h"
+
+#include <stdio.h>
+#include <time.h>
+
+#define RUNS 9
+// where the test ends up once every test passed
+#define SUCCESS_ADDRESS 0x3469
+
+enum mode { MODE_INTERPRETER, MODE_BLOCK_CACHE, MODE_JIT, MODE_COUNT };
+
+static const char* const modeNames[MODE_COUNT] = { "interpreter", "block cache", "jit" };
+
+// runs the test once, returns the cpu time it took in seconds, or a negative number if it failed
+static double run(const enum mode mode) {
+	machine_t machine = { 0 };
+	if (!machine_init(&machine))
+		return -1;
+
+	device_t ram = memory_init(0x10000, true);
+	if (!bus_add(&machine.bus, &ram, 0x0000, 0xFFFF) || !memory_loadFile(&ram, "test_6502.bin", 0x000a)) {
+		memory_destroy(ram);
+		machine_destroy(&machine);
+		return -1;
+	}
+
+	if ((mode == MODE_BLOCK_CACHE && !cpu_setBlockCache(&machine.cpu, true)) || (mode == MODE_JIT && !cpu_setJit(&machine.cpu, true))) {
+		memory_destroy(ram);
+		machine_destroy(&machine);
+		return -1;
+	}
+
+	clock_reset(&machine);
+	// the test starts at its code, not at the reset vector
+	machine.cpu.registers.PC = 0x0400;
+
+	const clockConfig_t config = { .targetFrequency = CLOCK_UNTHROTTLED };
+	const clock_t start = clock();
+	const clockStop_t stop = clock_runWith(&machine, &config, NULL);
+	const double seconds = (double) (clock() - start) / CLOCKS_PER_SEC;
+
+	const bool passed = stop == CLOCK_STOP_TRAP && machine.cpu.idleAddress == SUCCESS_ADDRESS;
+	memory_destroy(ram);
+	machine_destroy(&machine);
+	return passed ? seconds : -1;
+}
+
+int main() {
+	double best[MODE_COUNT];
+	for (enum mode mode = 0; mode < MODE_COUNT; mode++)
+		best[mode] = -1;
+
+	for (int i = 0; i < RUNS; i++)
+		for (enum mode mode = 0; mode < MODE_COUNT; mode++) {
+			const double seconds = run(mode);
+			if (seconds < 0) {
+				printf("%s: failed\n", modeNames[mode]);
+				return -1;
+			}
+			if (best[mode] < 0 || seconds < best[mode])
+				best[mode] = seconds;
+		}
+
+	for (enum mode mode = 0; mode < MODE_COUNT; mode++)
+		printf("%-12s %.3f s, %.2fx the interpreter\n", modeNames[mode], best[mode], best[MODE_INTERPRETER] / best[mode]);
+	return 0;
+}
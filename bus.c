@@ -8,18 +8,6 @@
 
 // #define VERBOSE
 
-typedef struct {
-	uint16_t begin;
-	uint16_t end;
-	uint16_t base;
-	deviceRef_t device;
-} region_t;
-
-static struct {
-	region_t* regions;
-	size_t size;
-} bus = { 0 };
-
 #ifdef VERBOSE
 
 static uint8_t read(deviceRef_t device, addr_t address) {
@@ -64,7 +52,7 @@ static device_t nullDevice = (device_t) { .name = "null" };
 
 #endif // VERBOSE
 
-#define SEARCH(addr) bsearch(&addr, bus.regions, bus.size, sizeof(region_t), region_search)
+#define SEARCH(addr) bsearch(&addr, bus->regions, bus->size, sizeof(region_t), region_search)
 static int region_search(const void* addr, const void* region) {
 	if (*(uint16_t*) addr < ((region_t*) region)->begin)
 		return -1;
@@ -74,7 +62,118 @@ static int region_search(const void* addr, const void* region) {
 	return 0;
 }
 
-bool bus_init() {
+#define IS_CODE_PAGE(page) (bus->codePages[(page) / 8] & (1 << ((page) % 8)))
+
+// true if any address in page is watched for kind
+static bool isWatchedPage(const bus_t* bus, const busWatch_t kind, const size_t page) {
+	const uint8_t* bits = bus->watches[kind] + page * (BUS_PAGE_SIZE / 8);
+	for (size_t i = 0; i < BUS_PAGE_SIZE / 8; i++)
+		if (bits[i])
+			return true;
+
+	return false;
+}
+
+// hands out the memory of the device covering page, if it has any
+// the device and offset of the page have to be set already
+static void mapMemory(bus_t* bus, const size_t page) {
+	page_t* current = bus->pages + page;
+	current->read = NULL;
+	current->write = NULL;
+	current->fetch = NULL;
+
+#ifndef VERBOSE
+	// only hand out memory covering the entire page, anything else is handled by the device functions
+	// in verbose mode every access should be logged, so memory is never accessed directly
+	// the same goes for an observed bus
+	deviceRef_t device = current->device;
+	if (device->memoryFunc && !bus->observer) {
+		const uint16_t begin = (uint16_t) (page << BUS_PAGE_BITS);
+		const addr_t addr = { begin, (uint16_t) (begin + current->offset) };
+
+		size_t size = 0;
+		uint8_t* data = device->memoryFunc(device, addr, &size);
+		if (data && size >= BUS_PAGE_SIZE) {
+			// watched accesses have to take the slow path, where the watches are checked
+			// so do writes to code pages, and to memory shared with other devices, which is copied first
+			const bool writable = device->writeFunc && !IS_CODE_PAGE(page) && !(device->sharedFunc && device->sharedFunc(device, addr));
+			current->read = isWatchedPage(bus, BUS_WATCH_READ, page) ? NULL : data;
+			current->write = writable && !isWatchedPage(bus, BUS_WATCH_WRITE, page) ? data : NULL;
+			current->fetch = isWatchedPage(bus, BUS_WATCH_EXECUTE, page) ? NULL : data;
+		}
+	}
+#else
+	(void) bus;
+#endif
+}
+
+// rebuilds the page table from the region list
+// must be called every time the region list changes
+// any decoded code could now come from a different device, so all of it gets invalidated
+static void compilePages(bus_t* bus) {
+	memset(bus->codePages, 0, sizeof(bus->codePages));
+
+	size_t i = 0;
+	for (size_t page = 0; page < BUS_PAGE_COUNT; page++) {
+		bus->codeGenerations[page]++;
+
+		uint16_t begin = (uint16_t) (page << BUS_PAGE_BITS);
+		uint16_t end = begin + (BUS_PAGE_SIZE - 1);
+
+		// regions are sorted and cover the whole address space, so the region holding begin is never behind us
+		while (i < bus->size && bus->regions[i].end < begin)
+			i++;
+
+		if (i == bus->size || bus->regions[i].begin > begin || bus->regions[i].end < end) {
+			bus->pages[page] = (page_t) { 0 };
+			continue;
+		}
+
+		const region_t* region = bus->regions + i;
+		bus->pages[page] = (page_t) { .device = region->device, .offset = (uint16_t) (region->base - region->begin) };
+		mapMemory(bus, page);
+	}
+}
+
+// called before a write to a code page
+// makes the decoded code of that page stale, and lets writes to it take the fast path again
+static void invalidateCode(bus_t* bus, const size_t page) {
+	bus->codePages[page / 8] &= ~(1 << (page % 8));
+	bus->codeGenerations[page]++;
+
+	// shared memory is asked for again after the write instead
+	page_t* current = bus->pages + page;
+	if (current->read && current->device->writeFunc && !current->device->sharedFunc && !isWatchedPage(bus, BUS_WATCH_WRITE, page))
+		current->write = current->read;
+}
+
+// called after device wrote to fullAddr through its functions
+// the device could have copied shared memory, which the page then has to point to instead
+static void remapShared(bus_t* bus, deviceRef_t device, const uint16_t fullAddr) {
+	const size_t page = fullAddr >> BUS_PAGE_BITS;
+	if (device->sharedFunc && bus->pages[page].device == device)
+		mapMemory(bus, page);
+}
+
+// finds the device at fullAddr, and stores the address relative to that device in addr
+// pages covered by a single region are resolved from the page table
+// returns NULL if no device was found
+static inline deviceRef_t resolve(const bus_t* bus, const uint16_t fullAddr, addr_t* addr) {
+	const page_t page = bus->pages[fullAddr >> BUS_PAGE_BITS];
+	if (page.device) {
+		*addr = (addr_t) { fullAddr, (uint16_t) (fullAddr + page.offset) };
+		return page.device;
+	}
+
+	region_t* result = SEARCH(fullAddr);
+	if (result == NULL)
+		return NULL;
+
+	*addr = (addr_t) { fullAddr, result->base + (fullAddr - result->begin) };
+	return result->device;
+}
+
+bool bus_init(bus_t* bus) {
 #ifdef _MSC_VER
 	// msvc doesn't support static initialization of pointers, so we do a manual copy here
 	if (nullDevice.name == NULL) {
@@ -89,40 +188,43 @@ bool bus_init() {
 	}
 #endif
 
-	if (bus.regions)
+	if (bus->regions)
 		return false;
 
-	bus.regions = malloc(sizeof(region_t));
-	if (bus.regions == NULL)
+	bus->regions = malloc(sizeof(region_t));
+	if (bus->regions == NULL)
 		return false;
-	bus.size = 1;
+	bus->size = 1;
 
-	bus.regions[0] = (region_t) { .begin = 0x0000, .end = 0xFFFF, .base = 0x0000, .device = &nullDevice };
+	bus->regions[0] = (region_t) { .begin = 0x0000, .end = 0xFFFF, .base = 0x0000, .device = &nullDevice };
+	compilePages(bus);
 
 	return true;
 }
 
-bool bus_destroy() {
-	if (!bus.regions)
+bool bus_destroy(bus_t* bus) {
+	if (!bus->regions)
 		return false;
 
-	free(bus.regions);
-	bus.regions = NULL;
+	free(bus->regions);
+	bus->regions = NULL;
+	bus->size = 0;
+	compilePages(bus);
 
 	return true;
 }
 
-bool bus_add(const device_t* device, const uint16_t begin, const uint16_t end) {
-	if (!bus.regions)
+bool bus_add(bus_t* bus, const device_t* device, const uint16_t begin, const uint16_t end) {
+	if (!bus->regions)
 		return false;
 
 	if (begin > end)
-		return bus_add(device, end, begin);
+		return bus_add(bus, device, end, begin);
 
 	if (device == NULL)
-		return bus_add(&nullDevice, begin, end);
+		return bus_add(bus, &nullDevice, begin, end);
 
-	region_t* newRegions = malloc(sizeof(region_t) * (bus.size + 2));
+	region_t* newRegions = malloc(sizeof(region_t) * (bus->size + 2));
 	if (newRegions == NULL) {
 #ifdef VERBOSE
 		printf("malloc for bus_add failed\n");
@@ -135,13 +237,13 @@ bool bus_add(const device_t* device, const uint16_t begin, const uint16_t end) {
 #endif
 
 	size_t newSize = 0;
-	for (size_t i = 0; i < bus.size; i++) {
-		region_t* region = bus.regions + i;
+	for (size_t i = 0; i < bus->size; i++) {
+		region_t* region = bus->regions + i;
 
 #ifdef VERBOSE
 #define PRINT_REGION() \
 		printf("region %zi/%zi {begin: %04X, end: %04X, base: %04X} ", \
-			i + 1, bus.size, region->begin, region->end, region->base);
+			i + 1, bus->size, region->begin, region->end, region->base);
 #endif
 
 if (end < region->begin || begin > region->end) {
@@ -204,25 +306,84 @@ if (end < region->begin || begin > region->end) {
 
 	region_t* shrunkRegions = realloc(newRegions, sizeof(region_t) * (write + 1));
 
-	free(bus.regions);
-	bus.regions = shrunkRegions ? shrunkRegions : newRegions;
-	bus.size = write + 1;
+	free(bus->regions);
+	bus->regions = shrunkRegions ? shrunkRegions : newRegions;
+	bus->size = write + 1;
+	compilePages(bus);
+
+	return true;
+}
+
+bool bus_setRegions(bus_t* bus, const region_t* regions, const size_t count) {
+	if (!bus->regions || count == 0)
+		return false;
+
+	// the regions have to follow each other without a gap, from the first to the last address
+	for (size_t i = 0; i < count; i++) {
+		if (regions[i].begin > regions[i].end)
+			return false;
+		if (regions[i].begin != (i ? regions[i - 1].end + 1 : 0x0000))
+			return false;
+	}
+	if (regions[count - 1].end != 0xFFFF)
+		return false;
+
+	region_t* newRegions = malloc(sizeof(region_t) * count);
+	if (newRegions == NULL)
+		return false;
+
+	for (size_t i = 0; i < count; i++) {
+		newRegions[i] = regions[i];
+		if (newRegions[i].device == NULL)
+			newRegions[i].device = &nullDevice;
+	}
+
+	free(bus->regions);
+	bus->regions = newRegions;
+	bus->size = count;
+	compilePages(bus);
 
 	return true;
 }
 
-uint8_t bus_read(const uint16_t fullAddr) {
+deviceRef_t bus_nullDevice(void) {
+	return &nullDevice;
+}
+
+static uint8_t readDevice(const bus_t* bus, const uint16_t fullAddr);
+static void writeDevice(bus_t* bus, const uint16_t fullAddr, const uint8_t data);
+
+uint8_t bus_readDevice(const bus_t* bus, const uint16_t fullAddr) {
+	const uint8_t data = readDevice(bus, fullAddr);
+	if (bus->watchFunc && bus_isWatched(bus, BUS_WATCH_READ, fullAddr))
+		bus->watchFunc(bus->watchContext, fullAddr, BUS_WATCH_READ);
+	if (bus->observer)
+		bus->observer(bus->observerContext, fullAddr, data, false);
+
+	return data;
+}
+
+void bus_writeDevice(bus_t* bus, const uint16_t fullAddr, const uint8_t data) {
+	writeDevice(bus, fullAddr, data);
+	if (bus->watchFunc && bus_isWatched(bus, BUS_WATCH_WRITE, fullAddr))
+		bus->watchFunc(bus->watchContext, fullAddr, BUS_WATCH_WRITE);
+	if (bus->observer)
+		bus->observer(bus->observerContext, fullAddr, data, true);
+}
+
+static uint8_t readDevice(const bus_t* bus, const uint16_t fullAddr) {
 #ifdef VERBOSE
 	printf("searching for region to read at %04X\n", fullAddr);
 #endif
 
-	region_t* result = SEARCH(fullAddr);
-	if (result) {
+	addr_t addr;
+	deviceRef_t device = resolve(bus, fullAddr, &addr);
+	if (device) {
 #ifdef VERBOSE
-		printf("found region %p\n", result);
+		printf("found device %p\n", device);
 #endif
-		if (result->device->readFunc) {
-			uint8_t readVal = result->device->readFunc(result->device, (addr_t) {fullAddr, result->base + (fullAddr - result->begin)});
+		if (device->readFunc) {
+			uint8_t readVal = device->readFunc(device, addr);
 
 #ifdef VERBOSE
 			printf("read value %02X\n", readVal);
@@ -241,19 +402,23 @@ uint8_t bus_read(const uint16_t fullAddr) {
 	return 0;
 }
 
-uint8_t bus_get(const uint16_t fullAddr) {
+uint8_t bus_get(const bus_t* bus, const uint16_t fullAddr) {
 #ifdef VERBOSE
 	printf("searching for region to get at %04X\n", fullAddr);
 #endif
 
-	region_t* result = SEARCH(fullAddr);
-	if (result) {
+	const uint8_t* data = bus->pages[fullAddr >> BUS_PAGE_BITS].read;
+	if (data)
+		return data[fullAddr & BUS_PAGE_MASK];
+
+	addr_t addr;
+	deviceRef_t device = resolve(bus, fullAddr, &addr);
+	if (device) {
 #ifdef VERBOSE
-		printf("found region %p\n", result);
+		printf("found device %p\n", device);
 #endif
-		addr_t addr = (addr_t) {fullAddr, result->base + (fullAddr - result->begin)};
-		if (result->device->getFunc) {
-			uint8_t getVal = result->device->getFunc(result->device, addr);
+		if (device->getFunc) {
+			uint8_t getVal = device->getFunc(device, addr);
 
 #ifdef VERBOSE
 			printf("gotten value %02X\n", getVal);
@@ -261,12 +426,12 @@ uint8_t bus_get(const uint16_t fullAddr) {
 			return getVal;
 		}
 
-		if (result->device->readFunc) {
+		if (device->readFunc) {
 #ifdef VERBOSE
 		printf("region cannot be gotten\n");
 #endif
 
-			uint8_t readVal = result->device->readFunc(result->device, addr);
+			uint8_t readVal = device->readFunc(device, addr);
 
 #ifdef VERBOSE
 			printf("read value %02X\n", readVal);
@@ -287,18 +452,23 @@ uint8_t bus_get(const uint16_t fullAddr) {
 	return 0;
 }
 
-void bus_write(const uint16_t fullAddr, const uint8_t data) {
+static void writeDevice(bus_t* bus, const uint16_t fullAddr, const uint8_t data) {
 #ifdef VERBOSE
 	printf("searching for region to write at %04X\n", fullAddr);
 #endif
 
-	region_t* result = SEARCH(fullAddr);
-	if (result) {
+	if (IS_CODE_PAGE(fullAddr >> BUS_PAGE_BITS))
+		invalidateCode(bus, fullAddr >> BUS_PAGE_BITS);
+
+	addr_t addr;
+	deviceRef_t device = resolve(bus, fullAddr, &addr);
+	if (device) {
 #ifdef VERBOSE
-		printf("found region %p\n", result);
+		printf("found device %p\n", device);
 #endif
-		if (result->device->writeFunc) {
-			result->device->writeFunc(result->device, (addr_t) {fullAddr, result->base + (fullAddr - result->begin)}, data);
+		if (device->writeFunc) {
+			device->writeFunc(device, addr, data);
+			remapShared(bus, device, fullAddr);
 #ifdef VERBOSE
 			printf("written value\n");
 #endif
@@ -316,61 +486,141 @@ void bus_write(const uint16_t fullAddr, const uint8_t data) {
 #endif
 }
 
-void bus_place(const uint16_t fullAddr, const uint8_t data) {
+bool bus_canPlace(const bus_t* bus, const uint16_t fullAddr) {
+	if (bus->pages[fullAddr >> BUS_PAGE_BITS].write)
+		return true;
+
+	addr_t addr;
+	deviceRef_t device = resolve(bus, fullAddr, &addr);
+	return device && device != &nullDevice && (device->placeFunc || device->writeFunc);
+}
+
+bool bus_place(bus_t* bus, const uint16_t fullAddr, const uint8_t data) {
 #ifdef VERBOSE
 	printf("searching for region to place at %04X\n", fullAddr);
 #endif
 
-	region_t* result = SEARCH(fullAddr);
-	if (result) {
+	if (IS_CODE_PAGE(fullAddr >> BUS_PAGE_BITS))
+		invalidateCode(bus, fullAddr >> BUS_PAGE_BITS);
+
+	uint8_t* memory = bus->pages[fullAddr >> BUS_PAGE_BITS].write;
+	if (memory) {
+		memory[fullAddr & BUS_PAGE_MASK] = data;
+		return true;
+	}
+
+	addr_t addr;
+	deviceRef_t device = resolve(bus, fullAddr, &addr);
+	// nothing was added at this address, the data would be lost
+	if (device == &nullDevice)
+		return false;
+	if (device) {
 #ifdef VERBOSE
-		printf("found region %p\n", result);
+		printf("found device %p\n", device);
 #endif
-		addr_t addr = (addr_t) {fullAddr, result->base + (fullAddr - result->begin)};
-		if (result->device->placeFunc) {
-			result->device->placeFunc(result->device, addr, data);
+		if (device->placeFunc) {
+			device->placeFunc(device, addr, data);
+			remapShared(bus, device, fullAddr);
 
 #ifdef VERBOSE
 			printf("placed value\n");
 #endif
-			return;
+			return true;
 		}
 
-		if (result->device->writeFunc) {
+		if (device->writeFunc) {
 #ifdef VERBOSE
 		printf("region cannot be placed\n");
 #endif
 
-			result->device->writeFunc(result->device, addr, data);
+			device->writeFunc(device, addr, data);
+			remapShared(bus, device, fullAddr);
 
 #ifdef VERBOSE
 			printf("writen value\n");
 #endif
-			return;
+			return true;
 		}
 
 #ifdef VERBOSE
 		printf("region cannot be written either\n");
 #endif
 
-		return;
+		return false;
 	}
 
 #ifdef VERBOSE
 	printf("couldn't find region\n");
 #endif
-	return;
+	return false;
+}
+
+uint32_t bus_watchCode(bus_t* bus, const uint16_t fullAddr) {
+	const size_t page = fullAddr >> BUS_PAGE_BITS;
+
+	// writes to memory handed out directly would go unnoticed
+	bus->codePages[page / 8] |= 1 << (page % 8);
+	bus->pages[page].write = NULL;
+
+	return bus->codeGenerations[page];
+}
+
+void bus_remap(bus_t* bus) {
+	// the devices stay the same, so does the code in their memory
+	for (size_t page = 0; page < BUS_PAGE_COUNT; page++)
+		if (bus->pages[page].device)
+			mapMemory(bus, page);
+}
+
+void bus_setObserver(bus_t* bus, busObserver observer, void* context) {
+	bus->observer = observer;
+	bus->observerContext = context;
+
+	// memory is only handed out while the bus isn't observed
+	compilePages(bus);
+}
+
+void bus_setWatch(bus_t* bus, const busWatch_t kind, const uint16_t begin, const uint16_t end, const bool enabled) {
+	if (begin > end) {
+		bus_setWatch(bus, kind, end, begin, enabled);
+		return;
+	}
+
+	bool changed = false;
+	for (size_t page = begin >> BUS_PAGE_BITS; page <= (size_t) (end >> BUS_PAGE_BITS); page++) {
+		const bool watched = isWatchedPage(bus, kind, page);
+
+		const size_t first = page << BUS_PAGE_BITS > begin ? page << BUS_PAGE_BITS : begin;
+		const size_t last = (page << BUS_PAGE_BITS) + BUS_PAGE_MASK < end ? (page << BUS_PAGE_BITS) + BUS_PAGE_MASK : end;
+		for (size_t address = first; address <= last; address++) {
+			if (enabled)
+				bus->watches[kind][address / 8] |= 1 << (address % 8);
+			else
+				bus->watches[kind][address / 8] &= ~(1 << (address % 8));
+		}
+
+		changed |= watched != isWatchedPage(bus, kind, page);
+	}
+
+	// only pages that started or stopped being watched need a different fast path
+	if (changed)
+		compilePages(bus);
+}
+
+void bus_setWatchFunc(bus_t* bus, busWatchFunc func, void* context) {
+	bus->watchFunc = func;
+	bus->watchContext = context;
 }
 
-void bus_print() {
-	if (!bus.regions) {
+void bus_print(const bus_t* bus) {
+	if (!bus->regions) {
 		printf("bus not initialized");
 		return;
 	}
 
-	printf("bus size: %zu", bus.size);
-	for (size_t i = 0; i < bus.size; i++) {
-		const region_t* current = bus.regions + i;
+	printf("bus size: %zu", bus->size);
+	for (size_t i = 0; i < bus->size; i++) {
+		const region_t* current = bus->regions + i;
 
 		device_t device = *current->device;
 
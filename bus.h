@@ -4,14 +4,89 @@
 
 #include <stdbool.h>
 
-bool bus_init();
-bool bus_destroy();
+// granularity of the page table, every page spans 1 << BUS_PAGE_BITS addresses
+// smaller pages allow more regions to be resolved without a search, at the cost of a bigger table
+#ifndef BUS_PAGE_BITS
+#define BUS_PAGE_BITS 8
+#endif
+#define BUS_PAGE_COUNT (0x10000 >> BUS_PAGE_BITS)
+#define BUS_PAGE_SIZE (1 << BUS_PAGE_BITS)
+#define BUS_PAGE_MASK (BUS_PAGE_SIZE - 1)
+
+/// precomputed lookup for a single page, rebuilt every time a device is added
+/// device is NULL if the page is split over multiple regions, the region list has to be searched instead
+/// offset is added to a full address to get the relative address for the device
+/// read and write point to the memory backing the start of this page, as handed out by the memoryFunc of the device
+/// they are NULL if that access has to go through the device functions
+/// fetch is the same memory, for reading instructions, it is NULL if the page holds a breakpoint
+typedef struct {
+	deviceRef_t device;
+	uint16_t offset;
+	uint8_t* read;
+	uint8_t* write;
+	const uint8_t* fetch;
+} page_t;
+
+typedef struct {
+	uint16_t begin;
+	uint16_t end;
+	uint16_t base;
+	deviceRef_t device;
+} region_t;
+
+/// called after every access through bus_read and bus_write, with the data that was read or written
+typedef void (*busObserver)(void* context, const uint16_t fullAddr, const uint8_t data, const bool write);
+
+/// accesses that can be watched, see bus_setWatch
+typedef enum {
+	BUS_WATCH_EXECUTE, // fetching an instruction, only noticed by the cpu
+	BUS_WATCH_READ,
+	BUS_WATCH_WRITE,
+
+	BUS_WATCH_KINDS
+} busWatch_t;
+
+/// called after a read or write through bus_read and bus_write of a watched address
+typedef void (*busWatchFunc)(void* context, const uint16_t fullAddr, const busWatch_t kind);
+
+/// a single bus, multiple busses can exist independently of each other
+/// a bus should be zero initialized before calling bus_init
+typedef struct bus {
+	region_t* regions;
+	size_t size;
+	page_t pages[BUS_PAGE_COUNT];
+
+	// one bit per page holding decoded code, writes to these pages go through the slow path
+	uint8_t codePages[(BUS_PAGE_COUNT + 7) / 8];
+	// incremented on every write to a code page, and every time the page table is rebuilt
+	uint32_t codeGenerations[BUS_PAGE_COUNT];
+
+	// NULL if nothing observes the accesses, see bus_setObserver
+	busObserver observer;
+	void* observerContext;
+
+	// one bit per address for every kind of watch
+	// pages holding a watched address hand out no memory for that kind of access, so only the slow path checks these
+	uint8_t watches[BUS_WATCH_KINDS][0x10000 / 8];
+	busWatchFunc watchFunc;
+	void* watchContext;
+} bus_t;
+
+bool bus_init(bus_t* bus);
+bool bus_destroy(bus_t* bus);
 
 /// attaches a device to the bus, spanning range [begin - end]
 /// if a device already exists at that place, it will be hidden for the overlapping address range
 /// if a device is fully overwritten the bus has forgotten about this device.
 /// IT IS NOT DELETED BY THE BUS, THE BUS ONLY KEEPS A POINTER TO THE DEVICE
-bool bus_add(deviceRef_t device, const uint16_t begin, const uint16_t end);
+bool bus_add(bus_t* bus, deviceRef_t device, const uint16_t begin, const uint16_t end);
+
+/// replaces all regions of the bus, like when restoring a layout built by bus_add
+/// regions have to be sorted, and cover [0x0000 - 0xFFFF] without gaps or overlaps, a NULL device is the null device
+/// returns false if they don't
+bool bus_setRegions(bus_t* bus, const region_t* regions, const size_t count);
+/// the device of every address no device was added to
+deviceRef_t bus_nullDevice(void);
 
 /// functions to interact with the bus
 /// read and get are used to get data from a device at that address
@@ -22,9 +97,67 @@ bool bus_add(deviceRef_t device, const uint16_t begin, const uint16_t end);
 /// these could be used to observe the data on the bus, or modifying data which otherwise would make the device response.
 /// get and place fall back to read and write if the function pointers in device are NULL
 /// read and get return 0 if no device was found, or the device could not be read
-uint8_t bus_read(const uint16_t fullAddr);
-uint8_t bus_get(const uint16_t fullAddr);
-void bus_write(const uint16_t fullAddr, const uint8_t data);
-void bus_place(const uint16_t fullAddr, const uint8_t data);
+/// read and write are inlined, so that accesses to plain memory cost no more than a lookup in the page table
+static inline uint8_t bus_read(const bus_t* bus, const uint16_t fullAddr);
+uint8_t bus_get(const bus_t* bus, const uint16_t fullAddr);
+static inline void bus_write(bus_t* bus, const uint16_t fullAddr, const uint8_t data);
+/// place returns false if nothing takes the data: no device was added there, or it has neither a placeFunc nor a writeFunc
+bool bus_place(bus_t* bus, const uint16_t fullAddr, const uint8_t data);
+/// true if bus_place at fullAddr would take the data, without placing anything
+bool bus_canPlace(const bus_t* bus, const uint16_t fullAddr);
+
+/// slow paths of bus_read and bus_write, going through the device functions
+/// these shouldn't be called directly
+uint8_t bus_readDevice(const bus_t* bus, const uint16_t fullAddr);
+void bus_writeDevice(bus_t* bus, const uint16_t fullAddr, const uint8_t data);
+
+static inline uint8_t bus_read(const bus_t* bus, const uint16_t fullAddr) {
+	const uint8_t* data = bus->pages[fullAddr >> BUS_PAGE_BITS].read;
+	if (data)
+		return data[fullAddr & BUS_PAGE_MASK];
+
+	return bus_readDevice(bus, fullAddr);
+}
+
+static inline void bus_write(bus_t* bus, const uint16_t fullAddr, const uint8_t data) {
+	uint8_t* memory = bus->pages[fullAddr >> BUS_PAGE_BITS].write;
+	if (memory) {
+		memory[fullAddr & BUS_PAGE_MASK] = data;
+		return;
+	}
+
+	bus_writeDevice(bus, fullAddr, data);
+}
+
+/// tracks changes to code decoded from the page holding fullAddr
+/// the next write to that page, through bus_write or bus_place, increments the generation of the page
+/// code decoded from a page is stale once the generation of that page changed
+/// memory changed without going through the bus is not noticed
+/// returns the current generation of the page
+uint32_t bus_watchCode(bus_t* bus, const uint16_t fullAddr);
+
+static inline uint32_t bus_codeGeneration(const bus_t* bus, const uint16_t fullAddr) {
+	return bus->codeGenerations[fullAddr >> BUS_PAGE_BITS];
+}
+
+/// asks every device for the memory of its pages again, without invalidating decoded code
+/// needed once the memory handed out by a device moved, or stopped being writable, like after memory_clone
+void bus_remap(bus_t* bus);
+
+/// calls observer after every read and write through the bus, NULL stops observing
+/// while observed, no memory is handed out to the page table, so every access takes the slow path
+/// bus_get and bus_place are not observed
+void bus_setObserver(bus_t* bus, busObserver observer, void* context);
+
+/// watches the addresses in range [begin - end] for the given kind of access, or stops watching them
+/// pages without watched addresses keep their fast path, changing whether a page is watched rebuilds the page table
+/// bus_get and bus_place are not watched
+void bus_setWatch(bus_t* bus, const busWatch_t kind, const uint16_t begin, const uint16_t end, const bool enabled);
+/// func is called for every watched read and write, breakpoints are checked by the cpu itself
+void bus_setWatchFunc(bus_t* bus, busWatchFunc func, void* context);
+
+static inline bool bus_isWatched(const bus_t* bus, const busWatch_t kind, const uint16_t fullAddr) {
+	return bus->watches[kind][fullAddr / 8] & (1 << (fullAddr % 8));
+}
 
-void bus_print();
+void bus_print(const bus_t* bus);
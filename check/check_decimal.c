@@ -0,0 +1,132 @@
+// runs ADC and SBC in decimal mode for every accumulator, operand and carry on every variant
+// and compares the result and flags with the sequences of "Decimal Mode" by Bruce Clark, appendix A
+// the cpu looks the results up in tables, this computes them the way the document does, one instruction at a time
+// build and run from the root of the repository:
+//   cc -O2 -std=gnu11 -I. -o check_decimal check/check_decimal.c $(ls *.c | grep -v main.c) && ./check_decimal
+
+#include "cpu.h"
+#include "memory.h"
+
+#include <stdio.h>
+
+// where the instruction under test is placed
+#define CODE 0x0200
+#define OPCODE_ADC 0x69
+#define OPCODE_SBC 0xE9
+// reported before giving up on a variant
+#define MAX_MISMATCHES 8
+
+static const char* const variantNames[CPU_VARIANT_COUNT] = { "6502", "R65C02", "W65C02" };
+
+struct result {
+	uint8_t A;
+	bool N, V, Z, C;
+};
+
+// sequences 1 and 2 for the 6502, the 65C02 takes N and Z from the result instead
+static struct result adc(const bool cmos, const uint8_t a, const uint8_t b, const bool carry) {
+	int al = (a & 0x0F) + (b & 0x0F) + carry;
+	if (al >= 0x0A)
+		al = ((al + 0x06) & 0x0F) + 0x10;
+
+	int sum = (a & 0xF0) + (b & 0xF0) + al;
+	const int signedSum = (int8_t) (a & 0xF0) + (int8_t) (b & 0xF0) + al;
+	if (sum >= 0xA0)
+		sum += 0x60;
+
+	const uint8_t binary = (uint8_t) (a + b + carry);
+	return (struct result) {
+		.A = (uint8_t) sum,
+		.N = cmos ? (sum & 0x80) != 0 : (signedSum & 0x80) != 0,
+		.V = signedSum < -128 || signedSum > 127,
+		.Z = cmos ? (uint8_t) sum == 0 : binary == 0,
+		.C = sum >= 0x100,
+	};
+}
+
+// sequence 3 for the 6502, 4 for the 65C02, the flags are those of a binary subtraction, except N and Z on the 65C02
+static struct result sbc(const bool cmos, const uint8_t a, const uint8_t b, const bool carry) {
+	const int binary = a - b + carry - 1;
+	const int al = (a & 0x0F) - (b & 0x0F) + carry - 1;
+
+	int difference;
+	if (cmos) {
+		difference = binary;
+		if (difference < 0)
+			difference -= 0x60;
+		if (al < 0)
+			difference -= 0x06;
+	} else {
+		const int low = al < 0 ? ((al - 0x06) & 0x0F) - 0x10 : al;
+		difference = (a & 0xF0) - (b & 0xF0) + low;
+		if (difference < 0)
+			difference -= 0x60;
+	}
+
+	const uint8_t flagSource = cmos ? (uint8_t) difference : (uint8_t) binary;
+	return (struct result) {
+		.A = (uint8_t) difference,
+		.N = (flagSource & 0x80) != 0,
+		.V = ((a ^ b) & (a ^ binary) & 0x80) != 0,
+		.Z = flagSource == 0,
+		.C = binary >= 0,
+	};
+}
+
+// returns the number of mismatches of variant
+static unsigned checkVariant(const cpuVariant_t variant) {
+	bus_t bus;
+	if (!bus_init(&bus))
+		return 1;
+
+	device_t ram = memory_init(0x10000, true);
+	cpu_t cpu;
+	if (!bus_add(&bus, &ram, 0x0000, 0xFFFF) || !cpu_create(&cpu, &bus, variant)) {
+		memory_destroy(ram);
+		bus_destroy(&bus);
+		return 1;
+	}
+
+	const bool cmos = variant != CPU_NMOS6502;
+	unsigned mismatches = 0;
+	for (int subtract = 0; subtract < 2; subtract++)
+		for (int carry = 0; carry < 2; carry++)
+			for (int a = 0; a < 256; a++)
+				for (int b = 0; b < 256; b++) {
+					const uint8_t code[2] = { subtract ? OPCODE_SBC : OPCODE_ADC, (uint8_t) b };
+					memory_set(&ram, CODE, sizeof(code), code);
+
+					cpu.registers.PC = CODE;
+					cpu.registers.A = (uint8_t) a;
+					cpu.registers.flags = (union flags) { .C = carry, .D = true, .I = true };
+					cpu_runInstruction(&cpu);
+
+					const union flags flags = cpu.registers.flags;
+					const struct result expected = subtract ? sbc(cmos, a, b, carry) : adc(cmos, a, b, carry);
+					if (cpu.registers.A == expected.A && flags.N == expected.N && flags.V == expected.V && flags.Z == expected.Z && flags.C == expected.C)
+						continue;
+
+					if (mismatches < MAX_MISMATCHES)
+						printf("%s: %s %02X %02X carry %d gave %02X N%d V%d Z%d C%d, expected %02X N%d V%d Z%d C%d\n",
+							variantNames[variant], subtract ? "sbc" : "adc", a, b, carry,
+							cpu.registers.A, flags.N, flags.V, flags.Z, flags.C,
+							expected.A, expected.N, expected.V, expected.Z, expected.C);
+					mismatches++;
+				}
+
+	cpu_destroy(&cpu);
+	memory_destroy(ram);
+	bus_destroy(&bus);
+	return mismatches;
+}
+
+int main() {
+	unsigned mismatches = 0;
+	for (cpuVariant_t variant = 0; variant < CPU_VARIANT_COUNT; variant++) {
+		const unsigned count = checkVariant(variant);
+		printf("%s: %u of %u mismatched\n", variantNames[variant], count, 2 * 2 * 256 * 256);
+		mismatches += count;
+	}
+
+	return mismatches ? -1 : 0;
+}
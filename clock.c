@@ -1,63 +1,308 @@
+// clock_gettime is POSIX, and hidden by strict C modes without this
+// it has to come first, as the headers below include <time.h> too
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200112L
+#endif
+
 #include "clock.h"
 
 #include "cpu.h"
 
-#include <stdio.h>
-
 #ifdef _WIN32
 #include <windows.h>
 #else
 #include <time.h>
 #endif
 
-#ifdef _WIN32
-LARGE_INTEGER frequency;
+// longest time clock_run waits on a halted cpu at once, before checking on it again
+#ifndef CLOCK_PARK_TIMEOUT_US
+#define CLOCK_PARK_TIMEOUT_US 100000
 #endif
 
-bool clock_running = false;
+// once the machine is this far behind real time, it stops trying to catch up
+// without this, a host that was busy elsewhere would see the machine run a long burst at full speed
+#ifndef CLOCK_MAX_LAG_US
+#define CLOCK_MAX_LAG_US 100000
+#endif
+
+// cycles run between two looks at the time, when unthrottled
+#ifndef CLOCK_UNTHROTTLED_SLICE_CYCLES
+#define CLOCK_UNTHROTTLED_SLICE_CYCLES 100000
+#endif
 
-uint64_t getTime_us() {
+// monotonic wall time, unaffected by changes to the system time
+static uint64_t getTime_ns(void) {
 #ifdef _WIN32
+	LARGE_INTEGER frequency;
 	LARGE_INTEGER counter;
 
+	QueryPerformanceFrequency(&frequency);
 	QueryPerformanceCounter(&counter);
-	return (uint64_t) ((counter.QuadPart * 1000000ULL) / frequency.QuadPart);
+	return (uint64_t) (counter.QuadPart / frequency.QuadPart) * 1000000000ULL +
+		(uint64_t) (counter.QuadPart % frequency.QuadPart) * 1000000000ULL / frequency.QuadPart;
 #else
-	// for now assume clock_t has microsecond precision
-	// wait that is the entire reason i needed to rewrite
-	// (my) windows doesnt have microsecond precision
-	return (uint64_t) clock();
+	struct timespec time;
+	clock_gettime(CLOCK_MONOTONIC, &time);
+	return (uint64_t) time.tv_sec * 1000000000ULL + (uint64_t) time.tv_nsec;
 #endif
 }
 
-void clock_reset() {
-	cpu_reset(true);
-	cpu_clock();
-	cpu_reset(false);
+// time the given amount of cycles takes at frequency, without overflowing for long runs
+static uint64_t cyclesToNs(const uint64_t cycles, const uint64_t frequency) {
+	return (cycles / frequency) * 1000000000ULL + (cycles % frequency) * 1000000000ULL / frequency;
 }
 
-void clock_run(uint64_t targetFrequency) {
-#ifdef _WIN32
-	QueryPerformanceFrequency(&frequency);
-#endif
+static uint64_t nsToCycles(const uint64_t ns, const uint64_t frequency) {
+	return (ns / 1000000000ULL) * frequency + (ns % 1000000000ULL) * frequency / 1000000000ULL;
+}
+
+// state of a single clock_runWith call
+struct run {
+	machine_t* machine;
+	const clockConfig_t* config;
+	clockStats_t* stats;
+
+	uint64_t startTime;
+	uint64_t startCycle;
+	size_t startInstruction;
+	uint64_t busy;
+
+	// totals at the previous sample
+	uint64_t sampleTime;
+	uint64_t sampleCycles;
+	uint64_t sampleInstructions;
+	uint64_t sampleBusy;
+};
+
+static uint64_t cyclesRun(const struct run* run) {
+	return run->machine->cpu.totalCycles - run->startCycle;
+}
+
+static uint64_t instructionsRun(const struct run* run) {
+	return run->machine->cpu.instructionCount - run->startInstruction;
+}
+
+static void sample(struct run* run, const uint64_t now) {
+	const uint64_t cycles = cyclesRun(run);
+	const uint64_t instructions = instructionsRun(run);
+	const uint64_t period = now - run->sampleTime;
+	const uint64_t instructionsInPeriod = instructions - run->sampleInstructions;
+
+	clockStats_t* stats = run->stats;
+	atomic_fetch_add_explicit(&stats->sequence, 1, memory_order_relaxed);
+	atomic_thread_fence(memory_order_release);
+
+	stats->targetFrequency = run->config->targetFrequency;
+	stats->cycles = cycles;
+	stats->instructions = instructions;
+	stats->elapsed_ns = now - run->startTime;
+	stats->busy_ns = run->busy;
+	stats->frequency = period ? (cycles - run->sampleCycles) * 1e9 / period : 0;
+	stats->instructionsPerSecond = period ? instructionsInPeriod * 1e9 / period : 0;
+	stats->nsPerInstruction = instructionsInPeriod ? (double) (run->busy - run->sampleBusy) / instructionsInPeriod : 0;
+
+	atomic_fetch_add_explicit(&stats->sequence, 1, memory_order_release);
+
+	run->sampleTime = now;
+	run->sampleCycles = cycles;
+	run->sampleInstructions = instructions;
+	run->sampleBusy = run->busy;
+}
+
+// runs at most budget cycles, without running past any of the stop conditions
+// returns the stop condition that was reached, or CLOCK_STOPPED if none was
+static clockStop_t runSlice(struct run* run, uint64_t budget) {
+	const clockConfig_t* config = run->config;
+	cpu_t* cpu = &run->machine->cpu;
+
+	if (config->stopCycles) {
+		const uint64_t left = config->stopCycles - cyclesRun(run);
+		if (budget >= left)
+			budget = left;
+	}
+
+	// the cpu runs uninterrupted up to the next event
+	// cycles the last instruction took beyond the previous slice are consumed first, and don't bring the event closer
+	const uint64_t next = scheduler_next(&run->machine->scheduler);
+	if (next != UINT64_MAX) {
+		const uint64_t owed = cpu->cycles > 0 ? (uint64_t) cpu->cycles : 0;
+		const uint64_t left = (next > cpu->totalCycles ? next - cpu->totalCycles : 1) + owed;
+		if (budget > left)
+			budget = left;
+	}
+
+	if (config->stopInstructions && config->stopInstructions - instructionsRun(run) <= budget) {
+		// running budget cycles could pass the instruction limit, every instruction takes at least a cycle
+		cpu_runInstructions(cpu, config->stopInstructions - instructionsRun(run));
+		if (instructionsRun(run) >= config->stopInstructions)
+			return CLOCK_STOP_INSTRUCTIONS;
+	} else
+		cpu_runCycles(cpu, budget);
+
+	if (cpu->breakReason != CPU_BREAK_NONE) {
+		const bool atStopPC = config->stopAtPC && cpu->breakReason == CPU_BREAK_EXECUTE && cpu->breakAddress == config->stopPC;
+		return atStopPC ? CLOCK_STOP_PC : CLOCK_STOP_BREAK;
+	}
+	// an event could still get the cpu out of the trap
+	if (cpu->idle == CPU_IDLE_TRAP && scheduler_next(&run->machine->scheduler) == UINT64_MAX)
+		return CLOCK_STOP_TRAP;
+	if (config->stopCycles && cyclesRun(run) >= config->stopCycles)
+		return CLOCK_STOP_CYCLES;
+	if (config->stopInstructions && instructionsRun(run) >= config->stopInstructions)
+		return CLOCK_STOP_INSTRUCTIONS;
+
+	return CLOCK_STOPPED;
+}
+
+eventId_t clock_schedule(machine_t* machine, const uint64_t cycle, eventFunc func, void* context) {
+	return scheduler_add(&machine->scheduler, cycle, func, context);
+}
 
-	uint64_t prev = getTime_us();
-	uint64_t now = prev;
-	uint64_t diff = 1000000 / targetFrequency;
+eventId_t clock_scheduleIn(machine_t* machine, const uint64_t delay, eventFunc func, void* context) {
+	return scheduler_add(&machine->scheduler, machine->cpu.totalCycles + delay, func, context);
+}
+
+bool clock_cancel(machine_t* machine, const eventId_t id) {
+	return scheduler_cancel(&machine->scheduler, id);
+}
+
+void clock_reset(machine_t* machine) {
+	cpu_reset(&machine->cpu, true);
+	cpu_clock(&machine->cpu);
+	cpu_reset(&machine->cpu, false);
+}
+
+clockStop_t clock_run(machine_t* machine, uint64_t targetFrequency) {
+	const clockConfig_t config = { .targetFrequency = targetFrequency, .slice_us = CLOCK_DEFAULT_SLICE_US };
+	return clock_runWith(machine, &config, NULL);
+}
 
-	printf("diff: %zi\n", diff);
+clockStop_t clock_runWith(machine_t* machine, const clockConfig_t* config, clockStats_t* stats) {
+	const bool throttled = config->targetFrequency != CLOCK_UNTHROTTLED;
+	const uint64_t frequency = config->targetFrequency;
+	const uint64_t slice_us = config->slice_us ? config->slice_us : CLOCK_DEFAULT_SLICE_US;
+	const uint64_t sample_ns = (config->sample_us ? config->sample_us : CLOCK_DEFAULT_SAMPLE_US) * 1000;
 
-	clock_running = true;
-	while (clock_running) {
-		cpu_clock();
+	uint64_t sliceCycles = throttled ? nsToCycles(slice_us * 1000, frequency) : CLOCK_UNTHROTTLED_SLICE_CYCLES;
+	if (sliceCycles == 0)
+		sliceCycles = 1;
 
-		static int clockCounter = 0;
-		if (clockCounter++ % targetFrequency == 0)
-			printf("clock\nnow: %zi, prev: %zi\n", now, prev);
+	const uint64_t start = getTime_ns();
+	struct run run = {
+		.machine = machine, .config = config, .stats = stats,
+		.startTime = start, .startCycle = machine->cpu.totalCycles, .startInstruction = machine->cpu.instructionCount,
+		.sampleTime = start,
+	};
 
-		do {
-			now = getTime_us();
-		} while (now - prev <= diff);
-		prev += diff;
+	// every deadline is computed from base, so rounding errors of single slices don't add up
+	uint64_t base = start;
+	uint64_t baseCycles = 0;
+
+	// stopAtPC is a breakpoint for the length of the run, unless there already is one
+	const bool stopBreakpoint = config->stopAtPC && !cpu_isBreakpoint(&machine->cpu, config->stopPC);
+	if (stopBreakpoint)
+		cpu_setBreakpoint(&machine->cpu, config->stopPC, true);
+
+	clockStop_t stop = CLOCK_STOPPED;
+	machine->running = true;
+	while (machine->running) {
+		// changes posted from other threads are taken between slices, posting one ends the running slice early
+		machine_takeSignals(machine);
+		scheduler_run(&machine->scheduler, machine->cpu.totalCycles);
+		if (!machine->running)
+			break;
+
+		if (cpu_isHalted(&machine->cpu)) {
+			const uint64_t next = scheduler_next(&machine->scheduler);
+
+			if (!throttled && next != UINT64_MAX) {
+				// nothing happens before the next event, and there is no real time to wait for
+				uint64_t due = next - run.startCycle;
+				if (config->stopCycles && due > config->stopCycles)
+					due = config->stopCycles;
+				if (due > cyclesRun(&run))
+					cpu_passCycles(&machine->cpu, due - cyclesRun(&run));
+			} else if (!throttled)
+				// only a control input gets the cpu going again, so wait for one instead of spinning
+				machine_park(machine, CLOCK_PARK_TIMEOUT_US);
+			else {
+				// wait for a control input, or until the next event is due in real time
+				uint64_t timeout_us = CLOCK_PARK_TIMEOUT_US;
+				if (next != UINT64_MAX) {
+					const uint64_t now = getTime_ns();
+					const uint64_t eventTime = next - run.startCycle > baseCycles ? base + cyclesToNs(next - run.startCycle - baseCycles, frequency) : now;
+					if (eventTime <= now)
+						timeout_us = 0;
+					else if ((eventTime - now) / 1000 < timeout_us)
+						timeout_us = (eventTime - now) / 1000;
+				}
+				machine_park(machine, timeout_us);
+
+				// the cycles that passed while waiting
+				uint64_t due = baseCycles + nsToCycles(getTime_ns() - base, frequency);
+				if (next != UINT64_MAX && due < next - run.startCycle && timeout_us == 0)
+					due = next - run.startCycle;
+				if (config->stopCycles && due > config->stopCycles)
+					due = config->stopCycles;
+				if (due > cyclesRun(&run))
+					cpu_passCycles(&machine->cpu, due - cyclesRun(&run));
+			}
+
+			if (config->stopCycles && cyclesRun(&run) >= config->stopCycles) {
+				stop = CLOCK_STOP_CYCLES;
+				break;
+			}
+		} else {
+			const uint64_t sliceStart = getTime_ns();
+			stop = runSlice(&run, sliceCycles);
+			const uint64_t sliceEnd = getTime_ns();
+			run.busy += sliceEnd - sliceStart;
+
+			if (stop != CLOCK_STOPPED)
+				break;
+
+			if (throttled) {
+				const uint64_t deadline = base + cyclesToNs(cyclesRun(&run) - baseCycles, frequency);
+				// a posted change ends the sleep, the slice after it starts early and the next deadline corrects for it
+				if (sliceEnd < deadline)
+					machine_sleep(machine, (deadline - sliceEnd) / 1000);
+				else if (sliceEnd - deadline > CLOCK_MAX_LAG_US * 1000) {
+					base = sliceEnd;
+					baseCycles = cyclesRun(&run);
+				}
+			}
+		}
+
+		if (stats) {
+			const uint64_t now = getTime_ns();
+			if (now - run.sampleTime >= sample_ns)
+				sample(&run, now);
+		}
 	}
+	machine->running = false;
+
+	if (stopBreakpoint)
+		cpu_setBreakpoint(&machine->cpu, config->stopPC, false);
+
+	if (stats)
+		sample(&run, getTime_ns());
+
+	return stop;
+}
+
+void clock_readStats(const clockStats_t* stats, clockStats_t* sample) {
+	unsigned int sequence;
+	do {
+		sequence = atomic_load_explicit(&stats->sequence, memory_order_acquire);
+		sample->targetFrequency = stats->targetFrequency;
+		sample->cycles = stats->cycles;
+		sample->instructions = stats->instructions;
+		sample->elapsed_ns = stats->elapsed_ns;
+		sample->busy_ns = stats->busy_ns;
+		sample->frequency = stats->frequency;
+		sample->instructionsPerSecond = stats->instructionsPerSecond;
+		sample->nsPerInstruction = stats->nsPerInstruction;
+		atomic_thread_fence(memory_order_acquire);
+	} while ((sequence & 1) || sequence != atomic_load_explicit(&stats->sequence, memory_order_relaxed));
+	atomic_store_explicit(&sample->sequence, sequence, memory_order_relaxed);
 }
@@ -1,9 +1,91 @@
 #pragma once
 
+#include "machine.h"
+
+#include <stdatomic.h>
 #include <stdint.h>
 #include <stdbool.h>
 
-extern bool clock_running;
+/// wall time of a single slice, when no other slice length is given
+#ifndef CLOCK_DEFAULT_SLICE_US
+#define CLOCK_DEFAULT_SLICE_US 1000
+#endif
+
+/// time between two samples of clockStats_t, when no other period is given
+#ifndef CLOCK_DEFAULT_SAMPLE_US
+#define CLOCK_DEFAULT_SAMPLE_US 100000
+#endif
+
+/// target frequency which runs the machine as fast as the host allows
+#define CLOCK_UNTHROTTLED 0
+
+/// how clock_runWith runs the machine
+/// the cycles of a slice are run back to back, after which the thread sleeps until the slice should have ended in real time
+/// shorter slices follow real time more closely, longer slices cost less host time
+/// the stop conditions are checked at instruction boundaries, a value of 0 or false disables them
+typedef struct {
+	uint64_t targetFrequency; // in Hz, or CLOCK_UNTHROTTLED
+	uint64_t slice_us; // 0 picks CLOCK_DEFAULT_SLICE_US, unused when unthrottled
+	uint64_t sample_us; // 0 picks CLOCK_DEFAULT_SAMPLE_US
+
+	uint64_t stopCycles; // counted from the start of clock_runWith
+	uint64_t stopInstructions; // counted from the start of clock_runWith
+	bool stopAtPC; // stops before running the instruction at stopPC, with a breakpoint there for the length of the run
+	uint16_t stopPC;
+} clockConfig_t;
+
+/// the reason clock_runWith returned
+typedef enum {
+	CLOCK_STOPPED, // machine->running was cleared
+	CLOCK_STOP_CYCLES,
+	CLOCK_STOP_INSTRUCTIONS,
+	CLOCK_STOP_PC,
+	CLOCK_STOP_TRAP, // the cpu is trapped in a jump or branch to its own address, and no event could get it out
+	CLOCK_STOP_BREAK, // the cpu hit a breakpoint or watchpoint, cpu.breakReason and cpu.breakAddress tell which
+} clockStop_t;
+
+/// measured by clock_runWith, sampled every sample_us and once more before it returns
+/// sequence is odd while a sample is being written, read the stats with clock_readStats from other threads
+typedef struct {
+	atomic_uint sequence;
+
+	uint64_t targetFrequency;
+	// totals since the start of clock_runWith
+	uint64_t cycles;
+	uint64_t instructions;
+	uint64_t elapsed_ns;
+	// time spent running the cpu, the rest of elapsed_ns was spent sleeping
+	uint64_t busy_ns;
+
+	// rates over the last sample period
+	double frequency; // emulated cycles per second
+	double instructionsPerSecond;
+	double nsPerInstruction; // host time spent running the cpu per emulated instruction
+} clockStats_t;
+
+/// schedules func to be called once the cpu of machine reached the absolute cycle, as counted by cpu.totalCycles
+/// clock_runWith runs the cpu uninterrupted up to the next event, and calls it at the first instruction boundary from there
+/// a halted cpu skips ahead to the next event, unthrottled, or waits for it in real time
+/// returns 0 if the event could not be scheduled
+eventId_t clock_schedule(machine_t* machine, const uint64_t cycle, eventFunc func, void* context);
+/// schedules func delay cycles after the current cycle of the cpu
+eventId_t clock_scheduleIn(machine_t* machine, const uint64_t delay, eventFunc func, void* context);
+/// returns false if the event already ran or was canceled
+bool clock_cancel(machine_t* machine, const eventId_t id);
+
+void clock_reset(machine_t* machine);
+
+/// runs machine at targetFrequency until machine->running is cleared, with slices of CLOCK_DEFAULT_SLICE_US
+/// control input changes posted with machine_postIrq and friends end the running slice, and are applied right after it
+/// while the cpu is halted by WAI or STP, the thread sleeps until a control input changes, see machine_park
+/// also returns once the cpu is trapped in a jump or branch to its own address with no event scheduled, cpu.idleAddress tells where
+/// and once the cpu hits a breakpoint or watchpoint, calling clock_run again continues from there
+clockStop_t clock_run(machine_t* machine, uint64_t targetFrequency);
+
+/// same as clock_run, with the pacing and stop conditions given by config
+/// unthrottled, a halted cpu still makes the thread sleep until a control input changes, no cycles pass meanwhile
+/// stats can be NULL
+clockStop_t clock_runWith(machine_t* machine, const clockConfig_t* config, clockStats_t* stats);
 
-void clock_reset();
-void clock_run(uint64_t targetFrequency);
\ No newline at end of file
+/// copies a consistent sample of stats, which can be written by clock_runWith on another thread
+void clock_readStats(const clockStats_t* stats, clockStats_t* sample);
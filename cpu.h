@@ -1,12 +1,238 @@
 #pragma once
 
+#include "bus.h"
+
+#include <stdatomic.h>
 #include <stdbool.h>
+#include <stddef.h>
+
+union flags {
+	struct {
+		bool C : 1; // carry
+		bool Z : 1; // zero
+		bool I : 1; // interrupt disabled
+		bool D : 1; // binary coded decimal (BDC)
+		bool B : 1; // break
+		bool _ : 1; // unused
+		bool V : 1; // overflow
+		bool N : 1; // negative
+	};
+	uint8_t byte;
+};
+
+struct regs { // struct name purely for debug purposes
+	union {
+		struct {
+			uint8_t PC_LO;
+			uint8_t PC_HI;
+		};
+		uint16_t PC; // program counter
+	};
+	uint8_t A; // accumulator
+	uint8_t X;
+	uint8_t Y;
+	union flags flags;
+	uint8_t SP; // stack pointer
+};
+
+// state of the control inputs
+// irq is set while any source pulls the irq line
+struct signalState {
+	bool irq		: 1;
+	bool reset		: 1;
+	bool nmi		: 1;
+	// only used on western design center chips
+	bool WAI		: 1;
+	bool STP		: 1;
+};
+
+/// the chips that can be emulated, every variant is compiled into its own specialized core
+typedef enum {
+	CPU_NMOS6502, // the original 6502, illegal opcodes are not implemented
+	CPU_R65C02, // rockwell 65C02, adds the bit manipulation and bit branch instructions
+	CPU_W65C02, // western design center 65C02, adds WAI and STP, and turns illegal opcodes into nops
+
+	CPU_VARIANT_COUNT
+} cpuVariant_t;
+
+/// the variant created by cpu_init
+/// defining WDC or ROCKWEL still picks those chips, like when only one variant was built
+#if defined(WDC)
+#define CPU_DEFAULT_VARIANT CPU_W65C02
+#elif defined(ROCKWEL)
+#define CPU_DEFAULT_VARIANT CPU_R65C02
+#else
+#define CPU_DEFAULT_VARIANT CPU_NMOS6502
+#endif
+
+/// loops the cpu can't leave without a control input, see cpu_runCycles
+typedef enum {
+	CPU_IDLE_NONE,
+	CPU_IDLE_TRAP, // a jump or branch to its own address
+	CPU_IDLE_POLL, // a loop only reading memory, in which a whole iteration didn't change a register
+} cpuIdle_t;
+
+/// why the cpu stopped at an instruction boundary before its budget ran out, see cpu_setBreakpoint
+typedef enum {
+	CPU_BREAK_NONE,
+	CPU_BREAK_EXECUTE, // PC reached a breakpoint, the instruction there didn't run yet
+	CPU_BREAK_READ, // the last instruction read a watched address
+	CPU_BREAK_WRITE, // the last instruction wrote a watched address
+} cpuBreak_t;
+
+// N, Z, C and V as the instructions leave them, only used inside cpu_core.h
+// they are only turned back into the flags register when it is observed
+struct lazyFlags {
+	uint8_t negative; // N is bit 7
+	uint8_t zero; // Z is set if this is 0
+	uint8_t overflow; // V is bit 7
+	bool carry;
+};
+
+// entry points of the variant, see cpu_variant.h
+struct cpuCore;
+// decoded instructions, only used inside cpu_core.h
+struct blockCache;
+// executable memory for translated blocks
+struct jit;
+// a trace file being recorded
+struct trace;
+// counts of the instructions run
+struct profile;
+// events due at cycles of the cpu
+struct scheduler;
+
+/// a single 6502, connected to a bus
+/// multiple cpus can exist independently of each other, as long as every cpu is only used by a single thread at a time
+typedef struct cpu {
+	struct regs registers;
+	struct signalState signals;
+	// every bit is a device pulling the irq line
+	uint32_t irqSources;
+	// control inputs that need to be handled before the next instruction, and whether the cpu is halted
+	// kept up to date by the control inputs and the instructions changing the interrupt flag
+	uint8_t pendingControl;
+	// set by cpu_requestStop, from any thread
+	atomic_bool stopRequested;
+	// N, Z, C and V of registers.flags are only valid outside of the cpu functions
+	// while instructions run, these flags are kept here instead
+	struct lazyFlags lazyFlags;
+
+	int8_t cycles;
+	uint64_t totalCycles;
+	size_t instructionCount;
+
+	bool ranUnimplementedInstruction;
+
+	// the loop the cpu was last found spinning in, and the address it starts at
+	cpuIdle_t idle;
+	uint16_t idleAddress;
+	// cycles that passed in idle loops or on a halted cpu without running them
+	uint64_t skippedCycles;
+
+	// the breakpoint or watchpoint the cpu last stopped at, cleared by the next call into the cpu
+	cpuBreak_t breakReason;
+	uint16_t breakAddress;
+	// set while continuing from a breakpoint, so the instruction at it runs
+	bool skipBreakpoint;
+
+	bus_t* bus;
+
+	cpuVariant_t variant;
+	const struct cpuCore* core;
+
+	// NULL if every instruction is fetched and decoded when it runs
+	struct blockCache* blockCache;
+	// lookups in the block cache, a miss means the block had to be decoded
+	uint64_t blockHits;
+	uint64_t blockMisses;
+
+	// NULL if blocks are never translated to native code
+	struct jit* jit;
+	// blocks translated to native code
+	uint64_t translatedBlocks;
+	// translated code continues straight into the next translated block while totalCycles is below this
+	// lowered to 0 by cpu_requestStop, from any thread
+	_Atomic uint64_t jitDeadline;
 
-/// emulates pins from 6502, need to be high for at least one clock pulse to be detected
-/// see cpu_clock for more info
-void cpu_irq(const bool active);
-void cpu_reset(const bool active);
-void cpu_nmi(const bool active);
+	// NULL if the instructions are not traced
+	struct trace* trace;
+	// NULL if the instructions are not profiled
+	struct profile* profile;
+	// NULL if no events are scheduled for the cpu, idle loops are never skipped past the next event of it
+	const struct scheduler* scheduler;
+} cpu_t;
+
+/// prepares cpu to run on bus as the given variant
+/// the bus is not owned by the cpu, and should outlive it
+/// cpus of different variants can be used side by side
+bool cpu_create(cpu_t* cpu, bus_t* bus, const cpuVariant_t variant);
+/// creates a cpu of CPU_DEFAULT_VARIANT
+bool cpu_init(cpu_t* cpu, bus_t* bus);
+bool cpu_destroy(cpu_t* cpu);
+
+/// enables or disables the decoded block cache, which is disabled by default
+/// with the cache, straight line code is decoded once into a block that ends with the next branch, jump, return or break
+/// running a block skips fetching and decoding its instructions, control inputs are still checked before every instruction
+/// only code in memory handed to the bus by a memoryFunc is decoded, other code is run without the cache
+/// a block becomes stale as soon as its page is written through the bus, even by the block itself
+/// a stale block is compared with memory before it runs again, and only decoded again if its code changed
+/// on its own the cache is slower than the interpreter, bench/bench_cpu.c runs at about 0.85 times its speed
+/// it exists as the front end of the jit, which translates its blocks, enabling it without the jit rarely pays off
+/// memory changed without going through the bus (memory_set, memory_loadFile) requires a call to cpu_flushBlockCache
+/// returns false if the cache could not be allocated
+bool cpu_setBlockCache(cpu_t* cpu, const bool enabled);
+void cpu_flushBlockCache(cpu_t* cpu);
+
+/// switches between the interpreter and the jit, which is disabled by default
+/// the jit translates blocks that ran often enough to native code, enabling the block cache along the way
+/// translated code behaves like the interpreter, instructions it can't translate are left to the interpreter
+/// translated blocks continue straight into each other, until a stop condition or control input needs the interpreter
+/// bench/bench_cpu.c runs about 1.5 times as fast with the jit as with the interpreter
+/// disabling the jit keeps the block cache enabled, and can be done between any two calls into the cpu
+/// the memory translated code is written to is never writable and executable at once
+/// returns false if the jit is not available for this platform, the host refuses to make written memory executable,
+/// or the memory for it could not be allocated, in which case the block cache is left as it was
+bool cpu_setJit(cpu_t* cpu, const bool enabled);
+
+/// records every instruction the cpu runs in trace, with its registers and bus accesses, NULL stops tracing
+/// traced instructions are always interpreted, and the bus of the cpu is observed, so every access takes the slow path
+/// without a trace, tracing costs nothing
+void cpu_setTrace(cpu_t* cpu, struct trace* trace);
+
+/// counts every instruction the cpu runs in profile, NULL stops profiling
+/// profiled instructions are always interpreted, a traced cpu is not profiled
+/// cycles skipped in idle loops or while halted are not counted
+void cpu_setProfile(cpu_t* cpu, struct profile* profile);
+
+/// lets the cpu see the events due in scheduler, NULL if there are none
+/// a skipped idle loop stops at the next event, which could change what the loop reads, machine_create sets this up
+void cpu_setScheduler(cpu_t* cpu, const struct scheduler* scheduler);
+
+/// stops the cpu before it runs the instruction at address, as long as the breakpoint is set
+/// the run function that hit it returns early with breakReason and breakAddress set, the next call continues with that instruction
+/// breakpoints live in the bus, pages without one run at full speed, with or without the block cache and jit
+void cpu_setBreakpoint(cpu_t* cpu, const uint16_t address, const bool enabled);
+bool cpu_isBreakpoint(const cpu_t* cpu, const uint16_t address);
+/// stops the cpu after an instruction reading (CPU_BREAK_READ) or writing (CPU_BREAK_WRITE) an address in [begin - end]
+/// only accesses through bus_read and bus_write are watched, the watched pages take the slow path for that access
+void cpu_setWatchpoint(cpu_t* cpu, const cpuBreak_t kind, const uint16_t begin, const uint16_t end, const bool enabled);
+
+/// emulates pins from 6502, see cpu_clock for more info
+/// reset is handled as long as it is active, a single nmi is handled every time the line becomes active
+/// irq is handled as long as it is active, and the interrupt flag is clear
+/// cpu_irq drives the irq line as CPU_IRQ_DEFAULT_SOURCE
+/// these should only be called from the thread running the cpu, other threads post their changes through machine_postIrq and friends
+void cpu_irq(cpu_t* cpu, const bool active);
+void cpu_reset(cpu_t* cpu, const bool active);
+void cpu_nmi(cpu_t* cpu, const bool active);
+
+/// the irq line is shared by all devices, it is active as long as any source asserts it
+/// every device driving the line should use its own source, below CPU_IRQ_SOURCES
+#define CPU_IRQ_SOURCES 32
+#define CPU_IRQ_DEFAULT_SOURCE 0
+void cpu_assertIrq(cpu_t* cpu, const uint8_t source);
+void cpu_deassertIrq(cpu_t* cpu, const uint8_t source);
 
 /// performs a single clock cycle
 /// internally cycles are consumed if there are cycles left to consume
@@ -16,7 +242,7 @@ void cpu_nmi(const bool active);
 /// setting the amount of cycles to consume
 /// on western design center chips there are ways to halt the processor
 /// if the chip is halted, cpu_clock checks if it can continue, based on the state of the control inputs
-void cpu_clock();
+void cpu_clock(cpu_t* cpu);
 
 /// performs a single instruction
 /// first makes sure no more cycles are needed to be consumed
@@ -24,7 +250,77 @@ void cpu_clock();
 /// a call to cpu_clock after cpu_runInstruction will instantly perform the next instructions
 /// on western design center chips there are ways to halt the processor
 /// if the chip is halted, cpu_runInstruction checks if it can continue, and performs one instruction if so. else it will do nothing
-void cpu_runInstruction();
+void cpu_runInstruction(cpu_t* cpu);
+
+/// true if the cpu is halted by WAI or STP, and the control inputs don't let it continue yet
+/// a halted cpu doesn't do anything until cpu_irq, cpu_nmi or cpu_reset changes that
+bool cpu_isHalted(const cpu_t* cpu);
+
+/// lets cycles pass without running any instruction, as if the cpu was halted all that time
+/// used for the time a thread waited on a halted cpu, the cycles are counted in skippedCycles
+void cpu_passCycles(cpu_t* cpu, const uint64_t cycles);
+
+/// runs the cpu for budget cycles, executing whole instructions back to back
+/// control inputs are checked before every instruction, so interrupts are taken at instruction boundaries
+/// if the last instruction takes more cycles than were left in budget, the excess is consumed at the start of the next call
+/// a halted cpu lets the remaining cycles pass, unless a control input wakes it up
+/// a cpu spinning in a loop it can't leave on its own skips ahead to the end of the budget, as if it ran the loop
+/// these loops are jumps and branches to their own address, and with the block cache also short loops only reading memory
+/// skipping stops at the next event of the scheduler of the cpu, see cpu_setScheduler
+/// memory the host writes while a loop is being skipped, from another thread or a device function, is not seen by the skipped iterations
+/// idle and idleAddress tell which loop was found, they are cleared by every call to cpu_runCycles and cpu_runInstructions
+/// a breakpoint or watchpoint stops the cpu early, see cpu_setBreakpoint, and so does cpu_requestStop
+/// returns the amount of cycles consumed
+uint64_t cpu_runCycles(cpu_t* cpu, uint64_t budget);
+
+/// runs count instructions back to back, with control inputs checked before every instruction
+/// cycles left over from earlier calls are consumed first, the cycles of the last instruction are consumed immediately
+/// stops early if the cpu gets halted, hits a breakpoint or watchpoint, or a stop was requested
+/// idle loops are skipped like in cpu_runCycles, as far as count allows
+/// returns the amount of cycles consumed
+uint64_t cpu_runInstructions(cpu_t* cpu, uint64_t count);
+
+/// makes cpu_runCycles or cpu_runInstructions return at the next instruction boundary, leaving the rest of their budget
+/// the only cpu function that can be called from another thread while the cpu runs
+/// the request is used up by the call it stopped, or by the next one if none was running
+void cpu_requestStop(cpu_t* cpu);
+
+/// what a cpu needs to continue from where it was, see cpu_saveState
+/// the variant, and the block cache, jit, trace, profile and scheduler are not part of it
+typedef struct {
+	struct regs registers;
+	struct signalState signals;
+	uint32_t irqSources;
+	uint8_t pendingControl;
+
+	int8_t cycles;
+	uint64_t totalCycles;
+	size_t instructionCount;
+
+	// a cpu saved at a breakpoint continues from it
+	cpuBreak_t breakReason;
+	uint16_t breakAddress;
+	bool skipBreakpoint;
+} cpuState_t;
+
+/// should only be called between calls into the cpu, where the flags in registers are valid
+void cpu_saveState(const cpu_t* cpu, cpuState_t* state);
+/// continues from state, which can come from a cpu of another variant
+/// the decoded blocks are kept, they have to be flushed if memory changed without going through the bus
+void cpu_loadState(cpu_t* cpu, const cpuState_t* state);
+
+/// what an opcode does on a variant
+/// the names are those of cpu_printOpcode with VERBOSE, cycles doesn't include page crossings and taken branches
+typedef struct {
+	const char* instruction;
+	const char* addressMode;
+	uint8_t cycles;
+} cpuOpcodeInfo_t;
+
+cpuOpcodeInfo_t cpu_opcodeInfo(const cpuVariant_t variant, const uint8_t opcode);
 
-void cpu_printRegisters();
-void cpu_printOpcode();
+void cpu_printRegisters(const cpu_t* cpu);
+void cpu_printOpcode(const cpu_t* cpu);
+/// prints an instruction of the given variant like cpu_printOpcode, without a cpu
+/// data holds the opcode and the 2 bytes following it
+void cpu_printInstruction(const cpuVariant_t variant, const uint16_t pc, const uint8_t* data);
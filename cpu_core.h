@@ -0,0 +1,3538 @@
+// the implementation of a single cpu variant, included once by every variant
+// the variant is picked with WDC and ROCKWEL before including this file
+// everything in here is static, except the struct cpuCore named by CPU_CORE, which cpu.c uses to run the variant
+#pragma once
+
+#include "cpu.h"
+#include "cpu_variant.h"
+
+#include "bus.h"
+#include "jit.h"
+#include "profile.h"
+#include "scheduler.h"
+#include "trace.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <threads.h>
+
+#ifndef CPU_CORE
+#error "define CPU_CORE before including cpu_core.h"
+#endif
+
+// #define VERBOSE
+
+#ifdef WDC
+// Western Design Center included the bit branch/bit set instructions from the rockwel chips
+#define ROCKWEL
+#endif
+
+#ifdef ROCKWEL
+// account for bit number in some newer instructions
+#define INSTRUCTION_NAME_LENGTH 4
+#else
+#define INSTRUCTION_NAME_LENGTH 3
+#endif // ROCKWEL
+
+// addressing modes
+enum {
+#ifndef WDC
+	// addressing mode for illegal opcode
+	//   the WDC version of the 6502 has all illegal opcodes implemented as nops
+	AM_XXX,
+#endif
+
+#ifdef WDC
+	AM_ABS, AM_ABSI, AM_ABSX, AM_ABSY,
+#else
+	AM_ABS, AM_ABSX, AM_ABSY,
+#endif
+	// accumulator addressing mode, same behaviour as implied, making the accumulator as the operator
+	// this mode is however officially documented as a seperate addressing mode
+	// the actual logic in this emulator will be done with implied
+	AM_ACC,
+	AM_IMM,
+	AM_IMP,
+	AM_IND, AM_INDX, AM_INDY,
+	AM_REL,
+#ifdef WDC
+	// stack addressing mode, same behaviour as implied, making the stack pointer as the operator
+	// this mode is however officially documented as a seperate addressing mode
+	// the actual logic in this emulator will be done with implied
+	AM_STK,
+#endif
+#ifdef WDC
+	AM_ZPG, AM_ZPGI, AM_ZPGX, AM_ZPGY,
+#else
+	AM_ZPG, AM_ZPGX, AM_ZPGY,
+#endif
+
+	ADDRESS_MODE_COUNT
+};
+
+// instructions
+enum {
+#ifndef WDC
+	// instruction for illegal opcode
+	//   the WDC version of the 6502 has all illegal opcodes implemented as nops
+	IN_XXX,
+#endif
+
+	IN_NOP,
+	// alu
+	IN_ADC, IN_SBC,
+	IN_INC, IN_INX, IN_INY,
+	IN_DEC, IN_DEX, IN_DEY,
+	IN_AND, IN_EOR, IN_ORA,
+	IN_ASL, IN_LSR, IN_ROL, IN_ROR,
+	// PC altering
+#ifdef ROCKWEL
+	IN_BBR0, IN_BBR1, IN_BBR2, IN_BBR3, IN_BBR4, IN_BBR5, IN_BBR6, IN_BBR7,
+	IN_BBS0, IN_BBS1, IN_BBS2, IN_BBS3, IN_BBS4, IN_BBS5, IN_BBS6, IN_BBS7,
+#endif
+	IN_BCC, IN_BNE, IN_BMI, IN_BVC,
+	IN_BCS, IN_BEQ, IN_BPL, IN_BVS,
+#ifdef WDC
+	IN_BRA,
+#endif
+	IN_BRK, IN_JSR, IN_JMP,
+	IN_RTI, IN_RTS,
+	// flags altering
+	IN_BIT, IN_CMP, IN_CPX, IN_CPY,
+	IN_CLC, IN_CLD, IN_CLI, IN_CLV,
+	IN_SEC, IN_SED, IN_SEI,
+	// load
+	IN_LDA, IN_LDX, IN_LDY,
+	IN_TAX, IN_TAY, IN_TSX,
+	IN_TXA, IN_TYA, IN_TXS,
+#ifdef WDC
+	IN_PLA, IN_PLX, IN_PLY, IN_PLP,
+	IN_TRB, IN_TSB,
+#else
+	IN_PLA, IN_PLP,
+#endif
+	// store
+	IN_STA, IN_STX, IN_STY,
+#ifdef ROCKWEL
+	IN_RMB0, IN_RMB1, IN_RMB2, IN_RMB3, IN_RMB4, IN_RMB5, IN_RMB6, IN_RMB7,
+	IN_SMB0, IN_SMB1, IN_SMB2, IN_SMB3, IN_SMB4, IN_SMB5, IN_SMB6, IN_SMB7,
+#endif
+#ifdef WDC
+	IN_PHA, IN_PHX, IN_PHY, IN_PHP,
+	IN_STZ,
+#else
+	IN_PHA, IN_PHP,
+#endif
+	// processor halting
+#ifdef WDC
+	IN_STP, IN_WAI,
+#endif
+
+	INSTRUCTION_COUNT
+};
+
+struct opcode {
+	const uint8_t instruction;
+	const uint8_t addressMode;
+	const uint8_t cycleCount;
+};
+
+static struct opcode opcodes[256];
+
+// names of the addressing modes and instructions, used for printing and profiles
+struct addressMode {
+	const char name[5];
+};
+
+struct instruction {
+	const char name[INSTRUCTION_NAME_LENGTH + 1];
+};
+
+static struct addressMode addressModes[ADDRESS_MODE_COUNT];
+static struct instruction instructions[INSTRUCTION_COUNT];
+
+// state of the instruction currently executing
+// every opcode handler keeps this as a local, with opcode, instruction, addressMode and decoded being constants
+// this allows the compiler to specialize the addressing mode and instruction for every opcode
+// and keep operand and effectiveAddress in registers
+// decoded instructions read their operand bytes from operands instead of the bus
+struct operation {
+	const uint8_t opcode;
+	const uint8_t instruction;
+	const uint8_t addressMode;
+	const bool decoded;
+	const uint8_t* operands;
+	uint8_t operand;
+	uint16_t effectiveAddress;
+};
+
+// the longest block that is decoded, in instructions
+#define BLOCK_MAX_LENGTH 16
+// the most cycles a block can take
+// no instruction takes more than 8 cycles, including a page crossing or a taken branch
+#define BLOCK_MAX_CYCLES (BLOCK_MAX_LENGTH * 8)
+
+// amount of blocks kept in the cache, must be a power of 2
+#ifndef BLOCK_CACHE_SIZE
+#define BLOCK_CACHE_SIZE 1024
+#endif
+
+// a block gets translated after running this often
+#ifndef JIT_THRESHOLD
+#define JIT_THRESHOLD 32
+#endif
+
+// size of the executable memory of every cpu, all translations are dropped when it is full
+#ifndef JIT_BUFFER_SIZE
+#define JIT_BUFFER_SIZE (1 << 20)
+#endif
+
+// a single decoded instruction
+// operands holds the bytes following the opcode, as far as the instruction uses them
+struct microOp {
+	uint8_t opcode;
+	uint8_t operands[2];
+};
+
+// straight line code starting at start, ending after the first instruction which can change the flow of the program
+// a block never crosses a page boundary, so it only depends on the generation of a single page
+// once a block ran often enough it gets translated, code then runs its first codeLength instructions
+// codeCycles is the most cycles those instructions can take
+// chain is where other translated code enters it, with the registers already in place
+// polls is set if the block is a loop back to its own start that only reads memory, those are never translated
+struct block {
+	uint16_t start;
+	uint8_t length;
+	uint32_t generation;
+	bool polls;
+
+	uint16_t executions;
+	bool translated;
+	uint8_t codeLength;
+	uint16_t codeCycles;
+	void (*code)(cpu_t* cpu);
+	void* chain;
+
+	struct microOp ops[BLOCK_MAX_LENGTH];
+};
+
+// blocks are direct mapped on their start address
+// a block with length 0 is empty
+struct blockCache {
+	struct block blocks[BLOCK_CACHE_SIZE];
+};
+
+#ifdef VERBOSE
+#define NO_IMPL() printf("instruction %-*s is not implemented\n", INSTRUCTION_NAME_LENGTH, instructions[op->instruction].name); cpu->ranUnimplementedInstruction = true
+#else
+#define NO_IMPL() printf("instruction %s is not implemented\n", __func__); cpu->ranUnimplementedInstruction = true
+#endif
+
+#define PUSH(data) bus_write(cpu->bus, 0x0100 | cpu->registers.SP--, (data))
+#define PULL() bus_read(cpu->bus, 0x0100 | ++cpu->registers.SP)
+
+#define BRANCH(condition) if (condition) {cpu->cycles++; if (SELF_BRANCH()) TRAP(); cpu->registers.PC = op->effectiveAddress;} else cpu->cycles = cpu->cycles // allow semicolon after macro call
+
+// a jump or branch to its own address can only be left through a control input
+// execute skips ahead once it sees one
+#define TRAP() cpu->pendingControl |= PENDING_IDLE
+#ifdef ROCKWEL
+// the bit branches read memory, their loops are left to the polling loop detection of the block cache
+#define SELF_BRANCH() ((op->opcode & 0x0F) != 0x0F && op->effectiveAddress == (uint16_t) (cpu->registers.PC - 2))
+#else
+#define SELF_BRANCH() (op->effectiveAddress == (uint16_t) (cpu->registers.PC - 2))
+#endif
+
+// N and Z are derived from data once the flags register is observed
+#define SET_FLAGS(data) cpu->lazyFlags.zero = cpu->lazyFlags.negative = (data)
+
+// in the original 6502, a read-modify-write instruction writes the original value back, before modifying it and storing it again
+// this would cause write sensitive hardware to response twice
+// later versions 'fixed' this by reading twice
+#ifndef ROCKWEL
+#define RMW() if (op->addressMode != AM_ACC) bus_write(cpu->bus, op->effectiveAddress, op->operand)
+#else
+#define RMW() if (op->addressMode != AM_ACC) bus_read(cpu->bus, op->effectiveAddress)
+#endif
+
+// the addressing modes and instructions are inlined into every opcode handler
+// forcing this makes sure the checks on the constant parts of struct operation are removed
+#if defined(_MSC_VER)
+#define FORCE_INLINE __forceinline
+#elif defined(__GNUC__)
+#define FORCE_INLINE inline __attribute__((always_inline))
+#else
+#define FORCE_INLINE inline
+#endif
+
+// every addressing mode and instruction takes the cpu and the operation, so the opcode handlers can call them all alike
+// which of the two one of them actually uses depends on the variant, so neither is reported as unused
+#if defined(__GNUC__)
+#define MAYBE_UNUSED __attribute__((unused))
+#else
+#define MAYBE_UNUSED
+#endif
+#define OPERATION_PARAMETERS MAYBE_UNUSED cpu_t* cpu, MAYBE_UNUSED struct operation* op
+
+// reads the next byte of the current instruction, and moves PC past it
+// the slow path of fetchOpcode, for pages without memory and pages holding a breakpoint
+static bool fetchOpcodeSlow(cpu_t* cpu, uint8_t* opcode) {
+	const uint16_t pc = cpu->registers.PC;
+	if (bus_isWatched(cpu->bus, BUS_WATCH_EXECUTE, pc)) {
+		if (cpu->skipBreakpoint && pc == cpu->breakAddress)
+			cpu->skipBreakpoint = false;
+		else {
+			cpu_break(cpu, CPU_BREAK_EXECUTE, pc);
+			return false;
+		}
+	}
+
+	*opcode = bus_read(cpu->bus, cpu->registers.PC++);
+	return true;
+}
+
+// reads the opcode at PC, and moves PC past it
+// returns false without doing so if the cpu stops at a breakpoint on PC
+// only pages holding a breakpoint have to check for one
+static FORCE_INLINE bool fetchOpcode(cpu_t* cpu, uint8_t* opcode) {
+	const uint8_t* code = cpu->bus->pages[cpu->registers.PC >> BUS_PAGE_BITS].fetch;
+	if (code) {
+		*opcode = code[cpu->registers.PC++ & BUS_PAGE_MASK];
+		return true;
+	}
+
+	return fetchOpcodeSlow(cpu, opcode);
+}
+
+static FORCE_INLINE uint8_t fetchOperand(cpu_t* cpu, struct operation* op) {
+	if (op->decoded) {
+		cpu->registers.PC++;
+		return *op->operands++;
+	}
+
+	return bus_read(cpu->bus, cpu->registers.PC++);
+}
+
+#ifdef WDC
+// the reserved opcodes of the WDC chips are nops, some of which skip over operand bytes
+static FORCE_INLINE uint8_t nopOperandBytes(const uint8_t opcode) {
+	switch (opcode) {
+	case 0x02: case 0x22: case 0x42: case 0x62: case 0x82: case 0xC2: case 0xE2:	// 2 cycles
+	case 0x44:																		// 3 cycles
+	case 0x54: case 0xD4: case 0xF4:												// 4 cycles
+		return 1;
+	case 0xDC: case 0xFC:															// 4 cycles
+	case 0x5C:																		// 8 cycles
+		return 2;
+	default:
+		return 0;
+	}
+}
+#endif
+
+// the flags register with N, Z, C and V taken from lazyFlags
+static FORCE_INLINE uint8_t packFlags(const cpu_t* cpu) {
+	return (cpu->registers.flags.byte & 0x3C) |
+		(cpu->lazyFlags.negative & 0x80) |
+		((cpu->lazyFlags.overflow & 0x80) >> 1) |
+		((cpu->lazyFlags.zero == 0) << 1) |
+		cpu->lazyFlags.carry;
+}
+
+// sets the flags register, including lazyFlags
+static FORCE_INLINE void unpackFlags(cpu_t* cpu, const uint8_t byte) {
+	cpu->registers.flags.byte = byte;
+	cpu->lazyFlags = (struct lazyFlags) {
+		.negative = byte & 0x80,
+		.zero = !(byte & 0x02),
+		.overflow = byte << 1,
+		.carry = byte & 0x01,
+	};
+}
+
+// binary addition of operand to the accumulator, SBC adds the inverted operand
+static FORCE_INLINE void add(cpu_t* cpu, struct operation* op) {
+	uint16_t tmp = cpu->registers.A + op->operand + cpu->lazyFlags.carry;
+
+	// overflow when both inputs have a different sign than the result
+	cpu->lazyFlags.overflow = (cpu->registers.A ^ tmp) & (op->operand ^ tmp);
+
+	cpu->lazyFlags.carry = tmp > 0xFF;
+	cpu->registers.A = tmp & 0xFF;
+
+	SET_FLAGS(cpu->registers.A);
+}
+
+// results of ADC and SBC in decimal mode, indexed by [subtract][carry][accumulator][operand]
+// the low byte of an entry is the result, the high byte holds N, V, Z and C laid out like the flags register
+// generated by generateDecimalTables, before the first cpu is initialized
+// cpus can be created on several threads at once, so only the first one to get there generates them
+static uint16_t decimalTables[2][2][256][256];
+static once_flag decimalTablesOnce = ONCE_FLAG_INIT;
+
+// follows "Decimal Mode" by Bruce Clark, which describes what the chips do for all inputs, even invalid bcd
+// the nmos 6502 sets N and V from the intermediate result before the upper nibble is adjusted, and Z from the binary sum
+// the 65C02 sets N and Z from the result, its V is the same as on the nmos 6502
+static uint16_t decimalAdd(const uint8_t a, const uint8_t b, const bool carry) {
+	int low = (a & 0x0F) + (b & 0x0F) + carry;
+	if (low >= 0x0A)
+		low = ((low + 0x06) & 0x0F) + 0x10;
+
+	int sum = (a & 0xF0) + (b & 0xF0) + low;
+	// the same sum with both high nibbles as signed values
+	const int signedSum = (int8_t) (a & 0xF0) + (int8_t) (b & 0xF0) + low;
+	const bool overflow = signedSum < -128 || signedSum > 127;
+	const uint8_t negative = signedSum & 0x80;
+
+	if (sum >= 0xA0)
+		sum += 0x60;
+
+	const uint8_t result = sum & 0xFF;
+	uint8_t flags = (sum >= 0x100 ? 0x01 : 0x00) | (overflow ? 0x40 : 0x00);
+#ifndef ROCKWEL
+	flags |= negative;
+	flags |= ((a + b + carry) & 0xFF) == 0 ? 0x02 : 0x00;
+#else
+	(void) negative;
+	flags |= result & 0x80;
+	flags |= result == 0 ? 0x02 : 0x00;
+#endif
+
+	return result | (flags << 8);
+}
+
+// the nmos 6502 sets all flags like a binary subtraction
+// the 65C02 sets N and Z from the result instead
+static uint16_t decimalSubtract(const uint8_t a, const uint8_t b, const bool carry) {
+	const int binary = a - b - !carry;
+	const bool overflow = (a ^ b) & (a ^ binary) & 0x80;
+	uint8_t flags = (binary >= 0 ? 0x01 : 0x00) | (overflow ? 0x40 : 0x00);
+
+	int low = (a & 0x0F) - (b & 0x0F) - !carry;
+#ifndef ROCKWEL
+	if (low < 0)
+		low = ((low - 0x06) & 0x0F) - 0x10;
+
+	int difference = (a & 0xF0) - (b & 0xF0) + low;
+	if (difference < 0)
+		difference -= 0x60;
+
+	const uint8_t result = difference & 0xFF;
+	flags |= binary & 0x80;
+	flags |= (binary & 0xFF) == 0 ? 0x02 : 0x00;
+#else
+	int difference = binary;
+	if (difference < 0)
+		difference -= 0x60;
+	if (low < 0)
+		difference -= 0x06;
+
+	const uint8_t result = difference & 0xFF;
+	flags |= result & 0x80;
+	flags |= result == 0 ? 0x02 : 0x00;
+#endif
+
+	return result | (flags << 8);
+}
+
+static void generateDecimalTables(void) {
+	for (int carry = 0; carry < 2; carry++)
+		for (int a = 0; a < 256; a++)
+			for (int b = 0; b < 256; b++) {
+				decimalTables[0][carry][a][b] = decimalAdd(a, b, carry);
+				decimalTables[1][carry][a][b] = decimalSubtract(a, b, carry);
+			}
+}
+
+// decimal ADC and SBC, operand is not inverted for SBC
+static FORCE_INLINE void decimal(cpu_t* cpu, const uint8_t operand, const bool subtract) {
+	const uint16_t entry = decimalTables[subtract][cpu->lazyFlags.carry][cpu->registers.A][operand];
+	const uint8_t flags = entry >> 8;
+
+	cpu->registers.A = entry & 0xFF;
+	cpu->lazyFlags = (struct lazyFlags) {
+		.negative = flags & 0x80,
+		.zero = !(flags & 0x02),
+		.overflow = flags << 1,
+		.carry = flags & 0x01,
+	};
+}
+
+static void handleControlInput(cpu_t* cpu, uint16_t vector) {
+	PUSH(cpu->registers.PC_HI);
+	PUSH(cpu->registers.PC_LO);
+	union flags flags = cpu->registers.flags;
+	flags.B = false;
+	PUSH(flags.byte);
+
+	cpu->registers.PC_LO = bus_read(cpu->bus, vector + 0);
+	cpu->registers.PC_HI = bus_read(cpu->bus, vector + 1);
+
+	cpu->registers.flags.I = true;
+#ifdef WDC
+	cpu->registers.flags.D = false;
+#endif
+	cpu_updateIrq(cpu);
+
+	// the cpu left whatever loop it was in
+	cpu->idle = CPU_IDLE_NONE;
+
+	cpu->cycles = 7;
+	cpu->totalCycles += 7;
+}
+
+static void handleCpuControl(cpu_t* cpu) {
+	if (!cpu->pendingControl)
+		return;
+
+	if (cpu->pendingControl & PENDING_RESET) {
+#ifdef VERBOSE
+		printf("resetting\n");
+#endif
+
+		handleControlInput(cpu, 0xFFFC);
+
+		cpu->registers.SP = (uint8_t) ((rand() / (float) RAND_MAX) * 0xFF);
+
+		cpu->registers.flags._ = true;
+		cpu->registers.flags.B = true;
+
+		// totalCycles and instructionCount keep counting through a reset
+		// the batched run functions measure their budget against them
+	} else if (cpu->pendingControl & PENDING_NMI) {
+#ifdef VERBOSE
+		printf("entering NMI\n");
+#endif
+
+		cpu->pendingControl &= ~PENDING_NMI;
+		handleControlInput(cpu, 0xFFFA);
+	} else if (cpu->pendingControl & PENDING_IRQ) {
+#ifdef VERBOSE
+		printf("entering IRQ\n");
+#endif
+
+		handleControlInput(cpu, 0xFFFE);
+	}
+}
+
+// true if handleCpuControl needs to act, the cpu is halted, or another thread asked the cpu to stop
+// execute stops before the next instruction when this becomes true
+#define STOP_REQUESTED(cpu) atomic_load_explicit(&(cpu)->stopRequested, memory_order_relaxed)
+#define CONTROL_PENDING(cpu) ((cpu)->pendingControl || STOP_REQUESTED(cpu))
+
+// true if another thread asked the run functions to return, the request is used up by this
+static bool takeStopRequest(cpu_t* cpu) {
+	return STOP_REQUESTED(cpu) && atomic_exchange_explicit(&cpu->stopRequested, false, memory_order_relaxed);
+}
+
+static void execute(cpu_t* cpu, size_t count, uint64_t endCycle);
+#ifdef JIT_X86_64
+static void translateBlock(cpu_t* cpu, struct block* block);
+static void forgetTranslations(cpu_t* cpu);
+#endif
+
+// a cpu stopped by a breakpoint or watchpoint continues where it stopped
+// the instruction at a breakpoint the cpu stopped at runs this time
+static void resumeFromBreak(cpu_t* cpu) {
+	if (!(cpu->pendingControl & PENDING_BREAK))
+		return;
+
+	cpu->pendingControl &= ~PENDING_BREAK;
+	cpu->skipBreakpoint = cpu->breakReason == CPU_BREAK_EXECUTE;
+	cpu->breakReason = CPU_BREAK_NONE;
+}
+
+static void handleOpcode(cpu_t* cpu) {
+	if (cpu->cycles > 0)
+		return;
+
+	// a single instruction returns right after anyway, so it runs regardless of a stop request
+	takeStopRequest(cpu);
+	execute(cpu, 1, UINT64_MAX);
+}
+
+// checks if a halted cpu can continue
+// returns true if the cpu is still halted
+static bool handleHalt(cpu_t* cpu) {
+	if (!(cpu->pendingControl & PENDING_HALT))
+		return false;
+
+#ifdef WDC
+	if (cpu->signals.STP) {
+		if (cpu->signals.reset)
+			cpu->signals.STP = false;
+		else
+			return true;
+	}
+#endif
+
+#ifdef WDC
+	if (cpu->signals.WAI) {
+		if ((cpu->signals.irq) ||
+			(cpu->pendingControl & PENDING_NMI))
+			cpu->signals.WAI = false;
+		else
+			return true;
+	}
+#endif
+
+	cpu->pendingControl &= ~PENDING_HALT;
+	return false;
+}
+
+static bool setJit(cpu_t* cpu, const bool enabled);
+
+// prepares the tables shared by every cpu of this variant
+static void init(void) {
+	call_once(&decimalTablesOnce, generateDecimalTables);
+}
+
+static void destroy(cpu_t* cpu) {
+	setJit(cpu, false);
+	free(cpu->blockCache);
+	cpu->blockCache = NULL;
+}
+
+static bool setBlockCache(cpu_t* cpu, const bool enabled) {
+	if (!enabled) {
+		// translated code lives in the blocks
+		setJit(cpu, false);
+		free(cpu->blockCache);
+		cpu->blockCache = NULL;
+		return true;
+	}
+
+	if (cpu->blockCache == NULL)
+		cpu->blockCache = calloc(1, sizeof(struct blockCache));
+
+	return cpu->blockCache != NULL;
+}
+
+static bool setJit(cpu_t* cpu, const bool enabled) {
+#ifdef JIT_X86_64
+	if (!enabled) {
+		if (cpu->jit) {
+			forgetTranslations(cpu);
+			jit_destroy(cpu->jit);
+			free(cpu->jit);
+			cpu->jit = NULL;
+		}
+		return true;
+	}
+
+	if (cpu->jit)
+		return true;
+
+	// a jit that can't be enabled leaves the block cache as it was
+	const bool hadBlockCache = cpu->blockCache != NULL;
+	if (!setBlockCache(cpu, true))
+		return false;
+
+	jit_t* jit = malloc(sizeof(jit_t));
+	if (jit == NULL || !jit_init(jit, JIT_BUFFER_SIZE)) {
+		free(jit);
+		if (!hadBlockCache)
+			setBlockCache(cpu, false);
+		return false;
+	}
+
+	cpu->jit = jit;
+	return true;
+#else
+	return !enabled;
+#endif
+}
+
+static void flushBlockCache(cpu_t* cpu) {
+	if (cpu->blockCache == NULL)
+		return;
+
+	// translated code looks up the blocks it continues at, so those need to go as well
+	for (size_t i = 0; i < BLOCK_CACHE_SIZE; i++) {
+		cpu->blockCache->blocks[i].length = 0;
+		cpu->blockCache->blocks[i].chain = NULL;
+	}
+}
+
+// run single instruction
+// waits to run the instruction until no more cycles need to be consumed
+// afterwards runs entire instruction in a single clockcycle
+// if a cycle needs to be consumed, this function returns early and consumes a single cycle
+static void clockCycle(cpu_t* cpu) {
+	// clockcycle logic gets performed when remaining clock cycles is 0
+	if (cpu->cycles > 0) {
+		cpu->cycles--;
+		return;
+	}
+
+	resumeFromBreak(cpu);
+
+	if (handleHalt(cpu)) {
+		cpu->totalCycles++;
+		return;
+	}
+
+	handleCpuControl(cpu);
+	handleOpcode(cpu);
+}
+
+// runs instruction and all clockcycles required
+static void runInstruction(cpu_t* cpu) {
+	// make sure previous instruction is 'finished'
+	while (cpu->cycles > 0)
+		clockCycle(cpu);
+
+	// execute instruction
+	clockCycle(cpu);
+
+	// make sure current instruction is 'finished'
+	while (cpu->cycles > 0)
+		clockCycle(cpu);
+}
+
+static uint64_t runCycles(cpu_t* cpu, uint64_t budget) {
+	cpu->idle = CPU_IDLE_NONE;
+	resumeFromBreak(cpu);
+
+	// cycles left over from an earlier instruction are already part of totalCycles
+	uint64_t consumed = (uint64_t) cpu->cycles < budget ? (uint64_t) cpu->cycles : budget;
+	cpu->cycles -= (int8_t) consumed;
+	if (consumed == budget)
+		return consumed;
+
+	const uint64_t endCycle = cpu->totalCycles + (budget - consumed);
+	while (cpu->totalCycles < endCycle) {
+		if (handleHalt(cpu)) {
+			// the thread asking to stop is most likely changing a control input, which could wake the cpu
+			if (takeStopRequest(cpu))
+				break;
+
+			// nothing can happen until a control input changes, let the remaining cycles pass
+			cpu->skippedCycles += endCycle - cpu->totalCycles;
+			cpu->totalCycles = endCycle;
+			break;
+		}
+
+		handleCpuControl(cpu);
+		execute(cpu, SIZE_MAX, endCycle);
+
+		if ((cpu->pendingControl & PENDING_BREAK) || takeStopRequest(cpu))
+			break;
+	}
+
+	// stopped by a breakpoint, watchpoint or stop request, the rest of the budget wasn't used
+	if (cpu->totalCycles < endCycle) {
+		cpu->cycles = 0;
+		return budget - (endCycle - cpu->totalCycles);
+	}
+
+	// the last instruction could have taken more cycles than were left, those are consumed in the next call
+	cpu->cycles = (int8_t) (cpu->totalCycles - endCycle);
+
+	return budget;
+}
+
+static uint64_t runInstructions(cpu_t* cpu, uint64_t count) {
+	cpu->idle = CPU_IDLE_NONE;
+	resumeFromBreak(cpu);
+
+	uint64_t consumed = cpu->cycles > 0 ? (uint64_t) cpu->cycles : 0;
+	cpu->cycles = 0;
+
+	const uint64_t startCycle = cpu->totalCycles;
+	const size_t endInstruction = cpu->instructionCount + count;
+	while (cpu->instructionCount < endInstruction) {
+		if (handleHalt(cpu))
+			break;
+
+		handleCpuControl(cpu);
+		execute(cpu, endInstruction - cpu->instructionCount, UINT64_MAX);
+
+		if ((cpu->pendingControl & PENDING_BREAK) || takeStopRequest(cpu))
+			break;
+	}
+
+	// the cycles of the last instruction are consumed immediately
+	cpu->cycles = 0;
+
+	return consumed + (cpu->totalCycles - startCycle);
+}
+
+static cpuOpcodeInfo_t opcodeInfo(const uint8_t opcode) {
+	return (cpuOpcodeInfo_t) {
+		instructions[opcodes[opcode].instruction].name,
+		addressModes[opcodes[opcode].addressMode].name,
+		opcodes[opcode].cycleCount,
+	};
+}
+
+// prints the instruction at pc, data holds its opcode and the 2 bytes after it
+static void printInstruction(const uint16_t pc, const uint8_t* data) {
+#ifdef VERBOSE
+	struct opcode opcode = opcodes[data[0]];
+
+	printf("$%04X: %-*s %-4s(%-*s ",
+		pc,
+		INSTRUCTION_NAME_LENGTH, instructions[opcode.instruction].name,
+		addressModes[opcode.addressMode].name,
+		INSTRUCTION_NAME_LENGTH, instructions[opcode.instruction].name);
+
+	switch (opcode.addressMode) {
+#ifndef WDC
+	case AM_XXX:  printf("         "); break;
+#endif
+	case AM_IMP:  printf("         "); break;
+	case AM_ACC:  printf("A        "); break;
+#ifdef WDC
+	case AM_STK:  printf("         "); break;
+#endif
+	case AM_IMM:  printf("#$%02X     ",   data[1]); break;
+	case AM_ABS:  printf(" $%02X%02X   ", data[2], data[1]); break;
+#ifdef WDC
+	case AM_ABSI: printf("($%02X%02X,X)", data[2], data[1]); break;
+#endif
+	case AM_ABSX: printf(" $%02X%02X,X ", data[2], data[1]); break;
+	case AM_ABSY: printf(" $%02X%02X,Y ", data[2], data[1]); break;
+	case AM_ZPG:  printf(" $%02X     ",   data[1]); break;
+#ifdef WDC
+	case AM_ZPGI: printf("($%02X)    ",   data[1]); break;
+#endif
+	case AM_ZPGX: printf(" $%02X,X   ",   data[1]); break;
+	case AM_ZPGY: printf(" $%02X,Y   ",   data[1]); break;
+	case AM_IND:  printf("($%02X%02X)  ", data[2], data[1]); break;
+	case AM_INDX: printf("($%02X%02X,X)", data[2], data[1]); break;
+	case AM_INDY: printf("($%02X%02X),Y", data[2], data[1]); break;
+	case AM_REL: {
+#ifdef ROCKWEL
+			if ((data[0] & 0x0F) == 0x0F) {
+				printf(" $%02X,%c$%02X", data[2], (int8_t) data[1] < 0 ? '-' : data[1] == 0 ? ' ' : '+', abs((int8_t) data[1]));
+				break;
+			}
+#endif
+			printf("%c$%02X     ", (int8_t) data[1] < 0 ? '-' : data[1] == 0 ? ' ' : '+', abs((int8_t) data[1]));
+			break;
+		}
+	}
+	printf(")\n");
+#else
+	printf("$%04X: %02X", pc, data[0]);
+	switch (opcodes[data[0]].addressMode) {
+#ifndef WDC
+	case AM_XXX:  break;
+#endif
+	case AM_IMP:  break;
+	case AM_ACC:  break;
+#ifdef WDC
+	case AM_STK:  break;
+#endif
+	case AM_IMM:  printf(" %02X",      data[1]); break;
+	case AM_ABS:  printf(" %02X %02X", data[2], data[1]); break;
+#ifdef WDC
+	case AM_ABSI: printf(" %02X %02X", data[2], data[1]); break;
+#endif
+	case AM_ABSX: printf(" %02X %02X", data[2], data[1]); break;
+	case AM_ABSY: printf(" %02X %02X", data[2], data[1]); break;
+	case AM_ZPG:  printf(" %02X",      data[1]); break;
+#ifdef WDC
+	case AM_ZPGI: printf(" %02X",      data[1]); break;
+#endif
+	case AM_ZPGX: printf(" %02X",      data[1]); break;
+	case AM_ZPGY: printf(" %02X",      data[1]); break;
+	case AM_IND:  printf(" %02X %02X", data[2], data[1]); break;
+	case AM_INDX: printf(" %02X %02X", data[2], data[1]); break;
+	case AM_INDY: printf(" %02X %02X", data[2], data[1]); break;
+	case AM_REL: {
+#ifdef ROCKWEL
+		if ((data[0] & 0x0F) == 0x0F) {
+			printf(" %02X %02X", data[1], data[2]);
+			break;
+		}
+#endif
+		printf(" %02X", data[1]); break;
+	}
+	}
+	printf("\n");
+#endif
+}
+
+#pragma region addressingModes
+// the following functions all implement logic for the addressing mode
+
+
+// absolute addressing mode
+// an absolute memory location is provided
+// the value at this memory location is used as operand
+// in case of a jump instruction the memory location provided is the address to jump to
+static FORCE_INLINE void am_abs(OPERATION_PARAMETERS) {
+	op->effectiveAddress = fetchOperand(cpu, op);
+	op->effectiveAddress |= (fetchOperand(cpu, op) << 8);
+	op->operand = bus_read(cpu->bus, op->effectiveAddress);
+}
+
+#ifdef WDC
+// absolute indexed indirect addressing mode
+// an absolute memory location is provided
+// this memory location is incremented by X, this memory location provides 2 bytes to actually use, in the format $LLHH
+// this mode is only used for JMP
+static FORCE_INLINE void am_absi(OPERATION_PARAMETERS) {
+	uint16_t addr = fetchOperand(cpu, op);
+	addr |= (fetchOperand(cpu, op) << 8);
+	addr += cpu->registers.X;
+	op->effectiveAddress = bus_read(cpu->bus, addr) | (bus_read(cpu->bus, addr + 1) << 8);
+}
+#endif
+
+// absolute addressing mode offset by X
+// an absolute memory location is provided
+// this memory location is incremented by X, and the value at that memory location is used as operand
+// this can be used to loop through a set of data, aka an array
+static FORCE_INLINE void am_absx(OPERATION_PARAMETERS) {
+	op->effectiveAddress = fetchOperand(cpu, op);
+	op->effectiveAddress |= (fetchOperand(cpu, op) << 8);
+	if ((op->effectiveAddress & 0xFF00) != ((op->effectiveAddress + cpu->registers.X) & 0xFF00))
+		cpu->cycles++;
+	op->effectiveAddress += cpu->registers.X;
+	op->operand = bus_read(cpu->bus, op->effectiveAddress);
+}
+
+// absolute addressing mode offset by Y
+// an absolute memory location is provided
+// this memory location is incremented by Y, and the value at that memory location is used as operand
+// this can be used to loop through a set of data, aka an array
+static FORCE_INLINE void am_absy(OPERATION_PARAMETERS) {
+	op->effectiveAddress = fetchOperand(cpu, op);
+	op->effectiveAddress |= (fetchOperand(cpu, op) << 8);
+	if ((op->effectiveAddress & 0xFF00) != ((op->effectiveAddress + cpu->registers.Y) & 0xFF00))
+		cpu->cycles++;
+	op->effectiveAddress += cpu->registers.Y;
+	op->operand = bus_read(cpu->bus, op->effectiveAddress);
+}
+
+// immediate addressing mode
+// operand is provided directly after the instruction
+static FORCE_INLINE void am_imm(OPERATION_PARAMETERS) {
+	op->operand = fetchOperand(cpu, op);
+}
+
+// implied addressing mode
+// operand is implied by the instruction
+//   this also includes accumulator addressing mode, as accumulator is the implied operand
+//   this also includes stack addressing mode documented in the WDC data sheets, as stack pointer is the implied operand
+static FORCE_INLINE void am_imp(OPERATION_PARAMETERS) {
+	// implied or stack addressing mode don't need anything
+	// accumulator addressing mode will set accumulator to operand, to make implementation logic a bit more clear
+	op->operand = cpu->registers.A;
+}
+
+// indirect addressing mode
+// an absolute memory location is provided
+// this memory location provides 2 byte to actually use, in the format $LLHH
+// this mode is generally only used for JMP
+static FORCE_INLINE void am_ind(OPERATION_PARAMETERS) {
+	uint16_t addr = fetchOperand(cpu, op);
+	addr |= (fetchOperand(cpu, op) << 8);
+	op->effectiveAddress = bus_read(cpu->bus, addr);
+#ifndef WDC
+	if ((addr & 0xFF00) == ((addr + 1) & 0xFF00))
+		op->effectiveAddress |= (bus_read(cpu->bus, (addr + 1)) << 8);
+	else
+		op->effectiveAddress |= (bus_read(cpu->bus, (addr + 1 - 0x100)) << 8);
+#else
+	op->effectiveAddress |= (bus_read(cpu->bus, addr + 1) << 8);
+
+	if (addr + 1 > 0xFF)
+		cpu->cycles++;
+#endif
+}
+
+// pre-indexed indirect addressing mode
+// a byte is provided, which describes the offset in the zero-page
+// from this zero-page address two bytes are read ($LLHH), which gets incremented by X
+// this increased memory address points to the memory address ($LLHH) where the actual data is stored
+static FORCE_INLINE void am_indx(OPERATION_PARAMETERS) {
+	uint8_t offset = fetchOperand(cpu, op);
+	offset += cpu->registers.X;
+	op->effectiveAddress = bus_read(cpu->bus, offset) | (bus_read(cpu->bus, offset + 1) << 8);
+	op->operand = bus_read(cpu->bus, op->effectiveAddress);
+}
+
+// post-indexed indirect addressing mode
+// a byte is provided, which describes the offset in the zero-page
+// from this zero-page address two bytes are read ($LLHH)
+// this memory address points to the memory address ($LLHH), which gets incremented with Y
+// this address is where the actual data is stored
+static FORCE_INLINE void am_indy(OPERATION_PARAMETERS) {
+	uint8_t offset = fetchOperand(cpu, op);
+	op->effectiveAddress = bus_read(cpu->bus, offset) | (bus_read(cpu->bus, offset + 1) << 8);
+	if ((op->effectiveAddress & 0xFF00) != ((op->effectiveAddress + cpu->registers.Y) & 0xFF00))
+		cpu->cycles++;
+	op->effectiveAddress += cpu->registers.Y;
+	op->operand = bus_read(cpu->bus, op->effectiveAddress);
+}
+
+// relative addressing mode
+// operand provided is a signed byte
+// this byte is added to PC to get the address to branch to
+// this mode is only allowed for the branch instructions
+static FORCE_INLINE void am_rel(OPERATION_PARAMETERS) {
+	int8_t offset = fetchOperand(cpu, op);
+#ifdef ROCKWEL
+	// the branch if bit is set/reset instructions also take a zero page offset
+	// which need to be read from the program.
+	// these instructions conveniently have the top nibble be all 1s
+	if ((op->opcode & 0x0F) == 0x0F) {
+		op->operand = bus_read(cpu->bus, offset);
+		offset = fetchOperand(cpu, op);
+	}
+#endif
+	// TODO: move this to BRANCH, only take clockcycle if the branch is taken
+	if ((cpu->registers.PC & 0xFF00) != ((cpu->registers.PC + offset) & 0xFF00))
+		cpu->cycles++;
+	op->effectiveAddress = cpu->registers.PC + offset;
+}
+
+// zero-page addressing mode
+// a byte is provided directly after the instruction which contains an offset in the zero-page
+// the absolute address would be $00XX
+// this makes the operation faster, and shorter
+// the instruction takes only 2 bytes, instead of 3 for a full address
+static FORCE_INLINE void am_zpg(OPERATION_PARAMETERS) {
+	op->effectiveAddress = fetchOperand(cpu, op);
+	op->operand = bus_read(cpu->bus, op->effectiveAddress);
+}
+
+#ifdef WDC
+// zero-page indirect addressing mode
+// a byte is provided directly after the instruction which contains an offset in the zero-page
+// this memory location provides 2 byte to actually use, in the format $LLHH
+static FORCE_INLINE void am_zpgi(OPERATION_PARAMETERS) {
+	uint8_t offset = fetchOperand(cpu, op);
+	op->effectiveAddress = bus_read(cpu->bus, offset) | (bus_read(cpu->bus, offset + 1) << 8);
+	op->operand = bus_read(cpu->bus, op->effectiveAddress);
+}
+#endif
+
+// zero-page addressing mode offset by X
+// a byte is provided directly after the instruction which contains an offset in the zero-page
+// this memory location is incremented by X, and the value at that memory location is used as operand
+// this can be used to loop through a set of data, aka an array
+// this makes the operation faster, and shorter
+// the instruction takes only 2 bytes, instead of 3 for a full address
+// the result of the addition wraps around, so the byte read will always be inside the zero-page
+static FORCE_INLINE void am_zpgx(OPERATION_PARAMETERS) {
+	op->effectiveAddress = fetchOperand(cpu, op);
+	op->effectiveAddress += cpu->registers.X;
+	op->effectiveAddress &= 0xFF;
+	op->operand = bus_read(cpu->bus, op->effectiveAddress);
+}
+
+// zero-page addressing mode offset by Y
+// a byte is provided directly after the instruction which contains an offset in the zero-page
+// this memory location is incremented by Y, and the value at that memory location is used as operand
+// this can be used to loop through a set of data, aka an array
+// this makes the operation faster, and shorter
+// the instruction takes only 2 bytes, instead of 3 for a full address
+// the result of the addition wraps around, so the byte read will always be inside the zero-page
+// this addressing mode is only used if the register used is X (LDX, STX), so X cannot be used
+static FORCE_INLINE void am_zpgy(OPERATION_PARAMETERS) {
+	op->effectiveAddress = fetchOperand(cpu, op);
+	op->effectiveAddress += cpu->registers.Y;
+	op->effectiveAddress &= 0xFF;
+	op->operand = bus_read(cpu->bus, op->effectiveAddress);
+}
+
+#ifndef WDC
+// addressing mode for illegal opcodes
+// shouldn't be used in normal programs
+//   the 6502 has a couple of opcodes that gave somewhat reliable results
+//   the WDC version of the 6502 has all illegal opcodes as implemented as nops
+static FORCE_INLINE void am_xxx(OPERATION_PARAMETERS) {
+#ifdef VERBOSE
+	printf("ILLEGAL ADDRESS MODE EXECUTED\n");
+#endif
+}
+#endif
+
+#pragma endregion addressingModes
+
+#pragma region instructions
+// the following functions all implement logic for the instructions
+
+#ifdef ROCKWEL
+// some macro magic to get an easier time implementing the bit instructions
+// these instrutions originated in the Rockwel chips, and were later adapted by WDC
+#define BITS_EXPANSION(funcName) \
+BIT_EXPANSION(funcName, 0) BIT_EXPANSION(funcName, 1) \
+BIT_EXPANSION(funcName, 2) BIT_EXPANSION(funcName, 3) BIT_EXPANSION(funcName, 4) \
+BIT_EXPANSION(funcName, 5) BIT_EXPANSION(funcName, 6) BIT_EXPANSION(funcName, 7)
+#define BIT_EXPANSION(funcName, bit) static FORCE_INLINE void in_##funcName##bit(cpu_t* cpu, struct operation* op) { in_##funcName(cpu, op, bit); }
+#endif
+
+// ADd with Carry
+// adds operand to accumulator with carry flag
+static FORCE_INLINE void in_adc(OPERATION_PARAMETERS) {
+	if (cpu->registers.flags.D)
+		decimal(cpu, op->operand, false);
+	else
+		add(cpu, op);
+}
+
+// bitwise AND
+// performs a bitwise and with operand and accumulator
+static FORCE_INLINE void in_and(OPERATION_PARAMETERS) {
+	cpu->registers.A &= op->operand;
+
+	SET_FLAGS(cpu->registers.A);
+}
+
+// Arithmatic Shift Left
+// shifts 0 into bit 0
+// shifts bit 7 into carry flag
+static FORCE_INLINE void in_asl(OPERATION_PARAMETERS) {
+	RMW();
+	cpu->lazyFlags.carry = op->operand & 0x80;
+	op->operand <<= 1;
+	op->operand &= 0xFE; // ensure newly added bit is 0
+
+	SET_FLAGS(op->operand);
+
+	if (op->addressMode == AM_ACC)
+		cpu->registers.A = op->operand;
+	else
+		bus_write(cpu->bus, op->effectiveAddress, op->operand);
+}
+
+#ifdef ROCKWEL
+// Branch on Bit Reset
+// tests bit of location in zero page, and branches if it is 0
+// a branch taken takes an extra clock cycle
+static FORCE_INLINE void in_bbr(cpu_t* cpu, struct operation* op, uint8_t bit) {
+	BRANCH(!(op->operand & (1 << bit)));
+}
+
+BITS_EXPANSION(bbr)
+#endif
+
+#ifdef ROCKWEL
+// Branch on Bit Set
+// tests bit of location in zero page, and branches if it is 1
+// a branch taken takes an extra clock cycle
+static FORCE_INLINE void in_bbs(cpu_t* cpu, struct operation* op, uint8_t bit) {
+	BRANCH((op->operand & (1 << bit)));
+}
+
+BITS_EXPANSION(bbs)
+#endif
+
+// Branch Carry Clear
+// branches when carry flag is unset
+// a branch taken takes an extra clock cycle
+static FORCE_INLINE void in_bcc(OPERATION_PARAMETERS) {
+	BRANCH(!cpu->lazyFlags.carry);
+}
+
+// Branch Carry Set
+// branches when carry flag is set
+// a branch taken takes an extra clock cycle
+static FORCE_INLINE void in_bcs(OPERATION_PARAMETERS) {
+	BRANCH(cpu->lazyFlags.carry);
+}
+
+// Branch on EQual
+// branches when zero flag is set (two values are equal if A - B == 0)
+// a branch taken takes an extra clock cycle
+static FORCE_INLINE void in_beq(OPERATION_PARAMETERS) {
+	BRANCH(cpu->lazyFlags.zero == 0);
+}
+
+// test BITs
+// probably the most confusing instruction of the 6502
+// zero flag is set according to the operation accumulator AND operand
+// bits 6 and 7 of operand are set as negative and overflow flags respectively
+// this instruction only alters flags register
+static FORCE_INLINE void in_bit(OPERATION_PARAMETERS) {
+	cpu->lazyFlags.zero = cpu->registers.A & op->operand;
+#ifdef WDC
+	if (op->addressMode != AM_IMM) {
+#endif
+	cpu->lazyFlags.negative = op->operand;
+	cpu->lazyFlags.overflow = op->operand << 1; // bit 6 becomes bit 7
+#ifdef WDC
+	}
+#endif
+}
+
+// Branch on MInus
+// branches when negative flag is set
+// a branch taken takes an extra clock cycle
+static FORCE_INLINE void in_bmi(OPERATION_PARAMETERS) {
+	BRANCH(cpu->lazyFlags.negative & 0x80);
+}
+
+// Branch on Not Equals
+// branches when zero flag is unset (two values are not equal if A - B != 0)
+// a branch taken takes an extra clock cycle
+static FORCE_INLINE void in_bne(OPERATION_PARAMETERS) {
+	BRANCH(cpu->lazyFlags.zero != 0);
+}
+
+// Branch on PLus
+// branches when negative flag is unset
+// a branch taken takes an extra clock cycle
+static FORCE_INLINE void in_bpl(OPERATION_PARAMETERS) {
+	BRANCH(!(cpu->lazyFlags.negative & 0x80));
+}
+
+#ifdef WDC
+// Branch Always
+// a branch taken takes an extra clock cycle
+//   this is always the case, so don't take an extra clock cycle, it is added in the opcode table
+static FORCE_INLINE void in_bra(OPERATION_PARAMETERS) {
+	cpu->cycles--; // correct the cycles increment from branch
+	BRANCH(true);
+}
+#endif
+
+// BReaK
+// forces an interrupt to occur
+// this starts the IRQ sequence with break flag set
+// the return address is PC + 2, making the byte following this instruction being skipped
+// this byte can be used as a break mark
+static FORCE_INLINE void in_brk(OPERATION_PARAMETERS) {
+	cpu->registers.PC++;
+	PUSH(cpu->registers.PC_HI);
+	PUSH(cpu->registers.PC_LO);
+	union flags flags = { .byte = packFlags(cpu) };
+	flags.B = true;
+	flags._ = true;
+	PUSH(flags.byte);
+
+	cpu->registers.PC_LO = bus_read(cpu->bus, 0xFFFE);
+	cpu->registers.PC_HI = bus_read(cpu->bus, 0xFFFF);
+	cpu->registers.flags.I = true; // run normal interrupt sequence
+#ifdef WDC
+	cpu->registers.flags.D = false;
+#endif
+	cpu_updateIrq(cpu);
+}
+
+// Branch on oVerflow Clear
+// branches when overflow flag is unset
+// a branch taken takes an extra clock cycle
+static FORCE_INLINE void in_bvc(OPERATION_PARAMETERS) {
+	BRANCH(!(cpu->lazyFlags.overflow & 0x80));
+}
+
+// Branch on oVerflow Set
+// branches when overflow flag is set
+// a branch taken takes an extra clock cycle
+static FORCE_INLINE void in_bvs(OPERATION_PARAMETERS) {
+	BRANCH(cpu->lazyFlags.overflow & 0x80);
+}
+
+// CLear Carry flag
+static FORCE_INLINE void in_clc(OPERATION_PARAMETERS) {
+	cpu->lazyFlags.carry = false;
+}
+
+// CLear Decimal flag
+// makes the 6502 perform normal binary math
+static FORCE_INLINE void in_cld(OPERATION_PARAMETERS) {
+	cpu->registers.flags.D = false;
+}
+
+// CLear interrupt flag
+// this instruction enables interrupts from the IRQ pin/function, as this pin is active low
+static FORCE_INLINE void in_cli(OPERATION_PARAMETERS) {
+	cpu->registers.flags.I = false;
+	cpu_updateIrq(cpu);
+}
+
+// CLear oVerflow
+static FORCE_INLINE void in_clv(OPERATION_PARAMETERS) {
+	cpu->lazyFlags.overflow = 0;
+}
+
+// CoMPare with accumulator
+// subtract operand with accumulator, and set flags register accordingly
+// then ignore the result from the subtraction
+// this instruction only alters flags register
+static FORCE_INLINE void in_cmp(OPERATION_PARAMETERS) {
+	cpu->lazyFlags.carry = cpu->registers.A >= op->operand;
+	SET_FLAGS((uint8_t) (cpu->registers.A - op->operand));
+}
+
+// CoMpare with X register
+// subtract operand with accumulator, and set flags register accordingly
+// then ignore the result from the subtraction
+// this instruction only alters flags register
+static FORCE_INLINE void in_cpx(OPERATION_PARAMETERS) {
+	cpu->lazyFlags.carry = cpu->registers.X >= op->operand;
+	SET_FLAGS((uint8_t) (cpu->registers.X - op->operand));
+}
+
+// CoMpare with Y register
+// subtract operand with accumulator, and set flags register accordingly
+// then ignore the result from the subtraction
+// this instruction only alters flags register
+static FORCE_INLINE void in_cpy(OPERATION_PARAMETERS) {
+	cpu->lazyFlags.carry = cpu->registers.Y >= op->operand;
+	SET_FLAGS((uint8_t) (cpu->registers.Y - op->operand));
+}
+
+// DECrement operand
+static FORCE_INLINE void in_dec(OPERATION_PARAMETERS) {
+	RMW();
+	op->operand--;
+#ifdef WDC
+	if (op->addressMode == AM_ACC)
+		cpu->registers.A = op->operand;
+	else
+#endif
+	bus_write(cpu->bus, op->effectiveAddress, op->operand);
+
+	SET_FLAGS(op->operand);
+}
+
+// DEcrement X register
+static FORCE_INLINE void in_dex(OPERATION_PARAMETERS) {
+	cpu->registers.X--;
+
+	SET_FLAGS(cpu->registers.X);
+}
+
+// DEcrement Y register
+static FORCE_INLINE void in_dey(OPERATION_PARAMETERS) {
+	cpu->registers.Y--;
+
+	SET_FLAGS(cpu->registers.Y);
+}
+
+// bitwise eXclusive OR
+// performs a bitwise exclusive or with operand and accumulator
+static FORCE_INLINE void in_eor(OPERATION_PARAMETERS) {
+	cpu->registers.A ^= op->operand;
+
+	SET_FLAGS(cpu->registers.A);
+}
+
+// INCrement operand
+static FORCE_INLINE void in_inc(OPERATION_PARAMETERS) {
+	RMW();
+	op->operand++;
+#ifdef WDC
+	if (op->addressMode == AM_ACC)
+		cpu->registers.A = op->operand;
+	else
+#endif
+	bus_write(cpu->bus, op->effectiveAddress, op->operand);
+
+	SET_FLAGS(op->operand);
+}
+
+// INcrement X register
+static FORCE_INLINE void in_inx(OPERATION_PARAMETERS) {
+	cpu->registers.X++;
+
+	SET_FLAGS(cpu->registers.X);
+}
+
+// INcrement Y register
+static FORCE_INLINE void in_iny(OPERATION_PARAMETERS) {
+	cpu->registers.Y++;
+
+	SET_FLAGS(cpu->registers.Y);
+}
+
+// JuMP
+// loads PC with operand
+static FORCE_INLINE void in_jmp(OPERATION_PARAMETERS) {
+	if (op->addressMode == AM_ABS && op->effectiveAddress == (uint16_t) (cpu->registers.PC - 3))
+		TRAP();
+	cpu->registers.PC = op->effectiveAddress;
+}
+
+// Jump to SubRoutine
+// saves current PC in stack
+// loads PC with operand
+static FORCE_INLINE void in_jsr(OPERATION_PARAMETERS) {
+	cpu->registers.PC--;
+	PUSH(cpu->registers.PC_HI);
+	PUSH(cpu->registers.PC_LO);
+	cpu->registers.PC = op->effectiveAddress;
+}
+
+// LoaD Accumulator with operand
+static FORCE_INLINE void in_lda(OPERATION_PARAMETERS) {
+	cpu->registers.A = op->operand;
+
+	SET_FLAGS(cpu->registers.A);
+}
+
+// LoaD X register with operand
+static FORCE_INLINE void in_ldx(OPERATION_PARAMETERS) {
+	cpu->registers.X = op->operand;
+
+	SET_FLAGS(cpu->registers.X);
+}
+
+// LoaD Y register with operand
+static FORCE_INLINE void in_ldy(OPERATION_PARAMETERS) {
+	cpu->registers.Y = op->operand;
+
+	SET_FLAGS(cpu->registers.Y);
+}
+
+// Logical Shift Right
+// shifts 0 into bit 7
+// shifts bit 0 into carry flag
+static FORCE_INLINE void in_lsr(OPERATION_PARAMETERS) {
+	RMW();
+	cpu->lazyFlags.carry = op->operand & 0x01;
+	op->operand >>= 1;
+	op->operand &= 0xEF; // ensure newly added bit is 0
+
+	SET_FLAGS(op->operand); // N should always be false, we shifted a zero into it
+
+	if (op->addressMode == AM_ACC)
+		cpu->registers.A = op->operand;
+	else
+		bus_write(cpu->bus, op->effectiveAddress, op->operand);
+}
+
+// No OPeration
+// this instruction does nothing
+//   the WDC version of the 6502 has all illegal opcodes as implemented as nops
+//   these differ slightly in operand size and/or cycle counts
+static FORCE_INLINE void in_nop(OPERATION_PARAMETERS) {
+#ifdef WDC
+	cpu->registers.PC += nopOperandBytes(op->opcode);
+#endif
+}
+
+// bitwise OR with Accumulator
+// performs a bitwise or with operand and accumulator
+static FORCE_INLINE void in_ora(OPERATION_PARAMETERS) {
+	cpu->registers.A |= op->operand;
+
+	SET_FLAGS(cpu->registers.A);
+}
+
+// PusH Accumulator on stack
+static FORCE_INLINE void in_pha(OPERATION_PARAMETERS) {
+	PUSH(cpu->registers.A);
+}
+
+// PusH Processor status
+// pushes flags register on stack
+// this instruction sets break flag and bit 5 (unused)
+static FORCE_INLINE void in_php(OPERATION_PARAMETERS) {
+	union flags flags = { .byte = packFlags(cpu) };
+	flags.B = true;
+	flags._ = true;
+	PUSH(flags.byte);
+}
+
+#ifdef WDC
+// PusH X register on stack
+static FORCE_INLINE void in_phx(OPERATION_PARAMETERS) {
+	PUSH(cpu->registers.X);
+}
+#endif
+
+#ifdef WDC
+// PusH Y register on stack
+static FORCE_INLINE void in_phy(OPERATION_PARAMETERS) {
+	PUSH(cpu->registers.Y);
+}
+#endif
+
+// PuLl Accumulator off stack
+static FORCE_INLINE void in_pla(OPERATION_PARAMETERS) {
+	cpu->registers.A = PULL();
+
+	SET_FLAGS(cpu->registers.A);
+}
+
+// PuLl Processor status
+// pulls flags register off stack
+// this instruction ignores break flag and bit 5 (unused)
+static FORCE_INLINE void in_plp(OPERATION_PARAMETERS) {
+	union flags flags = { .byte = PULL() };
+	flags.B = cpu->registers.flags.B;
+	flags._ = cpu->registers.flags._;
+	unpackFlags(cpu, flags.byte);
+	cpu_updateIrq(cpu);
+}
+
+#ifdef WDC
+// PuLl X register off stack
+static FORCE_INLINE void in_plx(OPERATION_PARAMETERS) {
+	cpu->registers.X = PULL();
+
+	SET_FLAGS(cpu->registers.X);
+}
+#endif
+
+#ifdef WDC
+// PuLl Y register off stack
+static FORCE_INLINE void in_ply(OPERATION_PARAMETERS) {
+	cpu->registers.Y = PULL();
+
+	SET_FLAGS(cpu->registers.Y);
+}
+#endif
+
+#ifdef ROCKWEL
+// Reset Memory Bit
+// sets bit at operand to 0
+static FORCE_INLINE void in_rmb(cpu_t* cpu, struct operation* op, uint8_t bit) {
+	bus_write(cpu->bus, op->effectiveAddress, op->operand & ~(1 << bit));
+}
+
+BITS_EXPANSION(rmb)
+#endif
+
+// ROtate Left
+// shifts carry flag into bit 0
+// shifts bit 7 into carry flag
+static FORCE_INLINE void in_rol(OPERATION_PARAMETERS) {
+	RMW();
+	bool oldCarry = cpu->lazyFlags.carry;
+
+	cpu->lazyFlags.carry = op->operand & 0x80;
+	op->operand <<= 1;
+	op->operand &= 0xFE;
+	op->operand |= oldCarry;
+
+	SET_FLAGS(op->operand);
+
+	if (op->addressMode == AM_ACC)
+		cpu->registers.A = op->operand;
+	else
+		bus_write(cpu->bus, op->effectiveAddress, op->operand);
+}
+
+// ROtate Right
+// shifts carry flag into bit 7
+// shifts bit 0 into carry flag
+//   early versions of the 6502 have a bug in this instruction
+//   the instruction would instead perform as an ASL, without shifting bit 7 into carry flag
+//   this bug makes it so that carry flag would be unused during the instruction
+static FORCE_INLINE void in_ror(OPERATION_PARAMETERS) {
+	RMW();
+	bool oldCarry = cpu->lazyFlags.carry;
+
+	cpu->lazyFlags.carry = op->operand & 0x01;
+	op->operand >>= 1;
+	op->operand &= 0xEF;
+	op->operand |= oldCarry << 7;
+
+	SET_FLAGS(op->operand);
+
+	if (op->addressMode == AM_ACC)
+		cpu->registers.A = op->operand;
+	else
+		bus_write(cpu->bus, op->effectiveAddress, op->operand);
+}
+
+// ReTurn from interrupt
+// pulls flags register from stack, ignoring break flag and bit 5
+// then pulls PC from stack
+static FORCE_INLINE void in_rti(OPERATION_PARAMETERS) {
+	union flags flags = { .byte = PULL() };
+	flags.B = cpu->registers.flags.B;
+	flags._ = cpu->registers.flags._;
+	unpackFlags(cpu, flags.byte);
+	cpu_updateIrq(cpu);
+	cpu->registers.PC_LO = PULL();
+	cpu->registers.PC_HI = PULL();
+
+}
+
+// ReTurn from Subroutine
+// pulls PC from stack
+static FORCE_INLINE void in_rts(OPERATION_PARAMETERS) {
+	cpu->registers.PC_LO = PULL();
+	cpu->registers.PC_HI = PULL();
+	cpu->registers.PC++;
+}
+
+// SuBtract with Carry
+// subtract operand from accumulator with carry flag as a borrow
+// carry flag should be set before being called
+// if carry flag is cleared after the call, a borrow was needed
+static FORCE_INLINE void in_sbc(OPERATION_PARAMETERS) {
+	if (cpu->registers.flags.D) {
+		decimal(cpu, op->operand, true);
+		return;
+	}
+
+	op->operand ^= 0xff; // invert operand to allow regular addition (same as 6502)
+	add(cpu, op);
+}
+
+// SEt Carry flag
+static FORCE_INLINE void in_sec(OPERATION_PARAMETERS) {
+	cpu->lazyFlags.carry = true;
+}
+
+// SEt Decimal flag
+// makes the 6502 perform binary coded decimal math
+static FORCE_INLINE void in_sed(OPERATION_PARAMETERS) {
+	cpu->registers.flags.D = true;
+}
+
+// SEt interrupt flag
+// this instruction disables interrupts from the IRQ pin/function, as this pin is active low
+static FORCE_INLINE void in_sei(OPERATION_PARAMETERS) {
+	cpu->registers.flags.I = true;
+	cpu_updateIrq(cpu);
+}
+
+#ifdef ROCKWEL
+// Set Memory Bit
+// sets bit at operand to 1
+static FORCE_INLINE void in_smb(cpu_t* cpu, struct operation* op, uint8_t bit) {
+	bus_write(cpu->bus, op->effectiveAddress, op->operand | (1 << bit));
+}
+
+BITS_EXPANSION(smb)
+#endif
+
+// STore Accumulator at operand
+static FORCE_INLINE void in_sta(OPERATION_PARAMETERS) {
+	bus_write(cpu->bus, op->effectiveAddress, cpu->registers.A);
+}
+
+#ifdef WDC
+// SToP
+// stops the clock from affecting the 65c02
+// the 65c02 is faster to respond to the reset pin/function
+static FORCE_INLINE void in_stp(OPERATION_PARAMETERS) {
+	cpu->signals.STP = true;
+	cpu->pendingControl |= PENDING_HALT;
+}
+#endif
+
+// STore X register at operand
+static FORCE_INLINE void in_stx(OPERATION_PARAMETERS) {
+	bus_write(cpu->bus, op->effectiveAddress, cpu->registers.X);
+}
+
+// STore Y register at operand
+static FORCE_INLINE void in_sty(OPERATION_PARAMETERS) {
+	bus_write(cpu->bus, op->effectiveAddress, cpu->registers.Y);
+}
+
+#ifdef WDC
+// STore Zero at operand
+static FORCE_INLINE void in_stz(OPERATION_PARAMETERS) {
+	bus_write(cpu->bus, op->effectiveAddress, 0);
+}
+#endif
+
+// Transfer Accumulator to X register
+static FORCE_INLINE void in_tax(OPERATION_PARAMETERS) {
+	cpu->registers.X = cpu->registers.A;
+
+	SET_FLAGS(cpu->registers.X);
+}
+
+// Transfer Accumulator to Y register
+static FORCE_INLINE void in_tay(OPERATION_PARAMETERS) {
+	cpu->registers.Y = cpu->registers.A;
+
+	SET_FLAGS(cpu->registers.Y);
+}
+
+#ifdef WDC
+// Test and Reset Bit
+// clears bits set in accumulator at operand
+// sets zero flag if any bits were changed, otherwise it gets cleared
+static FORCE_INLINE void in_trb(OPERATION_PARAMETERS) {
+	cpu->lazyFlags.zero = cpu->registers.A & op->operand;
+	bus_write(cpu->bus, op->effectiveAddress, op->operand & ~cpu->registers.A);
+}
+#endif
+
+#ifdef WDC
+// Test and Set Bit
+// sets bits set in accumulator at operand
+// sets zero flag if any bits were changed, otherwise it gets cleared
+static FORCE_INLINE void in_tsb(OPERATION_PARAMETERS) {
+	cpu->lazyFlags.zero = cpu->registers.A & op->operand;
+	bus_write(cpu->bus, op->effectiveAddress, op->operand | cpu->registers.A);
+}
+#endif
+
+// Transfer Stack pointer to X register
+static FORCE_INLINE void in_tsx(OPERATION_PARAMETERS) {
+	cpu->registers.X = cpu->registers.SP;
+
+	SET_FLAGS(cpu->registers.X);
+}
+
+// Transfer X register to Accumulator
+static FORCE_INLINE void in_txa(OPERATION_PARAMETERS) {
+	cpu->registers.A = cpu->registers.X;
+
+	SET_FLAGS(cpu->registers.A);
+}
+
+// Transfer X register to Stack pointer
+static FORCE_INLINE void in_txs(OPERATION_PARAMETERS) {
+	cpu->registers.SP = cpu->registers.X;
+}
+
+// Transfer Y register to Accumulator
+static FORCE_INLINE void in_tya(OPERATION_PARAMETERS) {
+	cpu->registers.A = cpu->registers.Y;
+
+	SET_FLAGS(cpu->registers.A);
+}
+
+#ifdef WDC
+// WAit for interrupt
+// stops the clock from affecting the 65c02
+// the 65c02 is faster to respond to the IRQ/NMI pins/functions
+static FORCE_INLINE void in_wai(OPERATION_PARAMETERS) {
+	cpu->signals.WAI = true;
+	cpu->pendingControl |= PENDING_HALT;
+}
+#endif
+
+#ifndef WDC
+// instruction for illegal opcodes
+// shouldn't be used in normal programs
+//   the 6502 has a couple of opcodes that gave somewhat reliable results
+//   the WDC version of the 6502 has all illegal opcodes as implemented as nops
+static FORCE_INLINE void in_xxx(OPERATION_PARAMETERS) {
+#ifdef VERBOSE
+	printf("ILLEGAL INSTRUCTION EXECUTED\n");
+#endif
+}
+#endif
+
+#ifdef ROCKWEL
+#undef BITS_EXPANSION
+#undef BIT_EXPANSION
+#endif
+
+#pragma endregion instructions
+
+#pragma region data
+
+#if defined(WDC)
+#define OPCODES(OP) \
+	OP(00,BRK ,STK ,7) OP(01,ORA ,INDX,6) OP(02,NOP ,IMP ,2) OP(03,NOP ,IMP ,1) OP(04,TSB ,ZPG ,5) OP(05,ORA ,ZPG ,3) OP(06,ASL ,ZPG ,5) OP(07,RMB0,ZPG ,5) OP(08,PHP ,STK ,3) OP(09,ORA ,IMM ,2) OP(0A,ASL ,ACC ,2) OP(0B,NOP ,IMP ,1) OP(0C,TSB ,ABS ,6) OP(0D,ORA ,ABS ,4) OP(0E,ASL ,ABS ,6) OP(0F,BBR0,REL ,5) \
+	OP(10,BPL ,REL ,2) OP(11,ORA ,INDY,5) OP(12,ORA ,ZPGI,5) OP(13,NOP ,IMP ,1) OP(14,TRB ,ZPG ,5) OP(15,ORA ,ZPGX,4) OP(16,ASL ,ZPGX,6) OP(17,RMB1,ZPG ,5) OP(18,CLC ,IMP ,2) OP(19,ORA ,ABSY,4) OP(1A,INC ,ACC ,2) OP(1B,NOP ,IMP ,1) OP(1C,TRB ,ABS ,6) OP(1D,ORA ,ABSX,4) OP(1E,ASL ,ABSX,7) OP(1F,BBR1,REL ,5) \
+	OP(20,JSR ,ABS ,6) OP(21,AND ,INDX,6) OP(22,NOP ,IMP ,2) OP(23,NOP ,IMP ,1) OP(24,BIT ,ZPG ,3) OP(25,AND ,ZPG ,3) OP(26,ROL ,ZPG ,5) OP(27,RMB2,ZPG ,5) OP(28,PLP ,STK ,4) OP(29,AND ,IMM ,2) OP(2A,ROL ,ACC ,2) OP(2B,NOP ,IMP ,1) OP(2C,BIT ,ABS ,4) OP(2D,AND ,ABS ,4) OP(2E,ROL ,ABS ,6) OP(2F,BBR2,REL ,5) \
+	OP(30,BMI ,REL ,2) OP(31,AND ,INDY,5) OP(32,AND ,ZPGI,5) OP(33,NOP ,IMP ,1) OP(34,BIT ,ZPGX,4) OP(35,AND ,ZPGX,4) OP(36,ROL ,ZPGX,6) OP(37,RMB3,ZPG ,5) OP(38,SEC ,IMP ,2) OP(39,AND ,ABSY,4) OP(3A,DEC ,ACC ,2) OP(3B,NOP ,IMP ,1) OP(3C,BIT ,ABSX,4) OP(3D,AND ,ABSX,4) OP(3E,ROL ,ABSX,7) OP(3F,BBR3,REL ,5) \
+	OP(40,RTI ,STK ,6) OP(41,EOR ,INDX,6) OP(42,NOP ,IMP ,2) OP(43,NOP ,IMP ,1) OP(44,NOP ,IMP ,3) OP(45,EOR ,ZPG ,3) OP(46,LSR ,ZPG ,5) OP(47,RMB4,ZPG ,5) OP(48,PHA ,STK ,3) OP(49,EOR ,IMM ,2) OP(4A,LSR ,ACC ,2) OP(4B,NOP ,IMP ,1) OP(4C,JMP ,ABS ,3) OP(4D,EOR ,ABS ,4) OP(4E,LSR ,ABS ,6) OP(4F,BBR4,REL ,5) \
+	OP(50,BVC ,REL ,2) OP(51,EOR ,INDY,5) OP(52,EOR ,ZPGI,5) OP(53,NOP ,IMP ,1) OP(54,NOP ,IMP ,4) OP(55,EOR ,ZPGX,4) OP(56,LSR ,ZPGX,6) OP(57,RMB5,ZPG ,5) OP(58,CLI ,IMP ,2) OP(59,EOR ,ABSY,4) OP(5A,PHY ,STK ,3) OP(5B,NOP ,IMP ,1) OP(5C,NOP ,IMP ,8) OP(5D,EOR ,ABSX,4) OP(5E,LSR ,ABSX,7) OP(5F,BBR5,REL ,5) \
+	OP(60,RTS ,STK ,6) OP(61,ADC ,INDX,6) OP(62,NOP ,IMP ,2) OP(63,NOP ,IMP ,1) OP(64,STZ ,ZPG ,3) OP(65,ADC ,ZPG ,3) OP(66,ROR ,ZPG ,5) OP(67,RMB6,ZPG ,5) OP(68,PLA ,STK ,4) OP(69,ADC ,IMM ,2) OP(6A,ROR ,ACC ,2) OP(6B,NOP ,IMP ,1) OP(6C,JMP ,IND ,5) OP(6D,ADC ,ABS ,4) OP(6E,ROR ,ABS ,6) OP(6F,BBR6,REL ,5) \
+	OP(70,BVS ,REL ,2) OP(71,ADC ,INDY,5) OP(72,ADC ,ZPGI,5) OP(73,NOP ,IMP ,1) OP(74,STZ ,ZPGX,4) OP(75,ADC ,ZPGX,4) OP(76,ROR ,ZPGX,6) OP(77,RMB7,ZPG ,5) OP(78,SEI ,IMP ,2) OP(79,ADC ,ABSY,4) OP(7A,PLY ,STK ,4) OP(7B,NOP ,IMP ,1) OP(7C,JMP ,ABSI,6) OP(7D,ADC ,ABSX,4) OP(7E,ROR ,ABSX,7) OP(7F,BBR7,REL ,5) \
+	\
+	OP(80,BRA ,REL ,3) OP(81,STA ,INDX,6) OP(82,NOP ,IMP ,2) OP(83,NOP ,IMP ,1) OP(84,STY ,ZPG ,3) OP(85,STA ,ZPG ,3) OP(86,STX ,ZPG ,3) OP(87,SMB0,ZPG ,5) OP(88,DEY ,IMP ,2) OP(89,BIT ,IMM ,2) OP(8A,TXA ,IMP ,2) OP(8B,NOP ,IMP ,1) OP(8C,STY ,ABS ,4) OP(8D,STA ,ABS ,4) OP(8E,STX ,ABS ,4) OP(8F,BBS0,REL ,5) \
+	OP(90,BCC ,REL ,2) OP(91,STA ,INDY,6) OP(92,STA ,ZPGI,5) OP(93,NOP ,IMP ,1) OP(94,STY ,ZPGX,4) OP(95,STA ,ZPGX,4) OP(96,STX ,ZPGY,4) OP(97,SMB1,ZPG ,5) OP(98,TYA ,IMP ,2) OP(99,STA ,ABSY,5) OP(9A,TXS ,IMP ,2) OP(9B,NOP ,IMP ,1) OP(9C,STZ ,ABS ,4) OP(9D,STA ,ABSX,5) OP(9E,STZ ,ABSX,5) OP(9F,BBS1,REL ,5) \
+	OP(A0,LDY ,IMM ,2) OP(A1,LDA ,INDX,6) OP(A2,LDX ,IMM ,2) OP(A3,NOP ,IMP ,1) OP(A4,LDY ,ZPG ,3) OP(A5,LDA ,ZPG ,3) OP(A6,LDX ,ZPG ,3) OP(A7,SMB2,ZPG ,5) OP(A8,TAY ,IMP ,2) OP(A9,LDA ,IMM ,2) OP(AA,TAX ,IMP ,2) OP(AB,NOP ,IMP ,1) OP(AC,LDY ,ABS ,4) OP(AD,LDA ,ABS ,4) OP(AE,LDX ,ABS ,4) OP(AF,BBS2,REL ,5) \
+	OP(B0,BCS ,REL ,2) OP(B1,LDA ,INDY,5) OP(B2,LDA ,ZPGI,5) OP(B3,NOP ,IMP ,1) OP(B4,LDY ,ZPGX,4) OP(B5,LDA ,ZPGX,4) OP(B6,LDX ,ZPGY,4) OP(B7,SMB3,ZPG ,5) OP(B8,CLV ,IMP ,2) OP(B9,LDA ,ABSY,4) OP(BA,TSX ,IMP ,2) OP(BB,NOP ,IMP ,1) OP(BC,LDY ,ABSX,4) OP(BD,LDA ,ABSX,4) OP(BE,LDX ,ABSY,4) OP(BF,BBS3,REL ,5) \
+	OP(C0,CPY ,IMM ,2) OP(C1,CMP ,INDX,6) OP(C2,NOP ,IMP ,2) OP(C3,NOP ,IMP ,1) OP(C4,CPY ,ZPG ,3) OP(C5,CMP ,ZPG ,3) OP(C6,DEC ,ZPG ,5) OP(C7,SMB4,ZPG ,5) OP(C8,INY ,IMP ,2) OP(C9,CMP ,IMM ,2) OP(CA,DEX ,IMP ,2) OP(CB,WAI ,IMP ,3) OP(CC,CPY ,ABS ,4) OP(CD,CMP ,ABS ,4) OP(CE,DEC ,ABS ,6) OP(CF,BBS4,REL ,5) \
+	OP(D0,BNE ,REL ,2) OP(D1,CMP ,INDY,5) OP(D2,CMP ,ZPGI,5) OP(D3,NOP ,IMP ,1) OP(D4,NOP ,IMP ,4) OP(D5,CMP ,ZPGX,4) OP(D6,DEC ,ZPGX,6) OP(D7,SMB5,ZPG ,5) OP(D8,CLD ,IMP ,2) OP(D9,CMP ,ABSY,4) OP(DA,PHX ,STK ,3) OP(DB,STP ,IMP ,3) OP(DC,NOP ,IMP ,4) OP(DD,CMP ,ABSX,4) OP(DE,DEC ,ABSX,7) OP(DF,BBS5,REL ,5) \
+	OP(E0,CPX ,IMM ,2) OP(E1,SBC ,INDX,6) OP(E2,NOP ,IMP ,2) OP(E3,NOP ,IMP ,1) OP(E4,CPX ,ZPG ,3) OP(E5,SBC ,ZPG ,3) OP(E6,INC ,ZPG ,5) OP(E7,SMB6,ZPG ,5) OP(E8,INX ,IMP ,2) OP(E9,SBC ,IMM ,2) OP(EA,NOP ,IMP ,2) OP(EB,NOP ,IMP ,1) OP(EC,CPX ,ABS ,4) OP(ED,SBC ,ABS ,4) OP(EE,INC ,ABS ,6) OP(EF,BBS6,REL ,5) \
+	OP(F0,BEQ ,REL ,2) OP(F1,SBC ,INDY,5) OP(F2,SBC ,ZPGI,5) OP(F3,NOP ,IMP ,1) OP(F4,NOP ,IMP ,4) OP(F5,SBC ,ZPGX,4) OP(F6,INC ,ZPGX,6) OP(F7,SMB7,ZPG ,5) OP(F8,SED ,IMP ,2) OP(F9,SBC ,ABSY,4) OP(FA,PLX ,STK ,4) OP(FB,NOP ,IMP ,1) OP(FC,NOP ,IMP ,4) OP(FD,SBC ,ABSX,4) OP(FE,INC ,ABSX,7) OP(FF,BBS7,REL ,5)
+#elif defined(ROCKWEL)
+#define OPCODES(OP) \
+	OP(00,BRK ,IMP ,7) OP(01,ORA ,INDX,6) OP(02,XXX ,XXX ,0) OP(03,XXX ,XXX ,0) OP(04,XXX ,XXX ,0) OP(05,ORA ,ZPG ,3) OP(06,ASL ,ZPG ,5) OP(07,RMB0,ZPG ,5) OP(08,PHP ,IMP ,3) OP(09,ORA ,IMM ,2) OP(0A,ASL ,ACC ,2) OP(0B,XXX ,XXX ,0) OP(0C,XXX ,XXX ,0) OP(0D,ORA ,ABS ,4) OP(0E,ASL ,ABS ,6) OP(0F,BBR0,REL ,5) \
+	OP(10,BPL ,REL ,2) OP(11,ORA ,INDY,5) OP(12,XXX ,XXX ,0) OP(13,XXX ,XXX ,0) OP(14,XXX ,XXX ,0) OP(15,ORA ,ZPGX,4) OP(16,ASL ,ZPGX,6) OP(17,RMB1,ZPG ,5) OP(18,CLC ,IMP ,2) OP(19,ORA ,ABSY,4) OP(1A,XXX ,XXX ,0) OP(1B,XXX ,XXX ,0) OP(1C,XXX ,XXX ,0) OP(1D,ORA ,ABSX,4) OP(1E,ASL ,ABSX,7) OP(1F,BBR1,REL ,5) \
+	OP(20,JSR ,ABS ,6) OP(21,AND ,INDX,6) OP(22,XXX ,XXX ,0) OP(23,XXX ,XXX ,0) OP(24,BIT ,ZPG ,3) OP(25,AND ,ZPG ,3) OP(26,ROL ,ZPG ,5) OP(27,RMB2,ZPG ,5) OP(28,PLP ,IMP ,4) OP(29,AND ,IMM ,2) OP(2A,ROL ,ACC ,2) OP(2B,XXX ,XXX ,0) OP(2C,BIT ,ABS ,4) OP(2D,AND ,ABS ,4) OP(2E,ROL ,ABS ,6) OP(2F,BBR2,REL ,5) \
+	OP(30,BMI ,REL ,2) OP(31,AND ,INDY,5) OP(32,XXX ,XXX ,0) OP(33,XXX ,XXX ,0) OP(34,XXX ,XXX ,0) OP(35,AND ,ZPGX,4) OP(36,ROL ,ZPGX,6) OP(37,RMB3,ZPG ,5) OP(38,SEC ,IMP ,2) OP(39,AND ,ABSY,4) OP(3A,XXX ,XXX ,0) OP(3B,XXX ,XXX ,0) OP(3C,XXX ,XXX ,0) OP(3D,AND ,ABSX,4) OP(3E,ROL ,ABSX,7) OP(3F,BBR3,REL ,5) \
+	OP(40,RTI ,IMP ,6) OP(41,EOR ,INDX,6) OP(42,XXX ,XXX ,0) OP(43,XXX ,XXX ,0) OP(44,XXX ,XXX ,0) OP(45,EOR ,ZPG ,3) OP(46,LSR ,ZPG ,5) OP(47,RMB4,ZPG ,5) OP(48,PHA ,IMP ,3) OP(49,EOR ,IMM ,2) OP(4A,LSR ,ACC ,2) OP(4B,XXX ,XXX ,0) OP(4C,JMP ,ABS ,3) OP(4D,EOR ,ABS ,4) OP(4E,LSR ,ABS ,6) OP(4F,BBR4,REL ,5) \
+	OP(50,BVC ,REL ,2) OP(51,EOR ,INDY,5) OP(52,XXX ,XXX ,0) OP(53,XXX ,XXX ,0) OP(54,XXX ,XXX ,0) OP(55,EOR ,ZPGX,4) OP(56,LSR ,ZPGX,6) OP(57,RMB5,ZPG ,5) OP(58,CLI ,IMP ,2) OP(59,EOR ,ABSY,4) OP(5A,XXX ,XXX ,0) OP(5B,XXX ,XXX ,0) OP(5C,XXX ,XXX ,0) OP(5D,EOR ,ABSX,4) OP(5E,LSR ,ABSX,7) OP(5F,BBR5,REL ,5) \
+	OP(60,RTS ,IMP ,6) OP(61,ADC ,INDX,6) OP(62,XXX ,XXX ,0) OP(63,XXX ,XXX ,0) OP(64,XXX ,XXX ,0) OP(65,ADC ,ZPG ,3) OP(66,ROR ,ZPG ,5) OP(67,RMB6,ZPG ,5) OP(68,PLA ,IMP ,4) OP(69,ADC ,IMM ,2) OP(6A,ROR ,ACC ,2) OP(6B,XXX ,XXX ,0) OP(6C,JMP ,IND ,5) OP(6D,ADC ,ABS ,4) OP(6E,ROR ,ABS ,6) OP(6F,BBR6,REL ,5) \
+	OP(70,BVS ,REL ,2) OP(71,ADC ,INDY,5) OP(72,XXX ,XXX ,0) OP(73,XXX ,XXX ,0) OP(74,XXX ,XXX ,0) OP(75,ADC ,ZPGX,4) OP(76,ROR ,ZPGX,6) OP(77,RMB7,ZPG ,5) OP(78,SEI ,IMP ,2) OP(79,ADC ,ABSY,4) OP(7A,XXX ,XXX ,0) OP(7B,XXX ,XXX ,0) OP(7C,XXX ,XXX ,0) OP(7D,ADC ,ABSX,4) OP(7E,ROR ,ABSX,7) OP(7F,BBR7,REL ,5) \
+	\
+	OP(80,XXX ,XXX ,0) OP(81,STA ,INDX,6) OP(82,XXX ,XXX ,0) OP(83,XXX ,XXX ,0) OP(84,STY ,ZPG ,3) OP(85,STA ,ZPG ,3) OP(86,STX ,ZPG ,3) OP(87,SMB0,ZPG ,5) OP(88,DEY ,IMP ,2) OP(89,XXX ,XXX ,0) OP(8A,TXA ,IMP ,2) OP(8B,XXX ,XXX ,0) OP(8C,STY ,ABS ,4) OP(8D,STA ,ABS ,4) OP(8E,STX ,ABS ,4) OP(8F,BBS0,REL ,5) \
+	OP(90,BCC ,REL ,2) OP(91,STA ,INDY,6) OP(92,XXX ,XXX ,0) OP(93,XXX ,XXX ,0) OP(94,STY ,ZPGX,4) OP(95,STA ,ZPGX,4) OP(96,STX ,ZPGY,4) OP(97,SMB1,ZPG ,5) OP(98,TYA ,IMP ,2) OP(99,STA ,ABSY,5) OP(9A,TXS ,IMP ,2) OP(9B,XXX ,XXX ,0) OP(9C,XXX ,XXX ,0) OP(9D,STA ,ABSX,5) OP(9E,XXX ,XXX ,0) OP(9F,BBS1,REL ,5) \
+	OP(A0,LDY ,IMM ,2) OP(A1,LDA ,INDX,6) OP(A2,LDX ,IMM ,2) OP(A3,XXX ,XXX ,0) OP(A4,LDY ,ZPG ,3) OP(A5,LDA ,ZPG ,3) OP(A6,LDX ,ZPG ,3) OP(A7,SMB2,ZPG ,5) OP(A8,TAY ,IMP ,2) OP(A9,LDA ,IMM ,2) OP(AA,TAX ,IMP ,2) OP(AB,XXX ,XXX ,0) OP(AC,LDY ,ABS ,4) OP(AD,LDA ,ABS ,4) OP(AE,LDX ,ABS ,4) OP(AF,BBS2,REL ,5) \
+	OP(B0,BCS ,REL ,2) OP(B1,LDA ,INDY,5) OP(B2,XXX ,XXX ,0) OP(B3,XXX ,XXX ,0) OP(B4,LDY ,ZPGX,4) OP(B5,LDA ,ZPGX,4) OP(B6,LDX ,ZPGY,4) OP(B7,SMB3,ZPG ,5) OP(B8,CLV ,IMP ,2) OP(B9,LDA ,ABSY,4) OP(BA,TSX ,IMP ,2) OP(BB,XXX ,XXX ,0) OP(BC,LDY ,ABSX,4) OP(BD,LDA ,ABSX,4) OP(BE,LDX ,ABSY,4) OP(BF,BBS3,REL ,5) \
+	OP(C0,CPY ,IMM ,2) OP(C1,CMP ,INDX,6) OP(C2,XXX ,XXX ,0) OP(C3,XXX ,XXX ,0) OP(C4,CPY ,ZPG ,3) OP(C5,CMP ,ZPG ,3) OP(C6,DEC ,ZPG ,5) OP(C7,SMB4,ZPG ,5) OP(C8,INY ,IMP ,2) OP(C9,CMP ,IMM ,2) OP(CA,DEX ,IMP ,2) OP(CB,XXX ,XXX ,0) OP(CC,CPY ,ABS ,4) OP(CD,CMP ,ABS ,4) OP(CE,DEC ,ABS ,6) OP(CF,BBS4,REL ,5) \
+	OP(D0,BNE ,REL ,2) OP(D1,CMP ,INDY,5) OP(D2,XXX ,XXX ,0) OP(D3,XXX ,XXX ,0) OP(D4,XXX ,XXX ,0) OP(D5,CMP ,ZPGX,4) OP(D6,DEC ,ZPGX,6) OP(D7,SMB5,ZPG ,5) OP(D8,CLD ,IMP ,2) OP(D9,CMP ,ABSY,4) OP(DA,XXX ,XXX ,0) OP(DB,XXX ,XXX ,0) OP(DC,XXX ,XXX ,0) OP(DD,CMP ,ABSX,4) OP(DE,DEC ,ABSX,7) OP(DF,BBS5,REL ,5) \
+	OP(E0,CPX ,IMM ,2) OP(E1,SBC ,INDX,6) OP(E2,XXX ,XXX ,0) OP(E3,XXX ,XXX ,0) OP(E4,CPX ,ZPG ,3) OP(E5,SBC ,ZPG ,3) OP(E6,INC ,ZPG ,5) OP(E7,SMB6,ZPG ,5) OP(E8,INX ,IMP ,2) OP(E9,SBC ,IMM ,2) OP(EA,NOP ,IMP ,2) OP(EB,XXX ,XXX ,0) OP(EC,CPX ,ABS ,4) OP(ED,SBC ,ABS ,4) OP(EE,INC ,ABS ,6) OP(EF,BBS6,REL ,5) \
+	OP(F0,BEQ ,REL ,2) OP(F1,SBC ,INDY,5) OP(F2,XXX ,XXX ,0) OP(F3,XXX ,XXX ,0) OP(F4,XXX ,XXX ,0) OP(F5,SBC ,ZPGX,4) OP(F6,INC ,ZPGX,6) OP(F7,SMB7,ZPG ,5) OP(F8,SED ,IMP ,2) OP(F9,SBC ,ABSY,4) OP(FA,XXX ,XXX ,0) OP(FB,XXX ,XXX ,0) OP(FC,XXX ,XXX ,0) OP(FD,SBC ,ABSX,4) OP(FE,INC ,ABSX,7) OP(FF,BBS7,REL ,5)
+#else
+#define OPCODES(OP) \
+	OP(00,BRK ,IMP ,7) OP(01,ORA ,INDX,6) OP(02,XXX ,XXX ,0) OP(03,XXX ,XXX ,0) OP(04,XXX ,XXX ,0) OP(05,ORA ,ZPG ,3) OP(06,ASL ,ZPG ,5) OP(07,XXX ,XXX ,0) OP(08,PHP ,IMP ,3) OP(09,ORA ,IMM ,2) OP(0A,ASL ,ACC ,2) OP(0B,XXX ,XXX ,0) OP(0C,XXX ,XXX ,0) OP(0D,ORA ,ABS ,4) OP(0E,ASL ,ABS ,6) OP(0F,XXX ,XXX ,0) \
+	OP(10,BPL ,REL ,2) OP(11,ORA ,INDY,5) OP(12,XXX ,XXX ,0) OP(13,XXX ,XXX ,0) OP(14,XXX ,XXX ,0) OP(15,ORA ,ZPGX,4) OP(16,ASL ,ZPGX,6) OP(17,XXX ,XXX ,0) OP(18,CLC ,IMP ,2) OP(19,ORA ,ABSY,4) OP(1A,XXX ,XXX ,0) OP(1B,XXX ,XXX ,0) OP(1C,XXX ,XXX ,0) OP(1D,ORA ,ABSX,4) OP(1E,ASL ,ABSX,7) OP(1F,XXX ,XXX ,0) \
+	OP(20,JSR ,ABS ,6) OP(21,AND ,INDX,6) OP(22,XXX ,XXX ,0) OP(23,XXX ,XXX ,0) OP(24,BIT ,ZPG ,3) OP(25,AND ,ZPG ,3) OP(26,ROL ,ZPG ,5) OP(27,XXX ,XXX ,0) OP(28,PLP ,IMP ,4) OP(29,AND ,IMM ,2) OP(2A,ROL ,ACC ,2) OP(2B,XXX ,XXX ,0) OP(2C,BIT ,ABS ,4) OP(2D,AND ,ABS ,4) OP(2E,ROL ,ABS ,6) OP(2F,XXX ,XXX ,0) \
+	OP(30,BMI ,REL ,2) OP(31,AND ,INDY,5) OP(32,XXX ,XXX ,0) OP(33,XXX ,XXX ,0) OP(34,XXX ,XXX ,0) OP(35,AND ,ZPGX,4) OP(36,ROL ,ZPGX,6) OP(37,XXX ,XXX ,0) OP(38,SEC ,IMP ,2) OP(39,AND ,ABSY,4) OP(3A,XXX ,XXX ,0) OP(3B,XXX ,XXX ,0) OP(3C,XXX ,XXX ,0) OP(3D,AND ,ABSX,4) OP(3E,ROL ,ABSX,7) OP(3F,XXX ,XXX ,0) \
+	OP(40,RTI ,IMP ,6) OP(41,EOR ,INDX,6) OP(42,XXX ,XXX ,0) OP(43,XXX ,XXX ,0) OP(44,XXX ,XXX ,0) OP(45,EOR ,ZPG ,3) OP(46,LSR ,ZPG ,5) OP(47,XXX ,XXX ,0) OP(48,PHA ,IMP ,3) OP(49,EOR ,IMM ,2) OP(4A,LSR ,ACC ,2) OP(4B,XXX ,XXX ,0) OP(4C,JMP ,ABS ,3) OP(4D,EOR ,ABS ,4) OP(4E,LSR ,ABS ,6) OP(4F,XXX ,XXX ,0) \
+	OP(50,BVC ,REL ,2) OP(51,EOR ,INDY,5) OP(52,XXX ,XXX ,0) OP(53,XXX ,XXX ,0) OP(54,XXX ,XXX ,0) OP(55,EOR ,ZPGX,4) OP(56,LSR ,ZPGX,6) OP(57,XXX ,XXX ,0) OP(58,CLI ,IMP ,2) OP(59,EOR ,ABSY,4) OP(5A,XXX ,XXX ,0) OP(5B,XXX ,XXX ,0) OP(5C,XXX ,XXX ,0) OP(5D,EOR ,ABSX,4) OP(5E,LSR ,ABSX,7) OP(5F,XXX ,XXX ,0) \
+	OP(60,RTS ,IMP ,6) OP(61,ADC ,INDX,6) OP(62,XXX ,XXX ,0) OP(63,XXX ,XXX ,0) OP(64,XXX ,XXX ,0) OP(65,ADC ,ZPG ,3) OP(66,ROR ,ZPG ,5) OP(67,XXX ,XXX ,0) OP(68,PLA ,IMP ,4) OP(69,ADC ,IMM ,2) OP(6A,ROR ,ACC ,2) OP(6B,XXX ,XXX ,0) OP(6C,JMP ,IND ,5) OP(6D,ADC ,ABS ,4) OP(6E,ROR ,ABS ,6) OP(6F,XXX ,XXX ,0) \
+	OP(70,BVS ,REL ,2) OP(71,ADC ,INDY,5) OP(72,XXX ,XXX ,0) OP(73,XXX ,XXX ,0) OP(74,XXX ,XXX ,0) OP(75,ADC ,ZPGX,4) OP(76,ROR ,ZPGX,6) OP(77,XXX ,XXX ,0) OP(78,SEI ,IMP ,2) OP(79,ADC ,ABSY,4) OP(7A,XXX ,XXX ,0) OP(7B,XXX ,XXX ,0) OP(7C,XXX ,XXX ,0) OP(7D,ADC ,ABSX,4) OP(7E,ROR ,ABSX,7) OP(7F,XXX ,XXX ,0) \
+	\
+	OP(80,XXX ,XXX ,0) OP(81,STA ,INDX,6) OP(82,XXX ,XXX ,0) OP(83,XXX ,XXX ,0) OP(84,STY ,ZPG ,3) OP(85,STA ,ZPG ,3) OP(86,STX ,ZPG ,3) OP(87,XXX ,XXX ,0) OP(88,DEY ,IMP ,2) OP(89,XXX ,XXX ,0) OP(8A,TXA ,IMP ,2) OP(8B,XXX ,XXX ,0) OP(8C,STY ,ABS ,4) OP(8D,STA ,ABS ,4) OP(8E,STX ,ABS ,4) OP(8F,XXX ,XXX ,0) \
+	OP(90,BCC ,REL ,2) OP(91,STA ,INDY,6) OP(92,XXX ,XXX ,0) OP(93,XXX ,XXX ,0) OP(94,STY ,ZPGX,4) OP(95,STA ,ZPGX,4) OP(96,STX ,ZPGY,4) OP(97,XXX ,XXX ,0) OP(98,TYA ,IMP ,2) OP(99,STA ,ABSY,5) OP(9A,TXS ,IMP ,2) OP(9B,XXX ,XXX ,0) OP(9C,XXX ,XXX ,0) OP(9D,STA ,ABSX,5) OP(9E,XXX ,XXX ,0) OP(9F,XXX ,XXX ,0) \
+	OP(A0,LDY ,IMM ,2) OP(A1,LDA ,INDX,6) OP(A2,LDX ,IMM ,2) OP(A3,XXX ,XXX ,0) OP(A4,LDY ,ZPG ,3) OP(A5,LDA ,ZPG ,3) OP(A6,LDX ,ZPG ,3) OP(A7,XXX ,XXX ,0) OP(A8,TAY ,IMP ,2) OP(A9,LDA ,IMM ,2) OP(AA,TAX ,IMP ,2) OP(AB,XXX ,XXX ,0) OP(AC,LDY ,ABS ,4) OP(AD,LDA ,ABS ,4) OP(AE,LDX ,ABS ,4) OP(AF,XXX ,XXX ,0) \
+	OP(B0,BCS ,REL ,2) OP(B1,LDA ,INDY,5) OP(B2,XXX ,XXX ,0) OP(B3,XXX ,XXX ,0) OP(B4,LDY ,ZPGX,4) OP(B5,LDA ,ZPGX,4) OP(B6,LDX ,ZPGY,4) OP(B7,XXX ,XXX ,0) OP(B8,CLV ,IMP ,2) OP(B9,LDA ,ABSY,4) OP(BA,TSX ,IMP ,2) OP(BB,XXX ,XXX ,0) OP(BC,LDY ,ABSX,4) OP(BD,LDA ,ABSX,4) OP(BE,LDX ,ABSY,4) OP(BF,XXX ,XXX ,0) \
+	OP(C0,CPY ,IMM ,2) OP(C1,CMP ,INDX,6) OP(C2,XXX ,XXX ,0) OP(C3,XXX ,XXX ,0) OP(C4,CPY ,ZPG ,3) OP(C5,CMP ,ZPG ,3) OP(C6,DEC ,ZPG ,5) OP(C7,XXX ,XXX ,0) OP(C8,INY ,IMP ,2) OP(C9,CMP ,IMM ,2) OP(CA,DEX ,IMP ,2) OP(CB,XXX ,XXX ,0) OP(CC,CPY ,ABS ,4) OP(CD,CMP ,ABS ,4) OP(CE,DEC ,ABS ,6) OP(CF,XXX ,XXX ,0) \
+	OP(D0,BNE ,REL ,2) OP(D1,CMP ,INDY,5) OP(D2,XXX ,XXX ,0) OP(D3,XXX ,XXX ,0) OP(D4,XXX ,XXX ,0) OP(D5,CMP ,ZPGX,4) OP(D6,DEC ,ZPGX,6) OP(D7,XXX ,XXX ,0) OP(D8,CLD ,IMP ,2) OP(D9,CMP ,ABSY,4) OP(DA,XXX ,XXX ,0) OP(DB,XXX ,XXX ,0) OP(DC,XXX ,XXX ,0) OP(DD,CMP ,ABSX,4) OP(DE,DEC ,ABSX,7) OP(DF,XXX ,XXX ,0) \
+	OP(E0,CPX ,IMM ,2) OP(E1,SBC ,INDX,6) OP(E2,XXX ,XXX ,0) OP(E3,XXX ,XXX ,0) OP(E4,CPX ,ZPG ,3) OP(E5,SBC ,ZPG ,3) OP(E6,INC ,ZPG ,5) OP(E7,XXX ,XXX ,0) OP(E8,INX ,IMP ,2) OP(E9,SBC ,IMM ,2) OP(EA,NOP ,IMP ,2) OP(EB,XXX ,XXX ,0) OP(EC,CPX ,ABS ,4) OP(ED,SBC ,ABS ,4) OP(EE,INC ,ABS ,6) OP(EF,XXX ,XXX ,0) \
+	OP(F0,BEQ ,REL ,2) OP(F1,SBC ,INDY,5) OP(F2,XXX ,XXX ,0) OP(F3,XXX ,XXX ,0) OP(F4,XXX ,XXX ,0) OP(F5,SBC ,ZPGX,4) OP(F6,INC ,ZPGX,6) OP(F7,XXX ,XXX ,0) OP(F8,SED ,IMP ,2) OP(F9,SBC ,ABSY,4) OP(FA,XXX ,XXX ,0) OP(FB,XXX ,XXX ,0) OP(FC,XXX ,XXX ,0) OP(FD,SBC ,ABSX,4) OP(FE,INC ,ABSX,7) OP(FF,XXX ,XXX ,0)
+#endif
+	\
+#define OPCODE_ENTRY(code, in, am, cycleCount) [0x##code] = { IN_##in, AM_##am, cycleCount },
+static struct opcode opcodes[256] = {
+	OPCODES(OPCODE_ENTRY)
+};
+#undef OPCODE_ENTRY
+
+static struct addressMode addressModes[ADDRESS_MODE_COUNT] = {
+	[AM_ABS]  = {"abs" },
+#ifdef WDC
+	[AM_ABSI] = {"absi"},
+#endif
+	[AM_ABSX] = {"absx"},
+	[AM_ABSY] = {"absy"},
+	[AM_ACC]  = {"acc" },
+	[AM_IMM]  = {"imm" },
+	[AM_IMP]  = {"imp" },
+	[AM_IND]  = {"ind" },
+	[AM_INDX] = {"indx"},
+	[AM_INDY] = {"indy"},
+	[AM_REL]  = {"rel" },
+#ifdef WDC
+	[AM_STK]  = {"stk" },
+#endif
+	[AM_ZPG]  = {"zpg" },
+#ifdef WDC
+	[AM_ZPGI] = {"zpgi"},
+#endif
+	[AM_ZPGX] = {"zpgx"},
+	[AM_ZPGY] = {"zpgy"},
+
+#ifndef WDC
+	[AM_XXX]  = {"xxx" },
+#endif
+};
+
+static struct instruction instructions[INSTRUCTION_COUNT] = {
+	[IN_ADC]  = {"adc" },
+	[IN_AND]  = {"and" },
+	[IN_ASL]  = {"asl" },
+#ifdef ROCKWEL
+	[IN_BBR0] = {"bbr0"},
+	[IN_BBR1] = {"bbr1"},
+	[IN_BBR2] = {"bbr2"},
+	[IN_BBR3] = {"bbr3"},
+	[IN_BBR4] = {"bbr4"},
+	[IN_BBR5] = {"bbr5"},
+	[IN_BBR6] = {"bbr6"},
+	[IN_BBR7] = {"bbr7"},
+#endif
+#ifdef ROCKWEL
+	[IN_BBS0] = {"bbs0"},
+	[IN_BBS1] = {"bbs1"},
+	[IN_BBS2] = {"bbs2"},
+	[IN_BBS3] = {"bbs3"},
+	[IN_BBS4] = {"bbs4"},
+	[IN_BBS5] = {"bbs5"},
+	[IN_BBS6] = {"bbs6"},
+	[IN_BBS7] = {"bbs7"},
+#endif
+	[IN_BCC]  = {"bcc" },
+	[IN_BCS]  = {"bcs" },
+	[IN_BEQ]  = {"beq" },
+	[IN_BIT]  = {"bit" },
+	[IN_BMI]  = {"bmi" },
+	[IN_BNE]  = {"bne" },
+	[IN_BPL]  = {"bpl" },
+#ifdef WDC
+	[IN_BRA]  = {"bra" },
+#endif
+	[IN_BRK]  = {"brk" },
+	[IN_BVC]  = {"bvc" },
+	[IN_BVS]  = {"bvs" },
+	[IN_CLC]  = {"clc" },
+	[IN_CLD]  = {"cld" },
+	[IN_CLI]  = {"cli" },
+	[IN_CLV]  = {"clv" },
+	[IN_CMP]  = {"cmp" },
+	[IN_CPX]  = {"cpx" },
+	[IN_CPY]  = {"cpy" },
+	[IN_DEC]  = {"dec" },
+	[IN_DEX]  = {"dex" },
+	[IN_DEY]  = {"dey" },
+	[IN_EOR]  = {"eor" },
+	[IN_INC]  = {"inc" },
+	[IN_INX]  = {"inx" },
+	[IN_INY]  = {"iny" },
+	[IN_JMP]  = {"jmp" },
+	[IN_JSR]  = {"jsr" },
+	[IN_LDA]  = {"lda" },
+	[IN_LDX]  = {"ldx" },
+	[IN_LDY]  = {"ldy" },
+	[IN_LSR]  = {"lsr" },
+	[IN_NOP]  = {"nop" },
+	[IN_ORA]  = {"ora" },
+	[IN_PHA]  = {"pha" },
+	[IN_PHP]  = {"php" },
+#ifdef WDC
+	[IN_PHX]  = {"phx" },
+#endif
+#ifdef WDC
+	[IN_PHY]  = {"phy" },
+#endif
+	[IN_PLA]  = {"pla" },
+	[IN_PLP]  = {"plp" },
+#ifdef WDC
+	[IN_PLX]  = {"plx" },
+#endif
+#ifdef WDC
+	[IN_PLY]  = {"ply" },
+#endif
+#ifdef ROCKWEL
+	[IN_RMB0] = {"rmb0"},
+	[IN_RMB1] = {"rmb1"},
+	[IN_RMB2] = {"rmb2"},
+	[IN_RMB3] = {"rmb3"},
+	[IN_RMB4] = {"rmb4"},
+	[IN_RMB5] = {"rmb5"},
+	[IN_RMB6] = {"rmb6"},
+	[IN_RMB7] = {"rmb7"},
+#endif
+	[IN_ROL]  = {"rol" },
+	[IN_ROR]  = {"ror" },
+	[IN_RTI]  = {"rti" },
+	[IN_RTS]  = {"rts" },
+	[IN_SBC]  = {"sbc" },
+	[IN_SEC]  = {"sec" },
+	[IN_SED]  = {"sed" },
+	[IN_SEI]  = {"sei" },
+#ifdef ROCKWEL
+	[IN_SMB0] = {"smb0"},
+	[IN_SMB1] = {"smb1"},
+	[IN_SMB2] = {"smb2"},
+	[IN_SMB3] = {"smb3"},
+	[IN_SMB4] = {"smb4"},
+	[IN_SMB5] = {"smb5"},
+	[IN_SMB6] = {"smb6"},
+	[IN_SMB7] = {"smb7"},
+#endif
+	[IN_STA]  = {"sta" },
+#ifdef WDC
+	[IN_STP]  = {"stp" },
+#endif
+	[IN_STX]  = {"stx" },
+	[IN_STY]  = {"sty" },
+#ifdef WDC
+	[IN_STZ]  = {"stz" },
+#endif
+	[IN_TAX]  = {"tax" },
+	[IN_TAY]  = {"tay" },
+#ifdef WDC
+	[IN_TRB]  = {"trb" },
+#endif
+#ifdef WDC
+	[IN_TSB]  = {"tsb" },
+#endif
+	[IN_TSX]  = {"tsx" },
+	[IN_TXA]  = {"txa" },
+	[IN_TXS]  = {"txs" },
+	[IN_TYA]  = {"tya" },
+#ifdef WDC
+	[IN_WAI]  = {"wai" },
+#endif
+#ifndef WDC
+	[IN_XXX]  = {"xxx" },
+#endif
+};
+
+// functions implementing every addressing mode and instruction
+// these are used to generate the opcode handlers, calling the implementation directly
+#define AM_FUNC_ABS   am_abs
+#ifdef WDC
+#define AM_FUNC_ABSI  am_absi
+#endif
+#define AM_FUNC_ABSX  am_absx
+#define AM_FUNC_ABSY  am_absy
+#define AM_FUNC_ACC   am_imp
+#define AM_FUNC_IMM   am_imm
+#define AM_FUNC_IMP   am_imp
+#define AM_FUNC_IND   am_ind
+#define AM_FUNC_INDX  am_indx
+#define AM_FUNC_INDY  am_indy
+#define AM_FUNC_REL   am_rel
+#ifdef WDC
+#define AM_FUNC_STK   am_imp
+#endif
+#define AM_FUNC_ZPG   am_zpg
+#ifdef WDC
+#define AM_FUNC_ZPGI  am_zpgi
+#endif
+#define AM_FUNC_ZPGX  am_zpgx
+#define AM_FUNC_ZPGY  am_zpgy
+#ifndef WDC
+#define AM_FUNC_XXX   am_xxx
+#endif
+
+#define IN_FUNC_ADC   in_adc
+#define IN_FUNC_AND   in_and
+#define IN_FUNC_ASL   in_asl
+#ifdef ROCKWEL
+#define IN_FUNC_BBR0  in_bbr0
+#define IN_FUNC_BBR1  in_bbr1
+#define IN_FUNC_BBR2  in_bbr2
+#define IN_FUNC_BBR3  in_bbr3
+#define IN_FUNC_BBR4  in_bbr4
+#define IN_FUNC_BBR5  in_bbr5
+#define IN_FUNC_BBR6  in_bbr6
+#define IN_FUNC_BBR7  in_bbr7
+#endif
+#ifdef ROCKWEL
+#define IN_FUNC_BBS0  in_bbs0
+#define IN_FUNC_BBS1  in_bbs1
+#define IN_FUNC_BBS2  in_bbs2
+#define IN_FUNC_BBS3  in_bbs3
+#define IN_FUNC_BBS4  in_bbs4
+#define IN_FUNC_BBS5  in_bbs5
+#define IN_FUNC_BBS6  in_bbs6
+#define IN_FUNC_BBS7  in_bbs7
+#endif
+#define IN_FUNC_BCC   in_bcc
+#define IN_FUNC_BCS   in_bcs
+#define IN_FUNC_BEQ   in_beq
+#define IN_FUNC_BIT   in_bit
+#define IN_FUNC_BMI   in_bmi
+#define IN_FUNC_BNE   in_bne
+#define IN_FUNC_BPL   in_bpl
+#ifdef WDC
+#define IN_FUNC_BRA   in_bra
+#endif
+#define IN_FUNC_BRK   in_brk
+#define IN_FUNC_BVC   in_bvc
+#define IN_FUNC_BVS   in_bvs
+#define IN_FUNC_CLC   in_clc
+#define IN_FUNC_CLD   in_cld
+#define IN_FUNC_CLI   in_cli
+#define IN_FUNC_CLV   in_clv
+#define IN_FUNC_CMP   in_cmp
+#define IN_FUNC_CPX   in_cpx
+#define IN_FUNC_CPY   in_cpy
+#define IN_FUNC_DEC   in_dec
+#define IN_FUNC_DEX   in_dex
+#define IN_FUNC_DEY   in_dey
+#define IN_FUNC_EOR   in_eor
+#define IN_FUNC_INC   in_inc
+#define IN_FUNC_INX   in_inx
+#define IN_FUNC_INY   in_iny
+#define IN_FUNC_JMP   in_jmp
+#define IN_FUNC_JSR   in_jsr
+#define IN_FUNC_LDA   in_lda
+#define IN_FUNC_LDX   in_ldx
+#define IN_FUNC_LDY   in_ldy
+#define IN_FUNC_LSR   in_lsr
+#define IN_FUNC_NOP   in_nop
+#define IN_FUNC_ORA   in_ora
+#define IN_FUNC_PHA   in_pha
+#define IN_FUNC_PHP   in_php
+#ifdef WDC
+#define IN_FUNC_PHX   in_phx
+#endif
+#ifdef WDC
+#define IN_FUNC_PHY   in_phy
+#endif
+#define IN_FUNC_PLA   in_pla
+#define IN_FUNC_PLP   in_plp
+#ifdef WDC
+#define IN_FUNC_PLX   in_plx
+#endif
+#ifdef WDC
+#define IN_FUNC_PLY   in_ply
+#endif
+#ifdef ROCKWEL
+#define IN_FUNC_RMB0  in_rmb0
+#define IN_FUNC_RMB1  in_rmb1
+#define IN_FUNC_RMB2  in_rmb2
+#define IN_FUNC_RMB3  in_rmb3
+#define IN_FUNC_RMB4  in_rmb4
+#define IN_FUNC_RMB5  in_rmb5
+#define IN_FUNC_RMB6  in_rmb6
+#define IN_FUNC_RMB7  in_rmb7
+#endif
+#define IN_FUNC_ROL   in_rol
+#define IN_FUNC_ROR   in_ror
+#define IN_FUNC_RTI   in_rti
+#define IN_FUNC_RTS   in_rts
+#define IN_FUNC_SBC   in_sbc
+#define IN_FUNC_SEC   in_sec
+#define IN_FUNC_SED   in_sed
+#define IN_FUNC_SEI   in_sei
+#ifdef ROCKWEL
+#define IN_FUNC_SMB0  in_smb0
+#define IN_FUNC_SMB1  in_smb1
+#define IN_FUNC_SMB2  in_smb2
+#define IN_FUNC_SMB3  in_smb3
+#define IN_FUNC_SMB4  in_smb4
+#define IN_FUNC_SMB5  in_smb5
+#define IN_FUNC_SMB6  in_smb6
+#define IN_FUNC_SMB7  in_smb7
+#endif
+#define IN_FUNC_STA   in_sta
+#ifdef WDC
+#define IN_FUNC_STP   in_stp
+#endif
+#define IN_FUNC_STX   in_stx
+#define IN_FUNC_STY   in_sty
+#ifdef WDC
+#define IN_FUNC_STZ   in_stz
+#endif
+#define IN_FUNC_TAX   in_tax
+#define IN_FUNC_TAY   in_tay
+#ifdef WDC
+#define IN_FUNC_TRB   in_trb
+#endif
+#ifdef WDC
+#define IN_FUNC_TSB   in_tsb
+#endif
+#define IN_FUNC_TSX   in_tsx
+#define IN_FUNC_TXA   in_txa
+#define IN_FUNC_TXS   in_txs
+#define IN_FUNC_TYA   in_tya
+#ifdef WDC
+#define IN_FUNC_WAI   in_wai
+#endif
+#ifndef WDC
+#define IN_FUNC_XXX   in_xxx
+#endif
+
+#pragma endregion data
+
+#pragma region execution
+
+#if (defined(__GNUC__) || defined(__clang__)) && !defined(NO_COMPUTED_GOTO)
+#define COMPUTED_GOTO
+#endif
+
+// every opcode gets its own handler, generated from the opcode table
+// the addressing mode and instruction of a handler are known, so both get inlined and specialized
+// OPERANDS selects where the handler reads its operand bytes from
+#define OPCODE_HANDLER(code, in, am, cycleCount) \
+	HANDLER(code) { \
+		struct operation op = { .opcode = 0x##code, .instruction = IN_##in, .addressMode = AM_##am, OPERANDS }; \
+		cpu->cycles = cycleCount; \
+		AM_FUNC_##am(cpu, &op); \
+		IN_FUNC_##in(cpu, &op); \
+		cpu->totalCycles += cpu->cycles; \
+	} \
+	NEXT();
+
+// executes up to count instructions back to back, fetching and decoding every instruction from the bus
+// stops early once totalCycles reached endCycle, or the control inputs need to be handled
+// the cycles of every instruction are added to totalCycles, cycles holds the cycles of the last instruction
+// with computed goto every handler jumps directly to the next handler, otherwise a switch is used
+static void interpret(cpu_t* cpu, size_t count, uint64_t endCycle) {
+	uint8_t opcode;
+
+#define FETCH() if (!fetchOpcode(cpu, &opcode)) return; cpu->instructionCount++
+#define OPERANDS .decoded = false, .operands = NULL
+
+#ifdef COMPUTED_GOTO
+#define OPCODE_LABEL(code, in, am, cycleCount) [0x##code] = &&op_##code,
+	static void* const handlers[256] = { OPCODES(OPCODE_LABEL) };
+#undef OPCODE_LABEL
+
+#define HANDLER(code) op_##code:
+#define NEXT() if (count-- == 0 || cpu->totalCycles >= endCycle || CONTROL_PENDING(cpu)) return; FETCH(); goto *handlers[opcode]
+
+	NEXT();
+	OPCODES(OPCODE_HANDLER)
+#else
+#define HANDLER(code) case 0x##code:
+#define NEXT() continue
+
+	while (count-- > 0 && cpu->totalCycles < endCycle && !CONTROL_PENDING(cpu)) {
+		FETCH();
+		switch (opcode) {
+		OPCODES(OPCODE_HANDLER)
+		}
+	}
+#endif
+
+#undef HANDLER
+#undef NEXT
+#undef OPERANDS
+#undef FETCH
+}
+
+// same as interpret, recording every instruction in the trace of the cpu
+// the state before the instruction is read silently, the bus accesses of the instruction itself are added by the observer of the bus
+static void interpretTraced(cpu_t* cpu, size_t count, uint64_t endCycle) {
+	while (count-- > 0 && cpu->totalCycles < endCycle && !CONTROL_PENDING(cpu)) {
+		const uint16_t pc = cpu->registers.PC;
+		const traceRecord_t state = {
+			.cycle = cpu->totalCycles,
+			.PC = pc,
+			.opcode = bus_get(cpu->bus, pc),
+			.operands = { bus_get(cpu->bus, pc + 1), bus_get(cpu->bus, pc + 2) },
+			.A = cpu->registers.A,
+			.X = cpu->registers.X,
+			.Y = cpu->registers.Y,
+			.flags = packFlags(cpu),
+			.SP = cpu->registers.SP,
+		};
+
+		trace_begin(cpu->trace, &state);
+		interpret(cpu, 1, UINT64_MAX);
+		trace_end(cpu->trace);
+	}
+}
+
+// same as interpret, counting every instruction in the profile of the cpu
+// cycles holds the cycles of the instruction that just ran, including those added by its addressing mode and branches
+static void interpretProfiled(cpu_t* cpu, size_t count, uint64_t endCycle) {
+	profile_t* profile = cpu->profile;
+
+	while (count-- > 0 && cpu->totalCycles < endCycle && !CONTROL_PENDING(cpu)) {
+		const uint16_t pc = cpu->registers.PC;
+		const uint8_t sp = cpu->registers.SP;
+		const uint8_t opcode = bus_get(cpu->bus, pc);
+
+		// an interrupt, reset or a change from outside moved the cpu since the last instruction
+		if (profile->depth == 0 || pc != profile->nextPC || sp != profile->nextSP)
+			profile_jump(profile, pc, sp);
+
+		interpret(cpu, 1, UINT64_MAX);
+
+		const uint8_t cycles = (uint8_t) cpu->cycles;
+		profile_count(profile, pc, opcode, cycles, cycles - opcodes[opcode].cycleCount);
+		// BRK, JSR, RTI and RTS
+		if ((opcode & 0x9F) == 0x00)
+			profile_flow(profile, opcode, cpu->registers.PC, sp, cpu->registers.SP);
+
+		profile->nextPC = cpu->registers.PC;
+		profile->nextSP = cpu->registers.SP;
+	}
+}
+
+// executes up to count instructions of a decoded block, starting at its first instruction
+// the same stop conditions as interpret apply, it also stops when the block became stale by a write to its page
+// every stop leaves PC pointing at the next instruction to run, inside or after the block
+static void executeBlock(cpu_t* cpu, const struct block* block, size_t count, uint64_t endCycle) {
+	const struct microOp* uop = block->ops;
+	const struct microOp* const end = block->ops + (count < block->length ? count : block->length);
+	// the bus stays the same while the block runs, only the generation of its page can change, by a write of this thread
+	const uint32_t* const generation = &cpu->bus->codeGenerations[block->start >> BUS_PAGE_BITS];
+	const uint8_t* operands;
+	uint8_t opcode;
+
+#define STALE() (*generation != block->generation)
+#define FETCH() cpu->instructionCount++; cpu->registers.PC++; opcode = uop->opcode; operands = uop->operands; uop++
+#define OPERANDS .decoded = true, .operands = operands
+
+#ifdef COMPUTED_GOTO
+#define OPCODE_LABEL(code, in, am, cycleCount) [0x##code] = &&op_##code,
+	static void* const handlers[256] = { OPCODES(OPCODE_LABEL) };
+#undef OPCODE_LABEL
+
+#define HANDLER(code) op_##code:
+#define NEXT() if (uop == end || cpu->totalCycles >= endCycle || CONTROL_PENDING(cpu) || STALE()) return; FETCH(); goto *handlers[opcode]
+
+	NEXT();
+	OPCODES(OPCODE_HANDLER)
+#else
+#define HANDLER(code) case 0x##code:
+#define NEXT() continue
+
+	while (uop != end && cpu->totalCycles < endCycle && !CONTROL_PENDING(cpu) && !STALE()) {
+		FETCH();
+		switch (opcode) {
+		OPCODES(OPCODE_HANDLER)
+		}
+	}
+#endif
+
+#undef HANDLER
+#undef NEXT
+#undef OPERANDS
+#undef FETCH
+#undef STALE
+}
+
+#undef OPCODE_HANDLER
+
+// size of the instruction starting with opcode, in bytes
+static uint8_t instructionLength(const uint8_t opcode) {
+	switch (opcodes[opcode].addressMode) {
+	case AM_ABS:
+#ifdef WDC
+	case AM_ABSI:
+#endif
+	case AM_ABSX: case AM_ABSY:
+	case AM_IND:
+		return 3;
+	case AM_IMM:
+	case AM_INDX: case AM_INDY:
+	case AM_ZPG:
+#ifdef WDC
+	case AM_ZPGI:
+#endif
+	case AM_ZPGX: case AM_ZPGY:
+		return 2;
+	case AM_REL:
+#ifdef ROCKWEL
+		// branch on bit instructions also take a zero page address
+		if ((opcode & 0x0F) == 0x0F)
+			return 3;
+#endif
+		return 2;
+	default:
+#ifdef WDC
+		if (opcodes[opcode].instruction == IN_NOP)
+			return 1 + nopOperandBytes(opcode);
+#endif
+		return 1;
+	}
+}
+
+// true if the instruction could continue anywhere else than the next instruction
+static bool endsBlock(const uint8_t opcode) {
+	if (opcodes[opcode].addressMode == AM_REL)
+		return true;
+
+	switch (opcodes[opcode].instruction) {
+#ifndef WDC
+	case IN_XXX:
+#endif
+	case IN_BRK: case IN_JSR: case IN_JMP:
+	case IN_RTI: case IN_RTS:
+#ifdef WDC
+	case IN_STP: case IN_WAI:
+#endif
+		return true;
+	default:
+		return false;
+	}
+}
+
+// true if memory at fullAddr is read without going through a device
+static bool isPlainMemory(const cpu_t* cpu, const uint16_t fullAddr) {
+	return cpu->bus->pages[fullAddr >> BUS_PAGE_BITS].read != NULL;
+}
+
+// true if the instruction only reads memory, and changes nothing but the registers
+// a memory operand needs to be plain memory, a device could return something else on every read
+static bool onlyReads(const cpu_t* cpu, const struct microOp* uop) {
+	const struct opcode opcode = opcodes[uop->opcode];
+
+	switch (opcode.instruction) {
+	case IN_NOP:
+	case IN_ADC: case IN_SBC:
+	case IN_AND: case IN_EOR: case IN_ORA:
+	case IN_BIT: case IN_CMP: case IN_CPX: case IN_CPY:
+	case IN_LDA: case IN_LDX: case IN_LDY:
+		break;
+	case IN_INX: case IN_INY: case IN_DEX: case IN_DEY:
+	case IN_TAX: case IN_TAY: case IN_TSX:
+	case IN_TXA: case IN_TYA: case IN_TXS:
+	case IN_CLC: case IN_CLD: case IN_CLV:
+	case IN_SEC: case IN_SED:
+		return true;
+	case IN_ASL: case IN_LSR: case IN_ROL: case IN_ROR:
+		return opcode.addressMode == AM_ACC;
+	default:
+		return false;
+	}
+
+	switch (opcode.addressMode) {
+	case AM_IMM: case AM_IMP: case AM_ACC:
+		return true;
+	case AM_ZPG:
+		return isPlainMemory(cpu, uop->operands[0]);
+	case AM_ABS:
+		return isPlainMemory(cpu, uop->operands[0] | (uop->operands[1] << 8));
+	default:
+		return false;
+	}
+}
+
+// true if the block loops back to its start, and its instructions only read memory
+// nothing else writes that memory while the loop runs, so once an iteration leaves the registers unchanged, all following iterations do as well
+static bool isPollingLoop(const cpu_t* cpu, const struct block* block) {
+	uint16_t pc = block->start;
+	for (uint8_t i = 0; i + 1 < block->length; i++) {
+		if (!onlyReads(cpu, block->ops + i))
+			return false;
+		pc += instructionLength(block->ops[i].opcode);
+	}
+
+	const struct microOp* last = block->ops + block->length - 1;
+	const uint16_t next = pc + instructionLength(last->opcode);
+
+	if (opcodes[last->opcode].instruction == IN_JMP && opcodes[last->opcode].addressMode == AM_ABS)
+		return (last->operands[0] | (last->operands[1] << 8)) == block->start;
+
+	if (opcodes[last->opcode].addressMode != AM_REL)
+		return false;
+
+#ifdef ROCKWEL
+	if ((last->opcode & 0x0F) == 0x0F)
+		return isPlainMemory(cpu, last->operands[0]) && (uint16_t) (next + (int8_t) last->operands[1]) == block->start;
+#endif
+
+	return (uint16_t) (next + (int8_t) last->operands[0]) == block->start;
+}
+
+// decodes the block starting at start
+// code is only decoded from memory the bus hands out directly, reading it through the device functions could have side effects
+// returns false if not a single instruction could be decoded
+static bool decodeBlock(cpu_t* cpu, struct block* block, const uint16_t start) {
+	// pages holding a breakpoint are never decoded, so only the interpreter has to check for them
+	const uint8_t* memory = cpu->bus->pages[start >> BUS_PAGE_BITS].fetch;
+	if (memory == NULL)
+		return false;
+
+	size_t offset = start & BUS_PAGE_MASK;
+	uint8_t length = 0;
+	// the memory of the next page isn't necessarily behind this one
+	while (length < BLOCK_MAX_LENGTH && offset < BUS_PAGE_SIZE) {
+		const uint8_t opcode = memory[offset];
+		const uint8_t size = instructionLength(opcode);
+		if (offset + size > BUS_PAGE_SIZE)
+			break;
+
+		struct microOp* uop = block->ops + length++;
+		uop->opcode = opcode;
+		for (uint8_t i = 1; i < size; i++)
+			uop->operands[i - 1] = memory[offset + i];
+		offset += size;
+
+		if (endsBlock(opcode))
+			break;
+	}
+
+	if (length == 0)
+		return false;
+
+	block->start = start;
+	block->length = length;
+	block->generation = bus_watchCode(cpu->bus, start);
+	block->executions = 0;
+	block->translated = false;
+	block->code = NULL;
+	block->chain = NULL;
+	block->polls = isPollingLoop(cpu, block);
+
+	return true;
+}
+
+// true if the memory of a stale block still holds the instructions it was decoded from
+// a write anywhere in its page makes a block stale, but mostly it went to data next to the code
+static bool isUnchanged(const cpu_t* cpu, const struct block* block) {
+	const uint8_t* memory = cpu->bus->pages[block->start >> BUS_PAGE_BITS].fetch;
+	if (memory == NULL)
+		return false;
+
+	size_t offset = block->start & BUS_PAGE_MASK;
+	for (uint8_t i = 0; i < block->length; i++) {
+		const struct microOp* uop = block->ops + i;
+		const uint8_t size = instructionLength(uop->opcode);
+		if (memory[offset] != uop->opcode)
+			return false;
+		for (uint8_t j = 1; j < size; j++)
+			if (memory[offset + j] != uop->operands[j - 1])
+				return false;
+		offset += size;
+	}
+
+	return true;
+}
+
+// returns the block starting at pc, decoding it if it isn't cached or changed
+// with the jit enabled, blocks get translated once they ran often enough
+// returns NULL if the code at pc can't be decoded
+static struct block* findBlock(cpu_t* cpu, const uint16_t pc) {
+	struct block* block = cpu->blockCache->blocks + (pc & (BLOCK_CACHE_SIZE - 1));
+	if (block->length && block->start == pc && (block->generation == bus_codeGeneration(cpu->bus, pc) || isUnchanged(cpu, block))) {
+		// a stale block that didn't change keeps its translation, the page could be mapped differently now though
+		if (block->generation != bus_codeGeneration(cpu->bus, pc)) {
+			block->generation = bus_watchCode(cpu->bus, pc);
+			block->polls = isPollingLoop(cpu, block);
+			if (block->polls)
+				block->code = block->chain = NULL;
+		}
+
+		cpu->blockHits++;
+#ifdef JIT_X86_64
+		if (cpu->jit && !block->translated && ++block->executions >= JIT_THRESHOLD)
+			translateBlock(cpu, block);
+#endif
+		return block;
+	}
+
+	cpu->blockMisses++;
+	if (!decodeBlock(cpu, block, pc)) {
+		block->length = 0;
+		block->chain = NULL;
+		return NULL;
+	}
+
+	return block;
+}
+
+// lets a cpu spinning in a loop it can't leave on its own skip whole iterations at once
+// the loop starts at PC, and an iteration runs length instructions in cycles cycles
+// only the iterations which would have started before count instructions, endCycle or the next event are skipped, the rest runs as usual
+// an event could change what the loop reads, or get the cpu out of it through a control input
+// a pending control input gets the cpu out of the loop, so then nothing is skipped
+// memory written by the host while the iterations are skipped is not seen by them, only by the iterations after
+static void skipIdleLoop(cpu_t* cpu, const cpuIdle_t kind, const uint8_t length, const uint64_t cycles, const size_t count, uint64_t endCycle) {
+	cpu->idle = kind;
+	cpu->idleAddress = cpu->registers.PC;
+
+	if (cpu->scheduler && scheduler_next(cpu->scheduler) < endCycle)
+		endCycle = scheduler_next(cpu->scheduler);
+
+	if (CONTROL_PENDING(cpu) || cycles == 0 || cpu->totalCycles >= endCycle)
+		return;
+
+	uint64_t iterations = (endCycle - cpu->totalCycles) / cycles;
+	if (iterations > count / length)
+		iterations = count / length;
+
+	cpu->totalCycles += iterations * cycles;
+	cpu->skippedCycles += iterations * cycles;
+	cpu->instructionCount += iterations * length;
+}
+
+// translated code continues into the next translated block while totalCycles is below jitDeadline
+// it is set so that neither count instructions nor endCycle can be overshot by one more block
+// as every instruction takes at least a cycle, the instructions are covered by the cycles as well
+// cpu_requestStop clears it, returns false if a stop was requested before it was set
+static bool setDeadline(cpu_t* cpu, const size_t count, const uint64_t endCycle) {
+	uint64_t deadline = endCycle > BLOCK_MAX_CYCLES ? endCycle - BLOCK_MAX_CYCLES : 0;
+	if (count <= BLOCK_MAX_LENGTH)
+		deadline = 0;
+	else if (deadline > cpu->totalCycles && count - BLOCK_MAX_LENGTH < deadline - cpu->totalCycles)
+		deadline = cpu->totalCycles + (count - BLOCK_MAX_LENGTH);
+
+	atomic_store(&cpu->jitDeadline, deadline);
+	return !atomic_load(&cpu->stopRequested);
+}
+
+// executes up to count instructions from the block cache, using translated code when it is available
+// stops under the same conditions as interpret
+static void executeBlocks(cpu_t* cpu, size_t count, uint64_t endCycle) {
+	if (cpu->jit && !setDeadline(cpu, count, endCycle))
+		return;
+
+	while (count > 0 && cpu->totalCycles < endCycle && !CONTROL_PENDING(cpu)) {
+		const size_t startCount = cpu->instructionCount;
+
+		const struct block* block = findBlock(cpu, cpu->registers.PC);
+		if (block == NULL)
+			interpret(cpu, 1, endCycle);
+		else {
+			// translated code doesn't check the stop conditions, so it only runs if it can't overshoot them
+			// every translated block it continues into is covered by jitDeadline, see emitChain
+			if (block->code && count >= block->codeLength && endCycle - cpu->totalCycles > block->codeCycles) {
+				// translated code works on the flags register
+				cpu->registers.flags.byte = packFlags(cpu);
+				block->code(cpu);
+				unpackFlags(cpu, cpu->registers.flags.byte);
+				cpu_updateIrq(cpu);
+			}
+			// translated code can leave before its first instruction, when it runs into something only the interpreter handles
+			if (cpu->instructionCount == startCount) {
+				if (block->polls) {
+					const struct regs before = cpu->registers;
+					const uint8_t flagsBefore = packFlags(cpu);
+					const uint64_t startCycle = cpu->totalCycles;
+
+					executeBlock(cpu, block, count, endCycle);
+
+					// a whole iteration that changed nothing makes the loop endless
+					if (cpu->instructionCount - startCount == block->length && cpu->registers.PC == block->start &&
+						cpu->registers.A == before.A && cpu->registers.X == before.X && cpu->registers.Y == before.Y &&
+						cpu->registers.SP == before.SP && packFlags(cpu) == flagsBefore)
+						skipIdleLoop(cpu, CPU_IDLE_POLL, block->length, cpu->totalCycles - startCycle, count - block->length, endCycle);
+				} else
+					executeBlock(cpu, block, count, endCycle);
+			}
+		}
+
+		count -= cpu->instructionCount - startCount;
+	}
+}
+
+// executes up to count instructions, using the block cache and translated code if they are enabled
+// stops under the same conditions as interpret
+static void execute(cpu_t* cpu, size_t count, uint64_t endCycle) {
+	// the instructions keep N, Z, C and V in lazyFlags, outside of execute the flags register holds them
+	unpackFlags(cpu, cpu->registers.flags.byte);
+	// the interrupt flag could have been changed from outside
+	cpu_updateIrq(cpu);
+
+	const size_t startCount = cpu->instructionCount;
+	if (cpu->trace)
+		interpretTraced(cpu, count, endCycle);
+	else if (cpu->profile)
+		interpretProfiled(cpu, count, endCycle);
+	else if (cpu->blockCache == NULL)
+		interpret(cpu, count, endCycle);
+	else
+		executeBlocks(cpu, count, endCycle);
+
+	// the last instruction jumped or branched to itself, cycles still holds its cycles
+	if (cpu->pendingControl & PENDING_IDLE) {
+		cpu->pendingControl &= ~PENDING_IDLE;
+		skipIdleLoop(cpu, CPU_IDLE_TRAP, 1, (uint64_t) cpu->cycles, count - (cpu->instructionCount - startCount), endCycle);
+	}
+
+	cpu->registers.flags.byte = packFlags(cpu);
+}
+
+#pragma endregion execution
+
+#ifdef JIT_X86_64
+#pragma region translation
+// hot blocks get translated to x86-64 code
+// the 6502 registers stay in host registers for the whole block, memory is accessed through the page table of the bus
+// only pages without memory behind them go through the device functions
+// after such a call the block is left at the next instruction, as the device could have changed anything
+// rarely used instructions are left to the interpreter
+
+// host registers holding the cpu state and the page table of its bus
+// all of them are callee saved except the stack pointer, which is kept in the frame while a device function runs
+#define J_CPU JIT_RBX
+#define J_PAGES JIT_R15
+#define J_A JIT_R12
+#define J_X JIT_R13
+#define J_Y JIT_R14
+#define J_SP JIT_R8
+#define J_P JIT_RBP
+
+// stack frame of a translated block
+// SLOT_CALLED is set once a device function has been called
+// SLOT_PENALTY is set when an indexed address crossed a page, every instruction indexing an address clears it first
+#define SLOT_CALLED 0
+#define SLOT_PENALTY 1
+#define SLOT_SP 4
+#define SLOT_ADDRESS 8
+#define SLOT_TEMP 16
+#define FRAME_SIZE 24
+
+#define CPU_FIELD(member) ((int32_t) offsetof(cpu_t, member))
+#define BLOCK_FIELD(member) ((int32_t) offsetof(struct block, member))
+// relative to J_PAGES, the code generations follow the page table in the bus
+#define PAGE_ENTRY(page) ((int32_t) ((page) * sizeof(page_t)))
+#define CODE_GENERATION(page) ((int32_t) (offsetof(bus_t, codeGenerations) - offsetof(bus_t, pages) + (page) * sizeof(uint32_t)))
+
+// flag bits in the status register
+#define FLAG_C 0x01
+#define FLAG_Z 0x02
+#define FLAG_I 0x04
+#define FLAG_D 0x08
+#define FLAG_V 0x40
+#define FLAG_N 0x80
+
+// a jump out of the translated block, to the instruction at pc
+// when dynamicPC is set, PC has been stored before the jump, and esi holds it as well
+// an exit that chains continues at the translated block starting at pc, if there is one
+// after a change of the interrupt flag it only does so while no irq is waiting for it
+// after an instruction that accessed the bus, it only does so if no device function left a control input pending
+// lastCycles are the cycles of the last instruction, a page crossing adds one to them if it mayCross
+struct exit {
+	size_t jump;
+	bool dynamicPC;
+	bool chains;
+	bool checksIrq;
+	bool checksControl;
+	uint16_t pc;
+	uint8_t instructions;
+	uint16_t cycles;
+	uint8_t lastCycles;
+	bool mayCross;
+};
+
+struct translation {
+	jit_t* jit;
+	struct exit exits[BLOCK_MAX_LENGTH * 4];
+	size_t exitCount;
+
+	// instructions and base cycles before the current instruction
+	uint8_t instructions;
+	uint16_t cycles;
+	uint16_t maxCycles;
+
+	// the current instruction
+	uint16_t pc;
+	uint16_t next;
+	uint8_t baseCycles;
+	bool usesBus;
+	bool mayCross;
+	// set once an instruction could have cleared the interrupt flag, an irq then has to be taken outside of translated code
+	bool changesInterrupt;
+
+	// the instruction before the current one
+	uint8_t lastCycles;
+	bool lastMayCross;
+};
+
+// an effective address, either known while translating or in esi
+struct address {
+	bool constant;
+	uint16_t value;
+};
+
+static void addExit(struct translation* t, const size_t jump, const uint16_t pc, const bool dynamicPC, const bool completed, const uint8_t extraCycles) {
+	t->exits[t->exitCount++] = (struct exit) {
+		.jump = jump,
+		.dynamicPC = dynamicPC,
+		// an instruction left to the interpreter has to run there
+		.chains = completed,
+		.checksIrq = t->changesInterrupt,
+		.checksControl = completed && t->usesBus,
+		.pc = pc,
+		.instructions = t->instructions + completed,
+		.cycles = t->cycles + (completed ? t->baseCycles + extraCycles : 0),
+		.lastCycles = completed ? t->baseCycles + extraCycles : t->lastCycles,
+		.mayCross = completed ? t->mayCross : t->lastMayCross,
+	};
+}
+
+// sets N and Z from the byte in eax
+static void emitNZ(jit_t* jit) {
+	jit_aluImm(jit, JIT_AND, J_P, (uint8_t) ~(FLAG_N | FLAG_Z));
+	jit_mov(jit, JIT_RCX, JIT_RAX);
+	jit_aluImm(jit, JIT_AND, JIT_RCX, FLAG_N);
+	jit_alu(jit, JIT_OR, J_P, JIT_RCX);
+	// eax < 1 sets the carry, which sbb spreads over ecx
+	jit_aluImm(jit, JIT_CMP, JIT_RAX, 1);
+	jit_alu(jit, JIT_SBB, JIT_RCX, JIT_RCX);
+	jit_aluImm(jit, JIT_AND, JIT_RCX, FLAG_Z);
+	jit_alu(jit, JIT_OR, J_P, JIT_RCX);
+}
+
+// sets Z if the byte in ecx is zero
+static void emitZ(jit_t* jit) {
+	jit_aluImm(jit, JIT_CMP, JIT_RCX, 1);
+	jit_alu(jit, JIT_SBB, JIT_RCX, JIT_RCX);
+	jit_aluImm(jit, JIT_AND, JIT_RCX, FLAG_Z);
+	jit_aluImm(jit, JIT_AND, J_P, (uint8_t) ~FLAG_Z);
+	jit_alu(jit, JIT_OR, J_P, JIT_RCX);
+}
+
+// a cycle that is only taken at runtime, by an indexed address crossing a page
+// the exits add it to the cycles of the instruction, see SLOT_PENALTY
+static void emitPenalty(jit_t* jit) {
+	jit_add64Imm(jit, J_CPU, CPU_FIELD(totalCycles), 1);
+	jit_store8Imm(jit, JIT_RSP, SLOT_PENALTY, 1);
+}
+
+// loads the pointer member of the page entry of address into reg
+static void emitPage(jit_t* jit, const struct address address, const jitReg_t reg, const int32_t member) {
+	if (address.constant) {
+		jit_load64(jit, reg, J_PAGES, JIT_NONE, PAGE_ENTRY(address.value >> BUS_PAGE_BITS) + member);
+		return;
+	}
+
+	jit_mov(jit, JIT_RAX, JIT_RSI);
+	jit_shift(jit, JIT_SHR, JIT_RAX, BUS_PAGE_BITS);
+	jit_imulImm(jit, JIT_RAX, JIT_RAX, sizeof(page_t));
+	jit_load64(jit, reg, J_PAGES, JIT_RAX, member);
+}
+
+// calls a bus function with edx already set, keeping esi intact
+static void emitBusCall(struct translation* t, const struct address address, const void* function) {
+	if (address.constant)
+		jit_movImm(t->jit, JIT_RSI, address.value);
+	else
+		jit_store32(t->jit, JIT_RSP, SLOT_ADDRESS, JIT_RSI);
+	jit_store32(t->jit, JIT_RSP, SLOT_SP, J_SP);
+	jit_load64(t->jit, JIT_RDI, J_CPU, JIT_NONE, CPU_FIELD(bus));
+
+	jit_call(t->jit, function);
+
+	jit_load32(t->jit, J_SP, JIT_RSP, JIT_NONE, SLOT_SP);
+	if (!address.constant)
+		jit_load32(t->jit, JIT_RSI, JIT_RSP, JIT_NONE, SLOT_ADDRESS);
+	jit_store8Imm(t->jit, JIT_RSP, SLOT_CALLED, 1);
+}
+
+// reads the byte at address into eax, like bus_read
+static void emitRead(struct translation* t, const struct address address) {
+	jit_t* jit = t->jit;
+	t->usesBus = true;
+
+	emitPage(jit, address, JIT_RDX, offsetof(page_t, read));
+	jit_test64(jit, JIT_RDX, JIT_RDX);
+	const size_t slow = jit_jcc(jit, JIT_Z);
+	if (address.constant)
+		jit_load8(jit, JIT_RAX, JIT_RDX, JIT_NONE, address.value & BUS_PAGE_MASK);
+	else {
+		jit_mov(jit, JIT_RAX, JIT_RSI);
+		jit_aluImm(jit, JIT_AND, JIT_RAX, BUS_PAGE_MASK);
+		jit_load8(jit, JIT_RAX, JIT_RDX, JIT_RAX, 0);
+	}
+	const size_t done = jit_jmp(jit);
+
+	jit_patch(jit, slow, jit_position(jit));
+	emitBusCall(t, address, (const void*) bus_readDevice);
+	jit_movzx8(jit, JIT_RAX, JIT_RAX);
+
+	jit_patch(jit, done, jit_position(jit));
+}
+
+// writes the byte in edx to address, like bus_write
+// edx doesn't survive the write
+static void emitWrite(struct translation* t, const struct address address) {
+	jit_t* jit = t->jit;
+	t->usesBus = true;
+
+	emitPage(jit, address, JIT_RCX, offsetof(page_t, write));
+	jit_test64(jit, JIT_RCX, JIT_RCX);
+	const size_t slow = jit_jcc(jit, JIT_Z);
+	if (address.constant)
+		jit_store8(jit, JIT_RCX, JIT_NONE, address.value & BUS_PAGE_MASK, JIT_RDX);
+	else {
+		jit_mov(jit, JIT_RAX, JIT_RSI);
+		jit_aluImm(jit, JIT_AND, JIT_RAX, BUS_PAGE_MASK);
+		jit_store8(jit, JIT_RCX, JIT_RAX, 0, JIT_RDX);
+	}
+	const size_t done = jit_jmp(jit);
+
+	jit_patch(jit, slow, jit_position(jit));
+	emitBusCall(t, address, (const void*) bus_writeDevice);
+
+	jit_patch(jit, done, jit_position(jit));
+}
+
+static const struct address stackAddress = { .constant = false };
+
+// pushes the byte in edx
+static void emitPush(struct translation* t) {
+	jit_mov(t->jit, JIT_RSI, J_SP);
+	jit_aluImm(t->jit, JIT_ADD, JIT_RSI, 0x0100);
+	emitWrite(t, stackAddress);
+	jit_aluImm(t->jit, JIT_SUB, J_SP, 1);
+	jit_aluImm(t->jit, JIT_AND, J_SP, 0xFF);
+}
+
+// pulls a byte into eax
+static void emitPull(struct translation* t) {
+	jit_aluImm(t->jit, JIT_ADD, J_SP, 1);
+	jit_aluImm(t->jit, JIT_AND, J_SP, 0xFF);
+	jit_mov(t->jit, JIT_RSI, J_SP);
+	jit_aluImm(t->jit, JIT_ADD, JIT_RSI, 0x0100);
+	emitRead(t, stackAddress);
+}
+
+// pulls the status register, keeping B and the unused bit, like PLP
+static void emitPullFlags(struct translation* t) {
+	emitPull(t);
+	jit_aluImm(t->jit, JIT_AND, JIT_RAX, 0xCF);
+	jit_mov(t->jit, JIT_RCX, J_P);
+	jit_aluImm(t->jit, JIT_AND, JIT_RCX, 0x30);
+	jit_alu(t->jit, JIT_OR, JIT_RAX, JIT_RCX);
+	jit_mov(t->jit, J_P, JIT_RAX);
+}
+
+// adds index to the address in esi, taking a cycle when crossing a page
+static void emitIndex(jit_t* jit, const jitReg_t index) {
+	jit_store8Imm(jit, JIT_RSP, SLOT_PENALTY, 0);
+	jit_mov(jit, JIT_RCX, JIT_RSI);
+	jit_alu(jit, JIT_ADD, JIT_RSI, index);
+	jit_mov(jit, JIT_RAX, JIT_RSI);
+	jit_alu(jit, JIT_XOR, JIT_RAX, JIT_RCX);
+	jit_testImm(jit, JIT_RAX, 0xFF00);
+	const size_t samePage = jit_jcc(jit, JIT_Z);
+	emitPenalty(jit);
+	jit_patch(jit, samePage, jit_position(jit));
+	jit_aluImm(jit, JIT_AND, JIT_RSI, 0xFFFF);
+}
+
+// reads a pointer from zero page into esi, the second byte is read from zeroPage + 1, like the addressing modes do
+static void emitPointer(struct translation* t, const struct address zeroPage) {
+	emitRead(t, zeroPage);
+	jit_store32(t->jit, JIT_RSP, SLOT_TEMP, JIT_RAX);
+	if (zeroPage.constant)
+		emitRead(t, (struct address) { true, zeroPage.value + 1 });
+	else {
+		jit_aluImm(t->jit, JIT_ADD, JIT_RSI, 1);
+		emitRead(t, zeroPage);
+	}
+	jit_shift(t->jit, JIT_SHL, JIT_RAX, 8);
+	jit_load32(t->jit, JIT_RCX, JIT_RSP, JIT_NONE, SLOT_TEMP);
+	jit_alu(t->jit, JIT_OR, JIT_RAX, JIT_RCX);
+	jit_mov(t->jit, JIT_RSI, JIT_RAX);
+}
+
+// emits the addressing mode, leaving the operand in eax and the effective address in address
+static void emitAddressingMode(struct translation* t, const uint8_t addressMode, const uint8_t* operands, struct address* address) {
+	jit_t* jit = t->jit;
+	const uint16_t zeroPage = operands[0];
+	const uint16_t absolute = operands[0] | (operands[1] << 8);
+
+	*address = (struct address) { .constant = false };
+	switch (addressMode) {
+	case AM_IMM:
+		jit_movImm(jit, JIT_RAX, operands[0]);
+		return;
+	case AM_ABS:
+		*address = (struct address) { true, absolute };
+		break;
+	case AM_ABSX:
+	case AM_ABSY:
+		jit_movImm(jit, JIT_RSI, absolute);
+		emitIndex(jit, addressMode == AM_ABSX ? J_X : J_Y);
+		t->mayCross = true;
+		break;
+	case AM_INDX:
+		jit_mov(jit, JIT_RSI, J_X);
+		jit_aluImm(jit, JIT_ADD, JIT_RSI, zeroPage);
+		jit_aluImm(jit, JIT_AND, JIT_RSI, 0xFF);
+		emitPointer(t, *address);
+		break;
+	case AM_INDY:
+		emitPointer(t, (struct address) { true, zeroPage });
+		emitIndex(jit, J_Y);
+		t->mayCross = true;
+		break;
+	case AM_ZPG:
+		*address = (struct address) { true, zeroPage };
+		break;
+#ifdef WDC
+	case AM_ZPGI:
+		emitPointer(t, (struct address) { true, zeroPage });
+		break;
+#endif
+	case AM_ZPGX:
+	case AM_ZPGY:
+		jit_mov(jit, JIT_RSI, addressMode == AM_ZPGX ? J_X : J_Y);
+		jit_aluImm(jit, JIT_ADD, JIT_RSI, zeroPage);
+		jit_aluImm(jit, JIT_AND, JIT_RSI, 0xFF);
+		break;
+	default:
+		// implied, accumulator and stack use the accumulator as operand
+		jit_mov(jit, JIT_RAX, J_A);
+		return;
+	}
+
+	emitRead(t, *address);
+}
+
+// true if the opcode can be translated
+static bool canTranslate(const uint8_t opcode) {
+	const struct opcode info = opcodes[opcode];
+
+	switch (info.addressMode) {
+#ifndef WDC
+	case AM_XXX:
+#endif
+#ifdef WDC
+	case AM_ABSI:
+#endif
+	case AM_IND:
+		return false;
+	}
+
+	switch (info.instruction) {
+#ifndef WDC
+	case IN_XXX:
+#endif
+#ifdef ROCKWEL
+	case IN_BBR0: case IN_BBR1: case IN_BBR2: case IN_BBR3: case IN_BBR4: case IN_BBR5: case IN_BBR6: case IN_BBR7:
+	case IN_BBS0: case IN_BBS1: case IN_BBS2: case IN_BBS3: case IN_BBS4: case IN_BBS5: case IN_BBS6: case IN_BBS7:
+#endif
+#ifdef WDC
+	case IN_STP: case IN_WAI:
+#endif
+	case IN_BRK:
+		return false;
+	default:
+		return true;
+	}
+}
+
+// ADC and SBC, decimal mode looks the result up in the same table as the interpreter
+static void emitAdd(struct translation* t, const bool subtract) {
+	jit_t* jit = t->jit;
+
+	jit_testImm(jit, J_P, FLAG_D);
+	const size_t binary = jit_jcc(jit, JIT_Z);
+	// the entry is at [subtract][carry][A][operand], 2 bytes each
+	jit_mov(jit, JIT_RDX, J_P);
+	jit_aluImm(jit, JIT_AND, JIT_RDX, FLAG_C);
+	jit_shift(jit, JIT_SHL, JIT_RDX, 8);
+	jit_alu(jit, JIT_OR, JIT_RDX, J_A);
+	jit_shift(jit, JIT_SHL, JIT_RDX, 8);
+	jit_alu(jit, JIT_OR, JIT_RDX, JIT_RAX);
+	jit_alu(jit, JIT_ADD, JIT_RDX, JIT_RDX);
+	jit_movImm64(jit, JIT_RCX, (uint64_t) (uintptr_t) decimalTables[subtract]);
+	jit_load16(jit, JIT_RAX, JIT_RCX, JIT_RDX, 0);
+	jit_movzx8(jit, J_A, JIT_RAX);
+	jit_shift(jit, JIT_SHR, JIT_RAX, 8);
+	jit_aluImm(jit, JIT_AND, J_P, (uint8_t) ~(FLAG_N | FLAG_V | FLAG_Z | FLAG_C));
+	jit_alu(jit, JIT_OR, J_P, JIT_RAX);
+	const size_t done = jit_jmp(jit);
+
+	jit_patch(jit, binary, jit_position(jit));
+	jit_mov(jit, JIT_RDX, JIT_RAX);
+	if (subtract)
+		jit_aluImm(jit, JIT_XOR, JIT_RDX, 0xFF);
+	jit_mov(jit, JIT_RAX, J_A);
+	jit_bt(jit, J_P, 0);
+	jit_alu8(jit, JIT_ADC, JIT_RAX, JIT_RDX);
+	jit_setcc(jit, JIT_C, JIT_RCX);
+	jit_setcc(jit, JIT_O, JIT_RDX);
+	jit_movzx8(jit, JIT_RCX, JIT_RCX);
+	jit_movzx8(jit, JIT_RDX, JIT_RDX);
+	jit_shift(jit, JIT_SHL, JIT_RDX, 6);
+	jit_alu(jit, JIT_OR, JIT_RCX, JIT_RDX);
+	jit_aluImm(jit, JIT_AND, J_P, (uint8_t) ~(FLAG_N | FLAG_V | FLAG_Z | FLAG_C));
+	jit_alu(jit, JIT_OR, J_P, JIT_RCX);
+	jit_movzx8(jit, JIT_RAX, JIT_RAX);
+	jit_mov(jit, J_A, JIT_RAX);
+	emitNZ(jit);
+
+	jit_patch(jit, done, jit_position(jit));
+}
+
+// CMP, CPX and CPY
+static void emitCompare(jit_t* jit, const jitReg_t reg) {
+	jit_mov(jit, JIT_RDX, reg);
+	jit_alu(jit, JIT_SUB, JIT_RDX, JIT_RAX);
+	jit_setcc(jit, JIT_NC, JIT_RCX);
+	jit_movzx8(jit, JIT_RCX, JIT_RCX);
+	jit_aluImm(jit, JIT_AND, J_P, (uint8_t) ~FLAG_C);
+	jit_alu(jit, JIT_OR, J_P, JIT_RCX);
+	jit_movzx8(jit, JIT_RAX, JIT_RDX);
+	emitNZ(jit);
+}
+
+// sets the carry to bit of eax
+static void emitCarryFromBit(jit_t* jit, const uint8_t bit) {
+	jit_mov(jit, JIT_RCX, JIT_RAX);
+	if (bit)
+		jit_shift(jit, JIT_SHR, JIT_RCX, bit);
+	jit_aluImm(jit, JIT_AND, JIT_RCX, FLAG_C);
+	jit_aluImm(jit, JIT_AND, J_P, (uint8_t) ~FLAG_C);
+	jit_alu(jit, JIT_OR, J_P, JIT_RCX);
+}
+
+// shifts, rotates, increments and decrements of the value in eax, including the flags
+static void emitModify(jit_t* jit, const uint8_t instruction) {
+	switch (instruction) {
+	case IN_ASL:
+		emitCarryFromBit(jit, 7);
+		jit_shift(jit, JIT_SHL, JIT_RAX, 1);
+		break;
+	case IN_LSR:
+		emitCarryFromBit(jit, 0);
+		jit_shift(jit, JIT_SHR, JIT_RAX, 1);
+		break;
+	case IN_ROL:
+		jit_mov(jit, JIT_RDX, J_P);
+		jit_aluImm(jit, JIT_AND, JIT_RDX, FLAG_C);
+		emitCarryFromBit(jit, 7);
+		jit_shift(jit, JIT_SHL, JIT_RAX, 1);
+		jit_alu(jit, JIT_OR, JIT_RAX, JIT_RDX);
+		break;
+	case IN_ROR:
+		jit_mov(jit, JIT_RDX, J_P);
+		jit_aluImm(jit, JIT_AND, JIT_RDX, FLAG_C);
+		jit_shift(jit, JIT_SHL, JIT_RDX, 7);
+		emitCarryFromBit(jit, 0);
+		jit_shift(jit, JIT_SHR, JIT_RAX, 1);
+		jit_alu(jit, JIT_OR, JIT_RAX, JIT_RDX);
+		break;
+	case IN_INC:
+		jit_aluImm(jit, JIT_ADD, JIT_RAX, 1);
+		break;
+	case IN_DEC:
+		jit_aluImm(jit, JIT_SUB, JIT_RAX, 1);
+		break;
+	}
+
+	jit_aluImm(jit, JIT_AND, JIT_RAX, 0xFF);
+	emitNZ(jit);
+}
+
+// mirrors the extra bus access of read-modify-write instructions, see RMW
+static void emitRMW(struct translation* t, const struct address address) {
+#ifndef ROCKWEL
+	jit_store32(t->jit, JIT_RSP, SLOT_TEMP, JIT_RAX);
+	jit_mov(t->jit, JIT_RDX, JIT_RAX);
+	emitWrite(t, address);
+	jit_load32(t->jit, JIT_RAX, JIT_RSP, JIT_NONE, SLOT_TEMP);
+#else
+	emitRead(t, address);
+#endif
+}
+
+// copies src to dst, setting N and Z from it
+static void emitTransfer(jit_t* jit, const jitReg_t dst, const jitReg_t src) {
+	jit_mov(jit, dst, src);
+	jit_mov(jit, JIT_RAX, dst);
+	emitNZ(jit);
+}
+
+static void emitIncrement(jit_t* jit, const jitReg_t reg, const jitAlu_t op) {
+	jit_aluImm(jit, op, reg, 1);
+	jit_aluImm(jit, JIT_AND, reg, 0xFF);
+	jit_mov(jit, JIT_RAX, reg);
+	emitNZ(jit);
+}
+
+// returns the flag tested by a branch instruction, and if it branches when the flag is set
+static uint8_t branchFlag(const uint8_t instruction, bool* whenSet) {
+	*whenSet = instruction == IN_BCS || instruction == IN_BEQ || instruction == IN_BMI || instruction == IN_BVS;
+
+	switch (instruction) {
+	case IN_BCC: case IN_BCS: return FLAG_C;
+	case IN_BNE: case IN_BEQ: return FLAG_Z;
+	case IN_BPL: case IN_BMI: return FLAG_N;
+	case IN_BVC: case IN_BVS: return FLAG_V;
+	default: return 0;
+	}
+}
+
+// translates the instruction at t->pc
+// returns true if the instruction ends the translated block, in which case all its exits are emitted
+static bool translateInstruction(struct translation* t, const struct microOp* uop) {
+	jit_t* jit = t->jit;
+	const struct opcode info = opcodes[uop->opcode];
+	const uint8_t instruction = info.instruction;
+	const uint8_t addressMode = info.addressMode;
+
+	t->baseCycles = info.cycleCount;
+	t->usesBus = false;
+	t->mayCross = false;
+	uint8_t maxCycles = info.cycleCount;
+
+	uint16_t target = 0;
+	if (addressMode == AM_REL) {
+		target = (uint16_t) (t->next + (int8_t) uop->operands[0]);
+		if ((t->next & 0xFF00) != (target & 0xFF00))
+			t->baseCycles++;
+		maxCycles = t->baseCycles + 1;
+	} else if (addressMode == AM_ABSX || addressMode == AM_ABSY || addressMode == AM_INDY)
+		maxCycles++;
+
+	t->maxCycles += maxCycles;
+
+	struct address address;
+	if (addressMode != AM_REL)
+		emitAddressingMode(t, addressMode, uop->operands, &address);
+
+	bool ends = false;
+	switch (instruction) {
+	case IN_NOP:
+		break;
+	case IN_LDA: jit_mov(jit, J_A, JIT_RAX); emitNZ(jit); break;
+	case IN_LDX: jit_mov(jit, J_X, JIT_RAX); emitNZ(jit); break;
+	case IN_LDY: jit_mov(jit, J_Y, JIT_RAX); emitNZ(jit); break;
+	case IN_STA: jit_mov(jit, JIT_RDX, J_A); emitWrite(t, address); break;
+	case IN_STX: jit_mov(jit, JIT_RDX, J_X); emitWrite(t, address); break;
+	case IN_STY: jit_mov(jit, JIT_RDX, J_Y); emitWrite(t, address); break;
+#ifdef WDC
+	case IN_STZ: jit_movImm(jit, JIT_RDX, 0); emitWrite(t, address); break;
+#endif
+	case IN_ADC: emitAdd(t, false); break;
+	case IN_SBC: emitAdd(t, true); break;
+	case IN_AND: jit_alu(jit, JIT_AND, J_A, JIT_RAX); jit_mov(jit, JIT_RAX, J_A); emitNZ(jit); break;
+	case IN_ORA: jit_alu(jit, JIT_OR, J_A, JIT_RAX); jit_mov(jit, JIT_RAX, J_A); emitNZ(jit); break;
+	case IN_EOR: jit_alu(jit, JIT_XOR, J_A, JIT_RAX); jit_mov(jit, JIT_RAX, J_A); emitNZ(jit); break;
+	case IN_CMP: emitCompare(jit, J_A); break;
+	case IN_CPX: emitCompare(jit, J_X); break;
+	case IN_CPY: emitCompare(jit, J_Y); break;
+	case IN_BIT:
+		jit_mov(jit, JIT_RCX, JIT_RAX);
+		jit_alu(jit, JIT_AND, JIT_RCX, J_A);
+		emitZ(jit);
+#ifdef WDC
+		if (addressMode == AM_IMM)
+			break;
+#endif
+		jit_aluImm(jit, JIT_AND, J_P, (uint8_t) ~(FLAG_N | FLAG_V));
+		jit_aluImm(jit, JIT_AND, JIT_RAX, FLAG_N | FLAG_V);
+		jit_alu(jit, JIT_OR, J_P, JIT_RAX);
+		break;
+	case IN_ASL: case IN_LSR: case IN_ROL: case IN_ROR:
+	case IN_INC: case IN_DEC:
+		if (addressMode == AM_ACC) {
+			emitModify(jit, instruction);
+			jit_mov(jit, J_A, JIT_RAX);
+			break;
+		}
+		emitRMW(t, address);
+		emitModify(jit, instruction);
+		jit_mov(jit, JIT_RDX, JIT_RAX);
+		emitWrite(t, address);
+		break;
+#ifdef WDC
+	case IN_TRB:
+	case IN_TSB:
+		jit_mov(jit, JIT_RCX, JIT_RAX);
+		jit_alu(jit, JIT_AND, JIT_RCX, J_A);
+		emitZ(jit);
+		jit_mov(jit, JIT_RDX, J_A);
+		if (instruction == IN_TRB) {
+			jit_aluImm(jit, JIT_XOR, JIT_RDX, 0xFF);
+			jit_alu(jit, JIT_AND, JIT_RDX, JIT_RAX);
+		} else
+			jit_alu(jit, JIT_OR, JIT_RDX, JIT_RAX);
+		emitWrite(t, address);
+		break;
+#endif
+#ifdef ROCKWEL
+	case IN_RMB0: case IN_RMB1: case IN_RMB2: case IN_RMB3: case IN_RMB4: case IN_RMB5: case IN_RMB6: case IN_RMB7:
+		jit_mov(jit, JIT_RDX, JIT_RAX);
+		jit_aluImm(jit, JIT_AND, JIT_RDX, (uint8_t) ~(1 << (instruction - IN_RMB0)));
+		emitWrite(t, address);
+		break;
+	case IN_SMB0: case IN_SMB1: case IN_SMB2: case IN_SMB3: case IN_SMB4: case IN_SMB5: case IN_SMB6: case IN_SMB7:
+		jit_mov(jit, JIT_RDX, JIT_RAX);
+		jit_aluImm(jit, JIT_OR, JIT_RDX, 1 << (instruction - IN_SMB0));
+		emitWrite(t, address);
+		break;
+#endif
+	case IN_INX: emitIncrement(jit, J_X, JIT_ADD); break;
+	case IN_INY: emitIncrement(jit, J_Y, JIT_ADD); break;
+	case IN_DEX: emitIncrement(jit, J_X, JIT_SUB); break;
+	case IN_DEY: emitIncrement(jit, J_Y, JIT_SUB); break;
+	case IN_TAX: emitTransfer(jit, J_X, J_A); break;
+	case IN_TAY: emitTransfer(jit, J_Y, J_A); break;
+	case IN_TXA: emitTransfer(jit, J_A, J_X); break;
+	case IN_TYA: emitTransfer(jit, J_A, J_Y); break;
+	case IN_TSX: emitTransfer(jit, J_X, J_SP); break;
+	case IN_TXS: jit_mov(jit, J_SP, J_X); break;
+	case IN_CLC: jit_aluImm(jit, JIT_AND, J_P, (uint8_t) ~FLAG_C); break;
+	case IN_CLD: jit_aluImm(jit, JIT_AND, J_P, (uint8_t) ~FLAG_D); break;
+	case IN_CLV: jit_aluImm(jit, JIT_AND, J_P, (uint8_t) ~FLAG_V); break;
+	case IN_SEC: jit_aluImm(jit, JIT_OR, J_P, FLAG_C); break;
+	case IN_SED: jit_aluImm(jit, JIT_OR, J_P, FLAG_D); break;
+	case IN_SEI: jit_aluImm(jit, JIT_OR, J_P, FLAG_I); break;
+	case IN_CLI:
+		// clearing the interrupt flag can make an interrupt pending
+		jit_aluImm(jit, JIT_AND, J_P, (uint8_t) ~FLAG_I);
+		t->changesInterrupt = true;
+		ends = true;
+		break;
+	case IN_PHA: jit_mov(jit, JIT_RDX, J_A); emitPush(t); break;
+#ifdef WDC
+	case IN_PHX: jit_mov(jit, JIT_RDX, J_X); emitPush(t); break;
+	case IN_PHY: jit_mov(jit, JIT_RDX, J_Y); emitPush(t); break;
+#endif
+	case IN_PHP:
+		jit_mov(jit, JIT_RDX, J_P);
+		jit_aluImm(jit, JIT_OR, JIT_RDX, 0x30);
+		emitPush(t);
+		break;
+	case IN_PLA: emitPull(t); jit_mov(jit, J_A, JIT_RAX); emitNZ(jit); break;
+#ifdef WDC
+	case IN_PLX: emitPull(t); jit_mov(jit, J_X, JIT_RAX); emitNZ(jit); break;
+	case IN_PLY: emitPull(t); jit_mov(jit, J_Y, JIT_RAX); emitNZ(jit); break;
+#endif
+	case IN_PLP:
+		emitPullFlags(t);
+		t->changesInterrupt = true;
+		ends = true;
+		break;
+	case IN_JMP:
+		addExit(t, jit_jmp(jit), address.value, false, true, 0);
+		return true;
+	case IN_JSR:
+		jit_movImm(jit, JIT_RDX, (uint16_t) (t->next - 1) >> 8);
+		emitPush(t);
+		jit_movImm(jit, JIT_RDX, (uint16_t) (t->next - 1) & 0xFF);
+		emitPush(t);
+		addExit(t, jit_jmp(jit), address.value, false, true, 0);
+		return true;
+	case IN_RTI:
+	case IN_RTS:
+		if (instruction == IN_RTI) {
+			emitPullFlags(t);
+			t->changesInterrupt = true;
+		}
+		emitPull(t);
+		jit_store32(jit, JIT_RSP, SLOT_TEMP, JIT_RAX);
+		emitPull(t);
+		jit_shift(jit, JIT_SHL, JIT_RAX, 8);
+		jit_load32(jit, JIT_RCX, JIT_RSP, JIT_NONE, SLOT_TEMP);
+		jit_alu(jit, JIT_OR, JIT_RAX, JIT_RCX);
+		if (instruction == IN_RTS) {
+			jit_aluImm(jit, JIT_ADD, JIT_RAX, 1);
+			jit_aluImm(jit, JIT_AND, JIT_RAX, 0xFFFF);
+		}
+		jit_mov(jit, JIT_RSI, JIT_RAX);
+		jit_store16(jit, J_CPU, CPU_FIELD(registers.PC), JIT_RSI);
+		addExit(t, jit_jmp(jit), 0, true, true, 0);
+		return true;
+#ifdef WDC
+	case IN_BRA:
+		addExit(t, jit_jmp(jit), target, false, true, 0);
+		return true;
+#endif
+	default: {
+		bool whenSet;
+		const uint8_t flag = branchFlag(instruction, &whenSet);
+		jit_testImm(jit, J_P, flag);
+		addExit(t, jit_jcc(jit, whenSet ? JIT_NZ : JIT_Z), target, false, true, 1);
+		addExit(t, jit_jmp(jit), t->next, false, true, 0);
+		return true;
+	}
+	}
+
+	if (ends) {
+		addExit(t, jit_jmp(jit), t->next, false, true, 0);
+		return true;
+	}
+
+	// a device could have done anything, continue outside of the block
+	if (t->usesBus) {
+		jit_cmp8Imm(jit, JIT_RSP, SLOT_CALLED, 0);
+		addExit(t, jit_jcc(jit, JIT_NZ), t->next, false, true, 0);
+	}
+
+	t->lastCycles = t->baseCycles;
+	t->lastMayCross = t->mayCross;
+	return false;
+}
+
+// the most jumps emitChain takes when the next block can't be entered
+#define CHAIN_CHECKS 6
+
+// continues at the translated block starting at the pc of exit, with PC, totalCycles and instructionCount already stored
+// rax holds totalCycles, and esi the pc if it is dynamic
+// the block is looked up in the cache at runtime, as it can be replaced or become stale at any time
+// it is only entered while totalCycles is below jitDeadline, and no control input is pending
+// otherwise one of the jumps added to leave is taken
+// returns the amount of jumps added
+static size_t emitChain(jit_t* jit, const struct exit* exit, size_t* leave) {
+	size_t count = 0;
+
+	// covers the instructions and cycles left to run, and stop requests, see setDeadline
+	jit_load64(jit, JIT_RDX, J_CPU, JIT_NONE, CPU_FIELD(jitDeadline));
+	jit_alu64(jit, JIT_CMP, JIT_RAX, JIT_RDX);
+	leave[count++] = jit_jcc(jit, JIT_NC);
+
+	// a device function could have raised a control input, only it can while translated code runs
+	if (exit->checksControl) {
+		jit_cmp8Imm(jit, J_CPU, CPU_FIELD(pendingControl), 0);
+		leave[count++] = jit_jcc(jit, JIT_NZ);
+	}
+
+	// the irq line is active while any source pulls it, and is taken once the interrupt flag is clear
+	if (exit->checksIrq) {
+		jit_testImm(jit, J_P, FLAG_I);
+		const size_t disabled = jit_jcc(jit, JIT_NZ);
+		jit_load32(jit, JIT_RAX, J_CPU, JIT_NONE, CPU_FIELD(irqSources));
+		jit_test(jit, JIT_RAX, JIT_RAX);
+		leave[count++] = jit_jcc(jit, JIT_NZ);
+		jit_patch(jit, disabled, jit_position(jit));
+	}
+
+	jit_load64(jit, JIT_RDI, J_CPU, JIT_NONE, CPU_FIELD(blockCache));
+	if (exit->dynamicPC) {
+		jit_mov(jit, JIT_RAX, JIT_RSI);
+		jit_aluImm(jit, JIT_AND, JIT_RAX, BLOCK_CACHE_SIZE - 1);
+		jit_imulImm(jit, JIT_RAX, JIT_RAX, sizeof(struct block));
+		jit_alu64(jit, JIT_ADD, JIT_RDI, JIT_RAX);
+	} else
+		jit_aluImm64(jit, JIT_ADD, JIT_RDI, (int32_t) ((exit->pc & (BLOCK_CACHE_SIZE - 1)) * sizeof(struct block)));
+
+	// start shares its 4 bytes with length
+	jit_load32(jit, JIT_RAX, JIT_RDI, JIT_NONE, BLOCK_FIELD(start));
+	jit_aluImm(jit, JIT_AND, JIT_RAX, 0xFFFF);
+	if (exit->dynamicPC)
+		jit_alu(jit, JIT_CMP, JIT_RAX, JIT_RSI);
+	else
+		jit_aluImm(jit, JIT_CMP, JIT_RAX, exit->pc);
+	leave[count++] = jit_jcc(jit, JIT_NZ);
+
+	jit_load64(jit, JIT_RCX, JIT_RDI, JIT_NONE, BLOCK_FIELD(chain));
+	jit_test64(jit, JIT_RCX, JIT_RCX);
+	leave[count++] = jit_jcc(jit, JIT_Z);
+
+	if (exit->dynamicPC) {
+		jit_mov(jit, JIT_RDX, JIT_RSI);
+		jit_shift(jit, JIT_SHR, JIT_RDX, BUS_PAGE_BITS);
+		jit_shift(jit, JIT_SHL, JIT_RDX, 2);
+		jit_load32(jit, JIT_RDX, J_PAGES, JIT_RDX, CODE_GENERATION(0));
+	} else
+		jit_load32(jit, JIT_RDX, J_PAGES, JIT_NONE, CODE_GENERATION(exit->pc >> BUS_PAGE_BITS));
+	jit_load32(jit, JIT_RAX, JIT_RDI, JIT_NONE, BLOCK_FIELD(generation));
+	jit_alu(jit, JIT_CMP, JIT_RAX, JIT_RDX);
+	leave[count++] = jit_jcc(jit, JIT_NZ);
+
+	jit_jmpReg(jit, JIT_RCX);
+	return count;
+}
+
+// emits the exits of the block and the code leaving it, which writes the registers back to cpu
+static void emitExits(struct translation* t) {
+	jit_t* jit = t->jit;
+
+	size_t epilogueJumps[sizeof(t->exits) / sizeof(t->exits[0])];
+	for (size_t i = 0; i < t->exitCount; i++) {
+		const struct exit* exit = t->exits + i;
+		jit_patch(jit, exit->jump, jit_position(jit));
+
+		if (exit->instructions)
+			jit_add64Imm(jit, J_CPU, CPU_FIELD(instructionCount), exit->instructions);
+
+		size_t leave[CHAIN_CHECKS];
+		size_t leaveCount = 0;
+		if (exit->chains) {
+			jit_load64(jit, JIT_RAX, J_CPU, JIT_NONE, CPU_FIELD(totalCycles));
+			if (exit->cycles)
+				jit_aluImm64(jit, JIT_ADD, JIT_RAX, exit->cycles);
+			jit_store64(jit, J_CPU, CPU_FIELD(totalCycles), JIT_RAX);
+			leaveCount = emitChain(jit, exit, leave);
+		} else if (exit->cycles)
+			jit_add64Imm(jit, J_CPU, CPU_FIELD(totalCycles), exit->cycles);
+
+		for (size_t j = 0; j < leaveCount; j++)
+			jit_patch(jit, leave[j], jit_position(jit));
+		if (!exit->dynamicPC)
+			jit_store16Imm(jit, J_CPU, CPU_FIELD(registers.PC), exit->pc);
+		// the cycles of the last instruction, only needed once the block is left
+		if (exit->mayCross) {
+			jit_load8(jit, JIT_RAX, JIT_RSP, JIT_NONE, SLOT_PENALTY);
+			jit_aluImm(jit, JIT_ADD, JIT_RAX, exit->lastCycles);
+			jit_store8(jit, J_CPU, JIT_NONE, CPU_FIELD(cycles), JIT_RAX);
+		} else
+			jit_store8Imm(jit, J_CPU, CPU_FIELD(cycles), exit->lastCycles);
+
+		// the last exit falls through into the epilogue
+		if (i + 1 < t->exitCount)
+			epilogueJumps[i] = jit_jmp(jit);
+	}
+
+	for (size_t i = 0; i + 1 < t->exitCount; i++)
+		jit_patch(jit, epilogueJumps[i], jit_position(jit));
+
+	jit_store8(jit, J_CPU, JIT_NONE, CPU_FIELD(registers.A), J_A);
+	jit_store8(jit, J_CPU, JIT_NONE, CPU_FIELD(registers.X), J_X);
+	jit_store8(jit, J_CPU, JIT_NONE, CPU_FIELD(registers.Y), J_Y);
+	jit_store8(jit, J_CPU, JIT_NONE, CPU_FIELD(registers.SP), J_SP);
+	jit_store8(jit, J_CPU, JIT_NONE, CPU_FIELD(registers.flags), J_P);
+
+	jit_aluImm64(jit, JIT_ADD, JIT_RSP, FRAME_SIZE);
+	jit_pop(jit, JIT_R15);
+	jit_pop(jit, JIT_R14);
+	jit_pop(jit, JIT_R13);
+	jit_pop(jit, JIT_R12);
+	jit_pop(jit, JIT_RBP);
+	jit_pop(jit, JIT_RBX);
+	jit_ret(jit);
+}
+
+// forgets all native code, and makes every block eligible for translation again
+static void forgetTranslations(cpu_t* cpu) {
+	if (cpu->blockCache == NULL)
+		return;
+
+	for (size_t i = 0; i < BLOCK_CACHE_SIZE; i++) {
+		struct block* block = cpu->blockCache->blocks + i;
+		block->code = NULL;
+		block->chain = NULL;
+		block->translated = false;
+		block->executions = 0;
+	}
+}
+
+static void translateBlock(cpu_t* cpu, struct block* block) {
+	block->translated = true;
+	// polling loops are only detected by executeBlocks
+	if (block->polls || !canTranslate(block->ops[0].opcode))
+		return;
+
+	jit_t* jit = cpu->jit;
+	struct translation t = { .jit = jit };
+
+	for (int attempt = 0; attempt < 2; attempt++) {
+		t = (struct translation) { .jit = jit };
+		if (!jit_begin(jit))
+			return;
+		const size_t begin = jit_position(jit);
+
+		// 6 pushes and the frame keep the stack 16 byte aligned for calls
+		jit_push(jit, JIT_RBX);
+		jit_push(jit, JIT_RBP);
+		jit_push(jit, JIT_R12);
+		jit_push(jit, JIT_R13);
+		jit_push(jit, JIT_R14);
+		jit_push(jit, JIT_R15);
+		jit_aluImm64(jit, JIT_SUB, JIT_RSP, FRAME_SIZE);
+		jit_mov64(jit, J_CPU, JIT_RDI);
+		jit_load64(jit, J_PAGES, J_CPU, JIT_NONE, CPU_FIELD(bus));
+		jit_aluImm64(jit, JIT_ADD, J_PAGES, (int32_t) offsetof(bus_t, pages));
+		jit_load8(jit, J_A, J_CPU, JIT_NONE, CPU_FIELD(registers.A));
+		jit_load8(jit, J_X, J_CPU, JIT_NONE, CPU_FIELD(registers.X));
+		jit_load8(jit, J_Y, J_CPU, JIT_NONE, CPU_FIELD(registers.Y));
+		jit_load8(jit, J_SP, J_CPU, JIT_NONE, CPU_FIELD(registers.SP));
+		jit_load8(jit, J_P, J_CPU, JIT_NONE, CPU_FIELD(registers.flags));
+		// other translated blocks continue here, leaving through the epilogue of this one
+		const size_t chain = jit_position(jit);
+		jit_store8Imm(jit, JIT_RSP, SLOT_CALLED, 0);
+
+		uint16_t pc = block->start;
+		bool ended = false;
+		for (uint8_t i = 0; i < block->length && !ended && canTranslate(block->ops[i].opcode); i++) {
+			t.pc = pc;
+			t.next = pc + instructionLength(block->ops[i].opcode);
+			ended = translateInstruction(&t, block->ops + i);
+			t.instructions++;
+			t.cycles += t.baseCycles;
+			pc = t.next;
+		}
+
+		// the next instruction couldn't be translated, or the block was cut off
+		if (!ended) {
+			t.baseCycles = 0;
+			addExit(&t, jit_jmp(jit), pc, false, false, 0);
+		}
+
+		emitExits(&t);
+
+		block->code = (void (*)(cpu_t*)) jit_end(jit);
+		if (block->code) {
+			block->chain = (uint8_t*) block->code + (chain - begin);
+			break;
+		}
+
+		// out of executable memory, start over
+		// this also drops all code if the memory could not be made executable again, none of it could run anymore
+		jit_reset(jit);
+		forgetTranslations(cpu);
+		block->translated = true;
+	}
+
+	if (block->code == NULL)
+		return;
+
+	block->codeLength = t.instructions;
+	block->codeCycles = t.maxCycles;
+	cpu->translatedBlocks++;
+}
+
+#pragma endregion translation
+#endif // JIT_X86_64
+
+const struct cpuCore CPU_CORE = {
+	.init = init,
+	.destroy = destroy,
+	.setBlockCache = setBlockCache,
+	.setJit = setJit,
+	.flushBlockCache = flushBlockCache,
+	.clock = clockCycle,
+	.runInstruction = runInstruction,
+	.runCycles = runCycles,
+	.runInstructions = runInstructions,
+	.printInstruction = printInstruction,
+	.opcodeInfo = opcodeInfo,
+};
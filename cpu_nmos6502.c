@@ -0,0 +1,6 @@
+// the original nmos 6502, illegal opcodes are reported as unimplemented
+#undef WDC
+#undef ROCKWEL
+
+#define CPU_CORE cpu_nmos6502Core
+#include "cpu_core.h"
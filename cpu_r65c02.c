@@ -0,0 +1,7 @@
+// the rockwell 65C02, which adds the bit manipulation and bit branch instructions
+#undef WDC
+#undef ROCKWEL
+#define ROCKWEL
+
+#define CPU_CORE cpu_r65c02Core
+#include "cpu_core.h"
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "cpu.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// the entry points of a cpu variant
+// every variant is cpu_core.h compiled with its own defines, so its opcode table and instructions are fully specialized
+// cpu.c forwards the public functions to the core picked by cpu_create
+struct cpuCore {
+	void (*init)(void);
+	void (*destroy)(cpu_t* cpu);
+	bool (*setBlockCache)(cpu_t* cpu, const bool enabled);
+	bool (*setJit)(cpu_t* cpu, const bool enabled);
+	void (*flushBlockCache)(cpu_t* cpu);
+	void (*clock)(cpu_t* cpu);
+	void (*runInstruction)(cpu_t* cpu);
+	uint64_t (*runCycles)(cpu_t* cpu, uint64_t budget);
+	uint64_t (*runInstructions)(cpu_t* cpu, uint64_t count);
+	void (*printInstruction)(const uint16_t pc, const uint8_t* data);
+	cpuOpcodeInfo_t (*opcodeInfo)(const uint8_t opcode);
+};
+
+// bits of cpu_t.pendingControl
+#define PENDING_RESET 0x01
+#define PENDING_NMI 0x02
+#define PENDING_IRQ 0x04
+#define PENDING_HALT 0x08
+// set by a jump or branch to itself, execute skips ahead and clears it
+#define PENDING_IDLE 0x10
+// set by a breakpoint or watchpoint, the run functions return and the next call clears it
+#define PENDING_BREAK 0x20
+
+// an irq is pending while the line is active and the interrupt flag is clear
+// needs to be called every time either of them changes
+static inline void cpu_updateIrq(cpu_t* cpu) {
+	if (cpu->signals.irq && !cpu->registers.flags.I)
+		cpu->pendingControl |= PENDING_IRQ;
+	else
+		cpu->pendingControl &= ~PENDING_IRQ;
+}
+
+// stops the cpu at the next instruction boundary, if more breaks happen before that, the first is kept
+static inline void cpu_break(cpu_t* cpu, const cpuBreak_t reason, const uint16_t address) {
+	if (cpu->pendingControl & PENDING_BREAK)
+		return;
+
+	cpu->pendingControl |= PENDING_BREAK;
+	cpu->breakReason = reason;
+	cpu->breakAddress = address;
+}
+
+extern const struct cpuCore cpu_nmos6502Core;
+extern const struct cpuCore cpu_r65c02Core;
+extern const struct cpuCore cpu_w65c02Core;
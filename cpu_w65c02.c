@@ -0,0 +1,7 @@
+// the western design center 65C02, which adds WAI and STP to the rockwell instructions and turns illegal opcodes into nops
+#undef WDC
+#undef ROCKWEL
+#define WDC
+
+#define CPU_CORE cpu_w65c02Core
+#include "cpu_core.h"
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 typedef struct device device_t;
@@ -12,6 +14,11 @@ typedef struct {
 
 typedef uint8_t (*deviceRead)(deviceRef_t device, const addr_t addr);
 typedef void (*deviceWrite)(deviceRef_t device, const addr_t addr, const uint8_t data);
+typedef uint8_t* (*deviceMemory)(deviceRef_t device, const addr_t addr, size_t* size);
+typedef bool (*deviceShared)(deviceRef_t device, const addr_t addr);
+struct memoryMapping;
+typedef size_t (*deviceSerialize)(deviceRef_t device, uint8_t* data, const size_t size);
+typedef bool (*deviceDeserialize)(deviceRef_t device, const uint8_t* data, const size_t size, struct memoryMapping* mapping);
 
 /// a device to be placed on the bus
 /// a device can be anything connected to the bus, and provides a flexible interface
@@ -23,6 +30,20 @@ typedef void (*deviceWrite)(deviceRef_t device, const addr_t addr, const uint8_t
 /// getFunc should be NULL if it shouldn't have get functionality OR it is the same as readFunc
 /// writeFunc should be NULL if it shouldn't have write capability
 /// placeFunc should be NULL if it shouldn't have place functionality OR it is the same as writeFunc
+/// memoryFunc can be used by devices which are backed by plain memory, like ram or rom
+/// it returns a pointer to the byte at addr, and stores in size how many bytes from there on are backed contiguously
+/// the bus will then read and write that memory directly, instead of calling any of the other functions
+/// memory is only written directly if writeFunc is set, and the device won't be notified of these accesses
+/// memoryFunc should be NULL, or return NULL for an address, if accesses must go through the other functions
+/// sharedFunc can be used by devices which copy their memory on write, like cloned memory, or need to notice the first write to it
+/// it returns true if the memory at addr is shared, the bus then only reads that memory directly
+/// writes to it go through writeFunc or placeFunc, after which the bus asks memoryFunc for the memory again
+/// sharedFunc should be NULL if the memory handed out is never shared
+/// serializeFunc writes the private state of the device to data, if size bytes are enough, and returns the size of the state
+/// deserializeFunc restores a state written by serializeFunc, returning false if it doesn't fit the device
+/// data points into mapping, a device can keep pointing into it by retaining mapping, see memory_retainMapping
+/// mapping is NULL if data is only valid during the call
+/// a device without serializeFunc and deserializeFunc has no state of its own, like a device only forwarding accesses
 struct device {
 	void* const device_data;
 	const char* const name;
@@ -30,4 +51,8 @@ struct device {
 	const deviceRead getFunc;
 	const deviceWrite writeFunc;
 	const deviceWrite placeFunc;
+	const deviceMemory memoryFunc;
+	const deviceShared sharedFunc;
+	const deviceSerialize serializeFunc;
+	const deviceDeserialize deserializeFunc;
 };
@@ -0,0 +1,414 @@
+// MAP_ANONYMOUS isn't POSIX, and hidden by strict C modes without this
+// it has to come first, before any header includes <features.h>
+#ifndef _WIN32
+#define _DEFAULT_SOURCE
+#endif
+
+#include "jit.h"
+
+#include <string.h>
+
+#ifdef JIT_X86_64
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+// new code starts at this alignment, to keep jump targets in a single cache line
+#define CODE_ALIGNMENT 16
+
+// the buffer is never writable and executable at the same time
+// while code is emitted, the pages from the one holding the end of the finished code onward are writable instead of executable
+static bool protect(jit_t* jit, const bool writable) {
+#ifdef JIT_X86_64
+	const size_t begin = jit->used & ~(jit->pageSize - 1);
+	return mprotect(jit->buffer + begin, jit->size - begin, writable ? PROT_READ | PROT_WRITE : PROT_READ | PROT_EXEC) == 0;
+#else
+	(void) jit;
+	(void) writable;
+	return false;
+#endif
+}
+
+bool jit_init(jit_t* jit, size_t size) {
+	*jit = (jit_t) { 0 };
+
+#ifdef JIT_X86_64
+	void* buffer = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (buffer == MAP_FAILED)
+		return false;
+
+	jit->buffer = buffer;
+	jit->size = size;
+	jit->pageSize = (size_t) sysconf(_SC_PAGESIZE);
+
+	// hardened hosts refuse to make memory executable once it was writable, which is better found out before anything is translated
+	if (!protect(jit, false)) {
+		munmap(buffer, size);
+		*jit = (jit_t) { 0 };
+		return false;
+	}
+
+	return true;
+#else
+	(void) size;
+	return false;
+#endif
+}
+
+bool jit_destroy(jit_t* jit) {
+	if (jit->buffer == NULL)
+		return false;
+
+#ifdef JIT_X86_64
+	munmap(jit->buffer, jit->size);
+#endif
+	*jit = (jit_t) { 0 };
+
+	return true;
+}
+
+void jit_reset(jit_t* jit) {
+	jit->used = 0;
+	jit->position = 0;
+	jit->overflow = false;
+}
+
+bool jit_begin(jit_t* jit) {
+	jit->used = (jit->used + CODE_ALIGNMENT - 1) & ~(size_t) (CODE_ALIGNMENT - 1);
+	if (jit->used > jit->size)
+		jit->used = jit->size;
+
+	jit->position = jit->used;
+	jit->overflow = false;
+
+	return protect(jit, true);
+}
+
+void* jit_end(jit_t* jit) {
+	// the finished code sharing a page with the new code has to become executable again, even if the new code is dropped
+	if (!protect(jit, false) || jit->overflow) {
+		jit->position = jit->used;
+		return NULL;
+	}
+
+	void* code = jit->buffer + jit->used;
+	jit->used = jit->position;
+
+	return code;
+}
+
+size_t jit_position(const jit_t* jit) {
+	return jit->position;
+}
+
+void jit_emit8(jit_t* jit, const uint8_t byte) {
+	if (jit->position >= jit->size) {
+		jit->overflow = true;
+		return;
+	}
+
+	jit->buffer[jit->position++] = byte;
+}
+
+static void emit32(jit_t* jit, const uint32_t value) {
+	for (int i = 0; i < 4; i++)
+		jit_emit8(jit, (uint8_t) (value >> (i * 8)));
+}
+
+static void emit64(jit_t* jit, const uint64_t value) {
+	for (int i = 0; i < 8; i++)
+		jit_emit8(jit, (uint8_t) (value >> (i * 8)));
+}
+
+// emits a rex prefix when one is needed
+// byte operations always get one, so the low byte of rsp, rbp, rsi and rdi can be used
+static void rex(jit_t* jit, const bool wide, const bool byte, const int reg, const int index, const int base) {
+	uint8_t prefix = 0x40;
+	if (wide)
+		prefix |= 0x08;
+	if (reg != JIT_NONE && (reg & 8))
+		prefix |= 0x04;
+	if (index != JIT_NONE && (index & 8))
+		prefix |= 0x02;
+	if (base != JIT_NONE && (base & 8))
+		prefix |= 0x01;
+
+	if (prefix != 0x40 || byte)
+		jit_emit8(jit, prefix);
+}
+
+static void modrmReg(jit_t* jit, const int reg, const int rm) {
+	jit_emit8(jit, (uint8_t) (0xC0 | ((reg & 7) << 3) | (rm & 7)));
+}
+
+// [base + index + disp32], index can't be rsp
+static void modrmMem(jit_t* jit, const int reg, const jitReg_t base, const jitReg_t index, const int32_t disp) {
+	if (index != JIT_NONE) {
+		jit_emit8(jit, (uint8_t) (0x84 | ((reg & 7) << 3)));
+		jit_emit8(jit, (uint8_t) (((index & 7) << 3) | (base & 7)));
+	} else if ((base & 7) == JIT_RSP) {
+		jit_emit8(jit, (uint8_t) (0x84 | ((reg & 7) << 3)));
+		jit_emit8(jit, 0x24);
+	} else
+		jit_emit8(jit, (uint8_t) (0x80 | ((reg & 7) << 3) | (base & 7)));
+
+	emit32(jit, (uint32_t) disp);
+}
+
+void jit_mov(jit_t* jit, const jitReg_t dst, const jitReg_t src) {
+	rex(jit, false, false, src, JIT_NONE, dst);
+	jit_emit8(jit, 0x89);
+	modrmReg(jit, src, dst);
+}
+
+void jit_mov64(jit_t* jit, const jitReg_t dst, const jitReg_t src) {
+	rex(jit, true, false, src, JIT_NONE, dst);
+	jit_emit8(jit, 0x89);
+	modrmReg(jit, src, dst);
+}
+
+void jit_movImm(jit_t* jit, const jitReg_t dst, const uint32_t imm) {
+	rex(jit, false, false, JIT_NONE, JIT_NONE, dst);
+	jit_emit8(jit, (uint8_t) (0xB8 | (dst & 7)));
+	emit32(jit, imm);
+}
+
+void jit_movImm64(jit_t* jit, const jitReg_t dst, const uint64_t imm) {
+	rex(jit, true, false, JIT_NONE, JIT_NONE, dst);
+	jit_emit8(jit, (uint8_t) (0xB8 | (dst & 7)));
+	emit64(jit, imm);
+}
+
+void jit_movzx8(jit_t* jit, const jitReg_t dst, const jitReg_t src) {
+	rex(jit, false, true, dst, JIT_NONE, src);
+	jit_emit8(jit, 0x0F);
+	jit_emit8(jit, 0xB6);
+	modrmReg(jit, dst, src);
+}
+
+void jit_alu(jit_t* jit, const jitAlu_t op, const jitReg_t dst, const jitReg_t src) {
+	rex(jit, false, false, src, JIT_NONE, dst);
+	jit_emit8(jit, (uint8_t) ((op << 3) | 0x01));
+	modrmReg(jit, src, dst);
+}
+
+void jit_alu64(jit_t* jit, const jitAlu_t op, const jitReg_t dst, const jitReg_t src) {
+	rex(jit, true, false, src, JIT_NONE, dst);
+	jit_emit8(jit, (uint8_t) ((op << 3) | 0x01));
+	modrmReg(jit, src, dst);
+}
+
+void jit_alu8(jit_t* jit, const jitAlu_t op, const jitReg_t dst, const jitReg_t src) {
+	rex(jit, false, true, src, JIT_NONE, dst);
+	jit_emit8(jit, (uint8_t) (op << 3));
+	modrmReg(jit, src, dst);
+}
+
+static void aluImm(jit_t* jit, const bool wide, const jitAlu_t op, const jitReg_t dst, const int32_t imm) {
+	rex(jit, wide, false, JIT_NONE, JIT_NONE, dst);
+	if (imm >= -128 && imm <= 127) {
+		jit_emit8(jit, 0x83);
+		modrmReg(jit, op, dst);
+		jit_emit8(jit, (uint8_t) imm);
+	} else {
+		jit_emit8(jit, 0x81);
+		modrmReg(jit, op, dst);
+		emit32(jit, (uint32_t) imm);
+	}
+}
+
+void jit_aluImm(jit_t* jit, const jitAlu_t op, const jitReg_t dst, const int32_t imm) {
+	aluImm(jit, false, op, dst, imm);
+}
+
+void jit_aluImm64(jit_t* jit, const jitAlu_t op, const jitReg_t dst, const int32_t imm) {
+	aluImm(jit, true, op, dst, imm);
+}
+
+void jit_shift(jit_t* jit, const jitShift_t op, const jitReg_t reg, const uint8_t count) {
+	rex(jit, false, false, JIT_NONE, JIT_NONE, reg);
+	jit_emit8(jit, 0xC1);
+	modrmReg(jit, op, reg);
+	jit_emit8(jit, count);
+}
+
+void jit_imulImm(jit_t* jit, const jitReg_t dst, const jitReg_t src, const int32_t imm) {
+	rex(jit, false, false, dst, JIT_NONE, src);
+	jit_emit8(jit, 0x69);
+	modrmReg(jit, dst, src);
+	emit32(jit, (uint32_t) imm);
+}
+
+void jit_test(jit_t* jit, const jitReg_t a, const jitReg_t b) {
+	rex(jit, false, false, b, JIT_NONE, a);
+	jit_emit8(jit, 0x85);
+	modrmReg(jit, b, a);
+}
+
+void jit_test64(jit_t* jit, const jitReg_t a, const jitReg_t b) {
+	rex(jit, true, false, b, JIT_NONE, a);
+	jit_emit8(jit, 0x85);
+	modrmReg(jit, b, a);
+}
+
+void jit_testImm(jit_t* jit, const jitReg_t reg, const uint32_t imm) {
+	rex(jit, false, false, JIT_NONE, JIT_NONE, reg);
+	jit_emit8(jit, 0xF7);
+	modrmReg(jit, 0, reg);
+	emit32(jit, imm);
+}
+
+void jit_bt(jit_t* jit, const jitReg_t reg, const uint8_t bit) {
+	rex(jit, false, false, JIT_NONE, JIT_NONE, reg);
+	jit_emit8(jit, 0x0F);
+	jit_emit8(jit, 0xBA);
+	modrmReg(jit, 4, reg);
+	jit_emit8(jit, bit);
+}
+
+void jit_setcc(jit_t* jit, const jitCond_t cond, const jitReg_t dst) {
+	rex(jit, false, true, JIT_NONE, JIT_NONE, dst);
+	jit_emit8(jit, 0x0F);
+	jit_emit8(jit, (uint8_t) (0x90 | cond));
+	modrmReg(jit, 0, dst);
+}
+
+void jit_load8(jit_t* jit, const jitReg_t dst, const jitReg_t base, const jitReg_t index, const int32_t disp) {
+	rex(jit, false, false, dst, index, base);
+	jit_emit8(jit, 0x0F);
+	jit_emit8(jit, 0xB6);
+	modrmMem(jit, dst, base, index, disp);
+}
+
+void jit_load16(jit_t* jit, const jitReg_t dst, const jitReg_t base, const jitReg_t index, const int32_t disp) {
+	rex(jit, false, false, dst, index, base);
+	jit_emit8(jit, 0x0F);
+	jit_emit8(jit, 0xB7);
+	modrmMem(jit, dst, base, index, disp);
+}
+
+void jit_load32(jit_t* jit, const jitReg_t dst, const jitReg_t base, const jitReg_t index, const int32_t disp) {
+	rex(jit, false, false, dst, index, base);
+	jit_emit8(jit, 0x8B);
+	modrmMem(jit, dst, base, index, disp);
+}
+
+void jit_load64(jit_t* jit, const jitReg_t dst, const jitReg_t base, const jitReg_t index, const int32_t disp) {
+	rex(jit, true, false, dst, index, base);
+	jit_emit8(jit, 0x8B);
+	modrmMem(jit, dst, base, index, disp);
+}
+
+void jit_store8(jit_t* jit, const jitReg_t base, const jitReg_t index, const int32_t disp, const jitReg_t src) {
+	rex(jit, false, true, src, index, base);
+	jit_emit8(jit, 0x88);
+	modrmMem(jit, src, base, index, disp);
+}
+
+void jit_store16(jit_t* jit, const jitReg_t base, const int32_t disp, const jitReg_t src) {
+	jit_emit8(jit, 0x66);
+	rex(jit, false, false, src, JIT_NONE, base);
+	jit_emit8(jit, 0x89);
+	modrmMem(jit, src, base, JIT_NONE, disp);
+}
+
+void jit_store32(jit_t* jit, const jitReg_t base, const int32_t disp, const jitReg_t src) {
+	rex(jit, false, false, src, JIT_NONE, base);
+	jit_emit8(jit, 0x89);
+	modrmMem(jit, src, base, JIT_NONE, disp);
+}
+
+void jit_store64(jit_t* jit, const jitReg_t base, const int32_t disp, const jitReg_t src) {
+	rex(jit, true, false, src, JIT_NONE, base);
+	jit_emit8(jit, 0x89);
+	modrmMem(jit, src, base, JIT_NONE, disp);
+}
+
+void jit_store8Imm(jit_t* jit, const jitReg_t base, const int32_t disp, const uint8_t imm) {
+	rex(jit, false, false, JIT_NONE, JIT_NONE, base);
+	jit_emit8(jit, 0xC6);
+	modrmMem(jit, 0, base, JIT_NONE, disp);
+	jit_emit8(jit, imm);
+}
+
+void jit_store16Imm(jit_t* jit, const jitReg_t base, const int32_t disp, const uint16_t imm) {
+	jit_emit8(jit, 0x66);
+	rex(jit, false, false, JIT_NONE, JIT_NONE, base);
+	jit_emit8(jit, 0xC7);
+	modrmMem(jit, 0, base, JIT_NONE, disp);
+	jit_emit8(jit, (uint8_t) imm);
+	jit_emit8(jit, (uint8_t) (imm >> 8));
+}
+
+void jit_add8Imm(jit_t* jit, const jitReg_t base, const int32_t disp, const uint8_t imm) {
+	rex(jit, false, false, JIT_NONE, JIT_NONE, base);
+	jit_emit8(jit, 0x80);
+	modrmMem(jit, JIT_ADD, base, JIT_NONE, disp);
+	jit_emit8(jit, imm);
+}
+
+void jit_add64Imm(jit_t* jit, const jitReg_t base, const int32_t disp, const int32_t imm) {
+	rex(jit, true, false, JIT_NONE, JIT_NONE, base);
+	jit_emit8(jit, 0x81);
+	modrmMem(jit, JIT_ADD, base, JIT_NONE, disp);
+	emit32(jit, (uint32_t) imm);
+}
+
+void jit_cmp8Imm(jit_t* jit, const jitReg_t base, const int32_t disp, const uint8_t imm) {
+	rex(jit, false, false, JIT_NONE, JIT_NONE, base);
+	jit_emit8(jit, 0x80);
+	modrmMem(jit, JIT_CMP, base, JIT_NONE, disp);
+	jit_emit8(jit, imm);
+}
+
+size_t jit_jcc(jit_t* jit, const jitCond_t cond) {
+	jit_emit8(jit, 0x0F);
+	jit_emit8(jit, (uint8_t) (0x80 | cond));
+	size_t jump = jit->position;
+	emit32(jit, 0);
+
+	return jump;
+}
+
+size_t jit_jmp(jit_t* jit) {
+	jit_emit8(jit, 0xE9);
+	size_t jump = jit->position;
+	emit32(jit, 0);
+
+	return jump;
+}
+
+void jit_patch(jit_t* jit, const size_t jump, const size_t target) {
+	if (jit->overflow)
+		return;
+
+	// relative to the end of the jump instruction
+	int32_t offset = (int32_t) (target - (jump + 4));
+	memcpy(jit->buffer + jump, &offset, sizeof(offset));
+}
+
+void jit_jmpReg(jit_t* jit, const jitReg_t reg) {
+	rex(jit, false, false, JIT_NONE, JIT_NONE, reg);
+	jit_emit8(jit, 0xFF);
+	modrmReg(jit, 4, reg);
+}
+
+void jit_call(jit_t* jit, const void* function) {
+	jit_movImm64(jit, JIT_RAX, (uint64_t) (uintptr_t) function);
+	jit_emit8(jit, 0xFF);
+	jit_emit8(jit, 0xD0);
+}
+
+void jit_push(jit_t* jit, const jitReg_t reg) {
+	rex(jit, false, false, JIT_NONE, JIT_NONE, reg);
+	jit_emit8(jit, (uint8_t) (0x50 | (reg & 7)));
+}
+
+void jit_pop(jit_t* jit, const jitReg_t reg) {
+	rex(jit, false, false, JIT_NONE, JIT_NONE, reg);
+	jit_emit8(jit, (uint8_t) (0x58 | (reg & 7)));
+}
+
+void jit_ret(jit_t* jit) {
+	jit_emit8(jit, 0xC3);
+}
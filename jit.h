@@ -0,0 +1,115 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// the translator emits x86-64 code for the System V calling convention
+// everywhere else the jit is not available, and jit_init will fail
+#if defined(__x86_64__) && !defined(_WIN32) && !defined(NO_JIT)
+#define JIT_X86_64
+#endif
+
+/// executable memory native code gets emitted into
+/// code is emitted between jit_begin and jit_end, and stays valid until jit_reset
+/// the memory is only writable between jit_begin and jit_end, and only executable outside of them
+typedef struct jit {
+	uint8_t* buffer;
+	size_t size;
+	size_t pageSize;
+	// bytes in use by finished code
+	size_t used;
+	// where the next byte is emitted
+	size_t position;
+	// set if the code being emitted didn't fit in the buffer
+	bool overflow;
+} jit_t;
+
+typedef enum {
+	JIT_RAX, JIT_RCX, JIT_RDX, JIT_RBX, JIT_RSP, JIT_RBP, JIT_RSI, JIT_RDI,
+	JIT_R8, JIT_R9, JIT_R10, JIT_R11, JIT_R12, JIT_R13, JIT_R14, JIT_R15,
+	JIT_NONE = -1
+} jitReg_t;
+
+// values match the /digit of the x86 immediate alu instructions
+typedef enum {
+	JIT_ADD = 0, JIT_OR = 1, JIT_ADC = 2, JIT_SBB = 3,
+	JIT_AND = 4, JIT_SUB = 5, JIT_XOR = 6, JIT_CMP = 7
+} jitAlu_t;
+
+// values match the x86 condition codes
+typedef enum {
+	JIT_O = 0x0, JIT_NO = 0x1, JIT_C = 0x2, JIT_NC = 0x3,
+	JIT_Z = 0x4, JIT_NZ = 0x5, JIT_BE = 0x6, JIT_A = 0x7,
+	JIT_S = 0x8, JIT_NS = 0x9
+} jitCond_t;
+
+typedef enum {
+	JIT_SHL = 4, JIT_SHR = 5
+} jitShift_t;
+
+/// maps size bytes of executable memory
+/// returns false if the host doesn't allow memory to be made executable after writing to it
+bool jit_init(jit_t* jit, size_t size);
+bool jit_destroy(jit_t* jit);
+
+/// forgets all code emitted so far, any pointer to it becomes invalid
+void jit_reset(jit_t* jit);
+
+/// starts emitting a new piece of code
+/// returns false if the memory could not be made writable, nothing can be emitted then
+bool jit_begin(jit_t* jit);
+/// finishes the code started with jit_begin
+/// returns the start of the code, or NULL if it didn't fit or the memory could not be made executable again
+/// in both cases nothing is kept, and in the latter code emitted earlier can't run until jit_reset
+void* jit_end(jit_t* jit);
+
+/// position of the next emitted byte, to be used as jump target
+size_t jit_position(const jit_t* jit);
+
+/// all register operations work on 32 bit registers, unless stated otherwise
+/// memory operands are [base + index + disp], index can be JIT_NONE
+void jit_emit8(jit_t* jit, const uint8_t byte);
+void jit_mov(jit_t* jit, const jitReg_t dst, const jitReg_t src);
+void jit_mov64(jit_t* jit, const jitReg_t dst, const jitReg_t src);
+void jit_movImm(jit_t* jit, const jitReg_t dst, const uint32_t imm);
+void jit_movImm64(jit_t* jit, const jitReg_t dst, const uint64_t imm);
+void jit_movzx8(jit_t* jit, const jitReg_t dst, const jitReg_t src);
+void jit_alu(jit_t* jit, const jitAlu_t op, const jitReg_t dst, const jitReg_t src);
+void jit_alu64(jit_t* jit, const jitAlu_t op, const jitReg_t dst, const jitReg_t src);
+void jit_alu8(jit_t* jit, const jitAlu_t op, const jitReg_t dst, const jitReg_t src);
+void jit_aluImm(jit_t* jit, const jitAlu_t op, const jitReg_t dst, const int32_t imm);
+void jit_aluImm64(jit_t* jit, const jitAlu_t op, const jitReg_t dst, const int32_t imm);
+void jit_shift(jit_t* jit, const jitShift_t op, const jitReg_t reg, const uint8_t count);
+void jit_imulImm(jit_t* jit, const jitReg_t dst, const jitReg_t src, const int32_t imm);
+void jit_test(jit_t* jit, const jitReg_t a, const jitReg_t b);
+void jit_test64(jit_t* jit, const jitReg_t a, const jitReg_t b);
+void jit_testImm(jit_t* jit, const jitReg_t reg, const uint32_t imm);
+void jit_bt(jit_t* jit, const jitReg_t reg, const uint8_t bit);
+void jit_setcc(jit_t* jit, const jitCond_t cond, const jitReg_t dst);
+
+/// load8 and load16 zero extend
+void jit_load8(jit_t* jit, const jitReg_t dst, const jitReg_t base, const jitReg_t index, const int32_t disp);
+void jit_load16(jit_t* jit, const jitReg_t dst, const jitReg_t base, const jitReg_t index, const int32_t disp);
+void jit_load32(jit_t* jit, const jitReg_t dst, const jitReg_t base, const jitReg_t index, const int32_t disp);
+void jit_load64(jit_t* jit, const jitReg_t dst, const jitReg_t base, const jitReg_t index, const int32_t disp);
+void jit_store8(jit_t* jit, const jitReg_t base, const jitReg_t index, const int32_t disp, const jitReg_t src);
+void jit_store16(jit_t* jit, const jitReg_t base, const int32_t disp, const jitReg_t src);
+void jit_store32(jit_t* jit, const jitReg_t base, const int32_t disp, const jitReg_t src);
+void jit_store64(jit_t* jit, const jitReg_t base, const int32_t disp, const jitReg_t src);
+void jit_store8Imm(jit_t* jit, const jitReg_t base, const int32_t disp, const uint8_t imm);
+void jit_store16Imm(jit_t* jit, const jitReg_t base, const int32_t disp, const uint16_t imm);
+void jit_add8Imm(jit_t* jit, const jitReg_t base, const int32_t disp, const uint8_t imm);
+void jit_add64Imm(jit_t* jit, const jitReg_t base, const int32_t disp, const int32_t imm);
+void jit_cmp8Imm(jit_t* jit, const jitReg_t base, const int32_t disp, const uint8_t imm);
+
+/// jumps return the position of their target, which can be filled in with jit_patch
+size_t jit_jcc(jit_t* jit, const jitCond_t cond);
+size_t jit_jmp(jit_t* jit);
+void jit_patch(jit_t* jit, const size_t jump, const size_t target);
+/// jumps to the address held by reg
+void jit_jmpReg(jit_t* jit, const jitReg_t reg);
+void jit_call(jit_t* jit, const void* function);
+void jit_push(jit_t* jit, const jitReg_t reg);
+void jit_pop(jit_t* jit, const jitReg_t reg);
+void jit_ret(jit_t* jit);
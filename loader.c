@@ -0,0 +1,298 @@
+#include "loader.h"
+#include "util.h"
+
+#include <ctype.h>
+#include <string.h>
+
+// long enough for the longest intel hex and s-record records, 255 data bytes
+#define LINE_LENGTH 1024
+
+// state of a single load
+struct load {
+	bus_t* bus;
+	loaderResult_t* result;
+	// added to the addresses of intel hex data records, set by extended address records
+	uint32_t base;
+	// set by the end of file record, everything after it is ignored
+	bool ended;
+};
+
+// reads the byte written as 2 hex digits at text
+static bool hexByte(const char* text, uint8_t* value) {
+	const int high = hexDigit(text[0]);
+	if (high < 0)
+		return false;
+	const int low = hexDigit(text[1]);
+	if (low < 0)
+		return false;
+
+	*value = (uint8_t) ((high << 4) | low);
+	return true;
+}
+
+// reads count bytes written as hex digits, text has to hold exactly those
+static bool hexBytes(const char* text, const size_t length, uint8_t* bytes, const size_t count) {
+	if (length != count * 2)
+		return false;
+
+	for (size_t i = 0; i < count; i++)
+		if (!hexByte(text + i * 2, bytes + i))
+			return false;
+
+	return true;
+}
+
+// places the bytes of a record at address, which has to fit in the address space
+static bool place(struct load* load, const uint32_t address, const uint8_t* bytes, const size_t count) {
+	if (address + count > 0x10000)
+		return false;
+	if (count == 0)
+		return true;
+
+	// a byte nothing on the bus takes would be lost, which makes the file not fit this bus
+	// all of them are checked first, so a record that doesn't fit places nothing
+	for (size_t i = 0; i < count; i++)
+		if (!bus_canPlace(load->bus, (uint16_t) (address + i)))
+			return false;
+	for (size_t i = 0; i < count; i++)
+		bus_place(load->bus, (uint16_t) (address + i), bytes[i]);
+
+	loaderResult_t* result = load->result;
+	if (result->bytes == 0 || address < result->lowest)
+		result->lowest = (uint16_t) address;
+	if (result->bytes == 0 || address + count - 1 > result->highest)
+		result->highest = (uint16_t) (address + count - 1);
+	result->bytes += count;
+
+	return true;
+}
+
+static void setEntry(struct load* load, const uint32_t address) {
+	load->result->hasEntry = address <= 0xFFFF;
+	load->result->entry = (uint16_t) address;
+}
+
+// ":LLAAAATT<data>CC", the checksum makes the sum of all bytes 0
+static bool loadIntelHex(struct load* load, const char* line, const size_t length) {
+	uint8_t bytes[5 + 255];
+	if (line[0] != ':' || length < 11 || !hexByte(line + 1, bytes))
+		return false;
+
+	const size_t count = 5 + bytes[0];
+	if (!hexBytes(line + 1, length - 1, bytes, count))
+		return false;
+
+	uint8_t sum = 0;
+	for (size_t i = 0; i < count; i++)
+		sum += bytes[i];
+	if (sum != 0)
+		return false;
+
+	const uint8_t dataLength = bytes[0];
+	const uint16_t address = (uint16_t) ((bytes[1] << 8) | bytes[2]);
+	const uint8_t* data = bytes + 4;
+
+	switch (bytes[3]) {
+	case 0x00: // data
+		return place(load, load->base + address, data, dataLength);
+	case 0x01: // end of file
+		load->ended = true;
+		return true;
+	case 0x02: // extended segment address
+		if (dataLength != 2)
+			return false;
+		load->base = (uint32_t) ((data[0] << 8) | data[1]) << 4;
+		return true;
+	case 0x03: // start segment address, CS:IP
+		if (dataLength != 4)
+			return false;
+		setEntry(load, ((uint32_t) ((data[0] << 8) | data[1]) << 4) + (uint32_t) ((data[2] << 8) | data[3]));
+		return true;
+	case 0x04: // extended linear address
+		if (dataLength != 2)
+			return false;
+		load->base = (uint32_t) ((data[0] << 8) | data[1]) << 16;
+		return true;
+	case 0x05: // start linear address
+		if (dataLength != 4)
+			return false;
+		setEntry(load, ((uint32_t) data[0] << 24) | ((uint32_t) data[1] << 16) | ((uint32_t) data[2] << 8) | data[3]);
+		return true;
+	default:
+		return false;
+	}
+}
+
+// "STCC<address><data>SS", the count covers address, data and checksum, which is the complement of their sum and the count
+static bool loadSRecord(struct load* load, const char* line, const size_t length) {
+	uint8_t bytes[1 + 255];
+	if (line[0] != 'S' || length < 4 || !hexByte(line + 2, bytes))
+		return false;
+
+	const size_t count = 1 + bytes[0];
+	if (!hexBytes(line + 2, length - 2, bytes, count))
+		return false;
+
+	uint8_t sum = 0;
+	for (size_t i = 0; i < count; i++)
+		sum += bytes[i];
+	if (sum != 0xFF)
+		return false;
+
+	size_t addressLength;
+	switch (line[1]) {
+	case '0': // header
+	case '5': // record count
+	case '6':
+		return true;
+	case '1': case '9': addressLength = 2; break;
+	case '2': case '8': addressLength = 3; break;
+	case '3': case '7': addressLength = 4; break;
+	default:
+		return false;
+	}
+
+	if (count < 1 + addressLength + 1)
+		return false;
+
+	uint32_t address = 0;
+	for (size_t i = 0; i < addressLength; i++)
+		address = (address << 8) | bytes[1 + i];
+
+	if (line[1] >= '7') {
+		setEntry(load, address);
+		return true;
+	}
+
+	return place(load, address, bytes + 1 + addressLength, count - 1 - addressLength - 1);
+}
+
+// "FFFF" once, then segments of "SSSS EEEE <data>" with little endian addresses, holding the bytes from start to end
+// "FFFF" can also appear between segments
+static bool loadSegments(struct load* load, FILE* file) {
+	uint8_t header[4];
+	uint8_t bytes[256];
+	bool first = true;
+
+	while (true) {
+		size_t read = fread(header, 1, 2, file);
+		if (read == 0 && !first)
+			return !ferror(file);
+		if (read != 2)
+			return false;
+		first = false;
+
+		if (header[0] == 0xFF && header[1] == 0xFF)
+			continue;
+
+		if (fread(header + 2, 1, 2, file) != 2)
+			return false;
+		load->result->records++;
+
+		const uint16_t start = (uint16_t) (header[0] | (header[1] << 8));
+		const uint16_t end = (uint16_t) (header[2] | (header[3] << 8));
+		if (end < start)
+			return false;
+
+		for (uint32_t address = start; address <= end; ) {
+			size_t count = end - address + 1;
+			if (count > sizeof(bytes))
+				count = sizeof(bytes);
+			if (fread(bytes, 1, count, file) != count || !place(load, address, bytes, count))
+				return false;
+			address += (uint32_t) count;
+		}
+
+		if (start <= LOADER_SEGMENTS_RUN_ADDRESS && end >= LOADER_SEGMENTS_RUN_ADDRESS + 1)
+			setEntry(load, bus_get(load->bus, LOADER_SEGMENTS_RUN_ADDRESS) | (bus_get(load->bus, LOADER_SEGMENTS_RUN_ADDRESS + 1) << 8));
+	}
+}
+
+// picks the format from the first byte of file, without taking it
+static loaderFormat_t detect(FILE* file) {
+	const int c = fgetc(file);
+	if (c == EOF)
+		return LOADER_AUTO;
+	ungetc(c, file);
+
+	switch (c) {
+	case ':': return LOADER_INTEL_HEX;
+	case 'S': return LOADER_SREC;
+	case 0xFF: return LOADER_SEGMENTS;
+	default: return LOADER_AUTO;
+	}
+}
+
+bool loader_loadStream(bus_t* bus, FILE* file, const loaderFormat_t format, loaderResult_t* result) {
+	loaderResult_t ignored;
+	if (result == NULL)
+		result = &ignored;
+	*result = (loaderResult_t) { .format = format };
+
+	struct load load = { .bus = bus, .result = result };
+
+	if (result->format == LOADER_AUTO)
+		result->format = detect(file);
+
+	if (result->format == LOADER_SEGMENTS) {
+		if (!loadSegments(&load, file)) {
+			printf("bad segment %zu\n", result->records);
+			result->errorLine = result->records ? result->records : 1;
+			return false;
+		}
+		return true;
+	}
+
+	if (result->format != LOADER_INTEL_HEX && result->format != LOADER_SREC) {
+		printf("unknown file format\n");
+		return false;
+	}
+
+	char line[LINE_LENGTH];
+	size_t number = 0;
+	while (!load.ended && fgets(line, sizeof(line), file)) {
+		number++;
+
+		size_t length = strlen(line);
+		const bool complete = length > 0 && line[length - 1] == '\n';
+		// too long for any record
+		if (!complete && !feof(file)) {
+			result->errorLine = number;
+			break;
+		}
+		while (length > 0 && isspace((unsigned char) line[length - 1]))
+			length--;
+		line[length] = 0;
+
+		if (length == 0)
+			continue;
+
+		result->records++;
+		const bool loaded = result->format == LOADER_INTEL_HEX ? loadIntelHex(&load, line, length) : loadSRecord(&load, line, length);
+		if (!loaded) {
+			result->errorLine = number;
+			break;
+		}
+	}
+
+	if (result->errorLine) {
+		printf("bad record on line %zu\n", result->errorLine);
+		return false;
+	}
+
+	return !ferror(file);
+}
+
+bool loader_load(bus_t* bus, const char* fileName, const loaderFormat_t format, loaderResult_t* result) {
+	// binary, the text formats skip the carriage returns themselves
+	FILE* file = fopen(fileName, "rb");
+	if (!file) {
+		printf("could not open file %s\n", fileName);
+		return false;
+	}
+
+	const bool loaded = loader_loadStream(bus, file, format, result);
+	fclose(file);
+
+	return loaded;
+}
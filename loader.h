@@ -0,0 +1,44 @@
+#pragma once
+
+#include "bus.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/// formats loader_load understands, all of them only hold the bytes that are actually used
+typedef enum {
+	LOADER_AUTO, // picked from the first byte of the file
+	LOADER_INTEL_HEX, // ':' records, as written by AS65 with -h0
+	LOADER_SREC, // Motorola S-records, S1 to S3 data and S7 to S9 start addresses
+	LOADER_SEGMENTS, // binary segments, $FFFF followed by segments of a start address, an end address and the bytes in between
+} loaderFormat_t;
+
+/// segments placing an address here set the entry point, like the run address of atari dos binaries
+#define LOADER_SEGMENTS_RUN_ADDRESS 0x02E0
+
+/// what was loaded
+/// every byte is placed on the bus as soon as its record is read, nothing is kept in between
+typedef struct {
+	loaderFormat_t format;
+	size_t records;
+	size_t bytes;
+	// the lowest and highest address written, only valid if bytes isn't 0
+	uint16_t lowest;
+	uint16_t highest;
+	// the start address given by the file, a start record or a segment placing LOADER_SEGMENTS_RUN_ADDRESS
+	bool hasEntry;
+	uint16_t entry;
+	// the line holding the record that could not be loaded, or the number of the segment, 0 if there was none
+	size_t errorLine;
+} loaderResult_t;
+
+/// loads fileName into bus with bus_place, so roms get their contents and devices are not triggered
+/// bytes outside of the 64 KiB address space, bad checksums and malformed records stop the load
+/// so do bytes nothing on the bus takes, where no device was added, or the device can't be placed, like a rom mapped read only
+/// a load is not undone, the bytes of every record before the bad one are already on the bus, those of the bad one are not
+/// result can be NULL
+/// returns false if the file can't be read, or holds a bad record
+bool loader_load(bus_t* bus, const char* fileName, const loaderFormat_t format, loaderResult_t* result);
+/// same as loader_load, reading from an open file, which can be a pipe
+bool loader_loadStream(bus_t* bus, FILE* file, const loaderFormat_t format, loaderResult_t* result);
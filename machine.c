@@ -0,0 +1,220 @@
+#include "machine.h"
+
+#include <stdlib.h>
+#include <time.h>
+
+// wakes the thread running the machine, if it waits in machine_sleep
+// the change it should notice has to be stored before, machine_sleep sets parked before looking for changes
+// with the fences on both sides, either this sees parked, or machine_sleep sees the change
+static void wake(machine_t* machine) {
+	atomic_thread_fence(memory_order_seq_cst);
+	if (!atomic_load_explicit(&machine->parked, memory_order_relaxed))
+		return;
+
+	// the lock is held by machine_sleep until it waits, so the signal can't get in before that
+	mtx_lock(&machine->lock);
+	cnd_signal(&machine->wakeup);
+	mtx_unlock(&machine->lock);
+}
+
+bool machine_init(machine_t* machine) {
+	return machine_create(machine, CPU_DEFAULT_VARIANT);
+}
+
+bool machine_create(machine_t* machine, const cpuVariant_t variant) {
+	if (!bus_init(&machine->bus))
+		return false;
+
+	if (!cpu_create(&machine->cpu, &machine->bus, variant)) {
+		bus_destroy(&machine->bus);
+		return false;
+	}
+
+	if (!scheduler_init(&machine->scheduler)) {
+		cpu_destroy(&machine->cpu);
+		bus_destroy(&machine->bus);
+		return false;
+	}
+	cpu_setScheduler(&machine->cpu, &machine->scheduler);
+
+	if (mtx_init(&machine->lock, mtx_plain) != thrd_success) {
+		scheduler_destroy(&machine->scheduler);
+		cpu_destroy(&machine->cpu);
+		bus_destroy(&machine->bus);
+		return false;
+	}
+	if (cnd_init(&machine->wakeup) != thrd_success) {
+		mtx_destroy(&machine->lock);
+		scheduler_destroy(&machine->scheduler);
+		cpu_destroy(&machine->cpu);
+		bus_destroy(&machine->bus);
+		return false;
+	}
+
+	signals_init(&machine->signals);
+	machine->delayed = NULL;
+	machine->delayedCount = 0;
+	machine->delayedCapacity = 0;
+	machine->delayedEvent = 0;
+
+	machine->running = false;
+	machine->parked = false;
+
+	return true;
+}
+
+bool machine_destroy(machine_t* machine) {
+	machine->running = false;
+
+	cnd_destroy(&machine->wakeup);
+	mtx_destroy(&machine->lock);
+	scheduler_destroy(&machine->scheduler);
+	free(machine->delayed);
+	machine->delayed = NULL;
+
+	cpu_destroy(&machine->cpu);
+	return bus_destroy(&machine->bus);
+}
+
+void machine_stop(machine_t* machine) {
+	machine->running = false;
+	wake(machine);
+}
+
+static bool post(machine_t* machine, const signalChange_t change) {
+	if (!signals_post(&machine->signals, &change))
+		return false;
+
+	// the thread running the machine takes the change at the next instruction boundary, not after its slice
+	cpu_requestStop(&machine->cpu);
+	wake(machine);
+	return true;
+}
+
+bool machine_postIrq(machine_t* machine, const uint8_t source, const bool active, const uint64_t cycle) {
+	return post(machine, (signalChange_t) { .cycle = cycle, .line = SIGNAL_IRQ, .source = source, .active = active });
+}
+
+bool machine_postNmi(machine_t* machine, const bool active, const uint64_t cycle) {
+	return post(machine, (signalChange_t) { .cycle = cycle, .line = SIGNAL_NMI, .active = active });
+}
+
+bool machine_postReset(machine_t* machine, const bool active, const uint64_t cycle) {
+	return post(machine, (signalChange_t) { .cycle = cycle, .line = SIGNAL_RESET, .active = active });
+}
+
+static void apply(machine_t* machine, const signalChange_t* change) {
+	switch (change->line) {
+	case SIGNAL_IRQ:
+		if (change->active)
+			cpu_assertIrq(&machine->cpu, change->source);
+		else
+			cpu_deassertIrq(&machine->cpu, change->source);
+		break;
+	case SIGNAL_NMI:
+		cpu_nmi(&machine->cpu, change->active);
+		break;
+	case SIGNAL_RESET:
+		cpu_reset(&machine->cpu, change->active);
+		break;
+	}
+}
+
+static void applyDelayed(void* context, const uint64_t cycle);
+
+// applies the delayed changes that are due, in the order they were posted
+// the event is moved to the earliest of the remaining changes
+static void updateDelayed(machine_t* machine) {
+	const uint64_t now = machine->cpu.totalCycles;
+	uint64_t next = UINT64_MAX;
+
+	size_t kept = 0;
+	for (size_t i = 0; i < machine->delayedCount; i++) {
+		const signalChange_t* change = machine->delayed + i;
+		if (change->cycle <= now)
+			apply(machine, change);
+		else {
+			if (change->cycle < next)
+				next = change->cycle;
+			machine->delayed[kept++] = *change;
+		}
+	}
+	machine->delayedCount = kept;
+
+	scheduler_cancel(&machine->scheduler, machine->delayedEvent);
+	machine->delayedEvent = next != UINT64_MAX ? scheduler_add(&machine->scheduler, next, applyDelayed, machine) : 0;
+}
+
+static void applyDelayed(void* context, const uint64_t cycle) {
+	(void) cycle;
+	machine_t* machine = context;
+
+	// the event already ran, it can't be canceled anymore
+	machine->delayedEvent = 0;
+	updateDelayed(machine);
+}
+
+// makes room for one more delayed change, returns false if the list couldn't grow
+static bool growDelayed(machine_t* machine) {
+	if (machine->delayedCount < machine->delayedCapacity)
+		return true;
+
+	const size_t capacity = machine->delayedCapacity ? machine->delayedCapacity * 2 : SIGNAL_QUEUE_SIZE;
+	signalChange_t* delayed = realloc(machine->delayed, sizeof(signalChange_t) * capacity);
+	if (delayed == NULL)
+		return false;
+
+	machine->delayed = delayed;
+	machine->delayedCapacity = capacity;
+	return true;
+}
+
+void machine_takeSignals(machine_t* machine) {
+	bool delayed = false;
+
+	// every change posted so far is taken below, so the cpu doesn't have to stop for those anymore
+	// a change posted after this requests a stop again
+	atomic_store_explicit(&machine->cpu.stopRequested, false, memory_order_relaxed);
+
+	signalChange_t change;
+	// every change is taken, as machine_sleep returns right away while any is left in the queue
+	// only if the delayed list can't grow the remaining ones stay there, until the next call
+	while (growDelayed(machine) && signals_take(&machine->signals, &change)) {
+		if (change.cycle <= machine->cpu.totalCycles)
+			apply(machine, &change);
+		else {
+			machine->delayed[machine->delayedCount++] = change;
+			delayed = true;
+		}
+	}
+
+	if (delayed)
+		updateDelayed(machine);
+}
+
+void machine_park(machine_t* machine, const uint64_t timeout_us) {
+	// only the thread running the machine changes the cpu, so it stays halted while waiting
+	if (cpu_isHalted(&machine->cpu))
+		machine_sleep(machine, timeout_us);
+}
+
+void machine_sleep(machine_t* machine, const uint64_t timeout_us) {
+	struct timespec deadline;
+	timespec_get(&deadline, TIME_UTC);
+	deadline.tv_sec += (time_t) (timeout_us / 1000000);
+	deadline.tv_nsec += (long) (timeout_us % 1000000) * 1000;
+	if (deadline.tv_nsec >= 1000000000) {
+		deadline.tv_sec++;
+		deadline.tv_nsec -= 1000000000;
+	}
+
+	mtx_lock(&machine->lock);
+	atomic_store_explicit(&machine->parked, true, memory_order_relaxed);
+	atomic_thread_fence(memory_order_seq_cst);
+	// a change posted before parked was set is already in the queue, so it isn't missed
+	while (machine->running && !signals_waiting(&machine->signals))
+		if (cnd_timedwait(&machine->wakeup, &machine->lock, &deadline) != thrd_success)
+			break;
+	atomic_store_explicit(&machine->parked, false, memory_order_relaxed);
+	mtx_unlock(&machine->lock);
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "bus.h"
+#include "cpu.h"
+#include "scheduler.h"
+#include "signals.h"
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <threads.h>
+
+/// a complete emulated system, a cpu with its own bus
+/// every machine is independent, so many machines can run in a single process
+/// a single machine should only be driven by one thread at a time
+typedef struct machine {
+	bus_t bus;
+	cpu_t cpu;
+	// events of the devices, see clock_schedule
+	scheduler_t scheduler;
+
+	/// set while clock_run is running this machine, clearing it stops clock_run
+	atomic_bool running;
+
+	// control input changes posted from other threads, see machine_postIrq
+	signalQueue_t signals;
+	// changes taken from signals which are due at a later cycle, applied by the event delayedEvent
+	// grows as needed, so every change in signals can be taken
+	signalChange_t* delayed;
+	size_t delayedCount;
+	size_t delayedCapacity;
+	eventId_t delayedEvent;
+
+	// the thread running the machine waits on wakeup while the cpu is halted or ahead of real time, with parked set
+	// posting threads only take the lock to signal wakeup while parked is set
+	mtx_t lock;
+	cnd_t wakeup;
+	atomic_bool parked;
+} machine_t;
+
+/// initializes the bus and cpu of machine, with a cpu of CPU_DEFAULT_VARIANT
+/// machine should be zero initialized
+bool machine_init(machine_t* machine);
+/// same as machine_init, with a cpu of the given variant
+/// the cpu refers back to the machine, so the machine can't be moved afterwards
+bool machine_create(machine_t* machine, const cpuVariant_t variant);
+bool machine_destroy(machine_t* machine);
+
+/// stops clock_run, and wakes it up if it is waiting on a halted cpu
+/// can be called from any thread
+void machine_stop(machine_t* machine);
+
+/// changes a control input of the cpu from any thread, without waiting on the thread running the machine
+/// the change is applied by clock_runWith at the first instruction boundary once the cpu reached cycle, 0 applies it as soon as possible
+/// the running slice ends at the next instruction boundary to take the change, see cpu_requestStop
+/// a thread waiting on a halted cpu is woken up, taking a lock only then, posting is lock-free otherwise
+/// returns false if too many changes are waiting to be applied
+bool machine_postIrq(machine_t* machine, const uint8_t source, const bool active, const uint64_t cycle);
+bool machine_postNmi(machine_t* machine, const bool active, const uint64_t cycle);
+bool machine_postReset(machine_t* machine, const bool active, const uint64_t cycle);
+
+/// applies the control input changes posted from other threads, or schedules them for their cycle
+/// should only be called by the thread running the machine, clock_runWith does so after every slice
+void machine_takeSignals(machine_t* machine);
+
+/// blocks the calling thread while the cpu is halted, until a control input changes, machine_stop is called, or timeout_us passed
+/// the thread running the machine calls this instead of spinning on a halted cpu
+void machine_park(machine_t* machine, const uint64_t timeout_us);
+/// same as machine_park, whether or not the cpu is halted
+/// the thread running a throttled machine waits for real time to catch up with this, so a posted change isn't kept waiting
+void machine_sleep(machine_t* machine, const uint64_t timeout_us);
@@ -1,34 +1,48 @@
-#include "bus.h"
+#include "machine.h"
 #include "memory.h"
 #include "clock.h"
 
+#include <stdio.h>
+
 int main() {
-	bus_init();
+	machine_t machine = { 0 };
+	if (!machine_init(&machine))
+		return -1;
 
 	device_t ram = memory_init(0x10000, true);
 
-	if (!bus_add(&ram, 0x0000, 0xFFFF)) {
+	if (!bus_add(&machine.bus, &ram, 0x0000, 0xFFFF)) {
 		memory_destroy(ram);
-		bus_destroy();
+		machine_destroy(&machine);
 		return -1;
 	}
 	if (!memory_randomize(&ram)) {
 		memory_destroy(ram);
-		bus_destroy();
+		machine_destroy(&machine);
 		return -1;
 	}
 	const char* binFile = "test_6502.bin";
 	if (!memory_loadFile(&ram, binFile, 0x000a)) {
 		memory_destroy(ram);
-		bus_destroy();
+		machine_destroy(&machine);
 		return -1;
 	}
 
-	clock_reset();
-	clock_run(1000000);
+	clock_reset(&machine);
+
+	const clockConfig_t config = { .targetFrequency = 1000000, .slice_us = CLOCK_DEFAULT_SLICE_US };
+	clockStats_t stats = { 0 };
+	const clockStop_t stop = clock_runWith(&machine, &config, &stats);
+
+	printf("ran %llu cycles at %.0f Hz of %llu Hz, busy %.1f%% of the time\n",
+		(unsigned long long) stats.cycles, stats.frequency, (unsigned long long) stats.targetFrequency,
+		stats.elapsed_ns ? 100.0 * stats.busy_ns / stats.elapsed_ns : 0.0);
+
+	if (stop == CLOCK_STOP_TRAP)
+		printf("trapped at $%04X after %llu cycles\n", machine.cpu.idleAddress, (unsigned long long) machine.cpu.totalCycles);
 
 	memory_destroy(ram);
-	bus_destroy();
+	machine_destroy(&machine);
 
 	return 0;
 }
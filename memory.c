@@ -1,15 +1,158 @@
 #include "memory.h"
 
+#include "bus.h"
+
+#include <stdatomic.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if MEMORY_PAGE_BITS < BUS_PAGE_BITS
+#error "memory pages smaller than bus pages can't be handed out to the page table"
+#endif
+
+// a page of memory, shared by every clone which didn't write to it yet
+struct memoryPage {
+	atomic_uint references;
+	uint8_t data[MEMORY_PAGE_SIZE];
+};
+
 struct memory {
-	uint8_t* data;
 	size_t size;
+	size_t pageCount;
+	// the data of every page, either of the page in pages, or in mapping if that is NULL
+	uint8_t** data;
+	struct memoryPage** pages;
+	// NULL if memory isn't mapped from a file
+	// its pages are copied on their first write once the mapping is shared
+	struct memoryMapping* mapping;
+	// one bit per page written since memory_clearDirty
+	// clean pages are handed out read only, so their first write goes through memory_write
+	uint8_t* dirty;
+	// false if data is mapped read only, and can't even be changed by memory_set
+	bool writable;
 };
 
 #define GET_DATA(device) ((struct memory*) (device->device_data))
+#define PAGE_COUNT(size) (((size) + MEMORY_PAGE_MASK) >> MEMORY_PAGE_BITS)
+
+static struct memoryPage* newPage(void) {
+	struct memoryPage* page = malloc(sizeof(struct memoryPage));
+	if (page)
+		atomic_init(&page->references, 1);
+	return page;
+}
+
+static void releasePage(struct memoryPage* page) {
+	if (page && atomic_fetch_sub(&page->references, 1) == 1)
+		free(page);
+}
+
+void memory_retainMapping(struct memoryMapping* mapping) {
+	atomic_fetch_add(&mapping->references, 1);
+}
+
+void memory_releaseMapping(struct memoryMapping* mapping) {
+	if (mapping == NULL || atomic_fetch_sub(&mapping->references, 1) != 1)
+		return;
+
+#ifdef _WIN32
+	UnmapViewOfFile(mapping->data);
+#else
+	munmap(mapping->data, mapping->size);
+#endif
+	free(mapping);
+}
+
+// frees memory and everything it holds, releasing the pages it shares
+static void freeMemory(struct memory* memory) {
+	if (memory->pages)
+		for (size_t i = 0; i < memory->pageCount; i++)
+			releasePage(memory->pages[i]);
+	memory_releaseMapping(memory->mapping);
+
+	free(memory->data);
+	free(memory->pages);
+	free(memory->dirty);
+	free(memory);
+}
+
+// allocates memory spanning size bytes, without any page
+static struct memory* newMemory(const size_t size) {
+	struct memory* memory = malloc(sizeof(struct memory));
+	if (memory == NULL)
+		return NULL;
+
+	*memory = (struct memory) {
+		.size = size,
+		.pageCount = PAGE_COUNT(size),
+		.data = calloc(PAGE_COUNT(size), sizeof(uint8_t*)),
+		.pages = calloc(PAGE_COUNT(size), sizeof(struct memoryPage*)),
+		.dirty = malloc((PAGE_COUNT(size) + 7) / 8),
+		.writable = true,
+	};
+
+	if (memory->data == NULL || memory->pages == NULL || memory->dirty == NULL) {
+		freeMemory(memory);
+		return NULL;
+	}
+
+	// everything is new until the first memory_clearDirty
+	memset(memory->dirty, 0xFF, (memory->pageCount + 7) / 8);
+
+	return memory;
+}
+
+#define IS_DIRTY(memory, page) ((memory)->dirty[(page) / 8] & (1 << ((page) % 8)))
+
+static bool isShared(const struct memory* memory, const size_t page) {
+	if (memory->pages[page])
+		return atomic_load_explicit(&memory->pages[page]->references, memory_order_relaxed) > 1;
+	return atomic_load_explicit(&memory->mapping->references, memory_order_relaxed) > 1;
+}
+
+// returns the data of page owned by memory alone, copying it first if it is shared
+// pages of a read only mapping are copied even if nothing shares them
+// returns NULL if the copy couldn't be allocated
+static uint8_t* ownPage(struct memory* memory, const size_t page) {
+	if (!isShared(memory, page) && (memory->pages[page] || memory->writable))
+		return memory->data[page];
+
+	struct memoryPage* copy = newPage();
+	if (copy == NULL)
+		return NULL;
+
+	// the last page of a mapping can end before the page does
+	size_t size = MEMORY_PAGE_SIZE;
+	if (memory->pages[page] == NULL && memory->size - (page << MEMORY_PAGE_BITS) < size)
+		size = memory->size - (page << MEMORY_PAGE_BITS);
+	memcpy(copy->data, memory->data[page], size);
+
+	releasePage(memory->pages[page]);
+	memory->pages[page] = copy;
+	memory->data[page] = copy->data;
+
+	return copy->data;
+}
+
+// returns the data of page for writing, and marks it dirty
+// returns NULL if the memory can't be written, or the page couldn't be copied
+static uint8_t* writablePage(struct memory* memory, const size_t page) {
+	if (!memory->writable)
+		return NULL;
+
+	memory->dirty[page / 8] |= 1 << (page % 8);
+	return ownPage(memory, page);
+}
 
 uint8_t memory_read(deviceRef_t device, addr_t addr) {
 	if (GET_DATA(device) == NULL) {
@@ -17,12 +160,12 @@ uint8_t memory_read(deviceRef_t device, addr_t addr) {
 		return 0;
 	}
 
-	if (GET_DATA(device)->size < addr.relative) {
+	if (GET_DATA(device)->size <= addr.relative) {
 		printf("outside of ram range\n");
 		return 0;
 	}
 
-	return GET_DATA(device)->data[addr.relative];
+	return GET_DATA(device)->data[addr.relative >> MEMORY_PAGE_BITS][addr.relative & MEMORY_PAGE_MASK];
 }
 
 void memory_write(deviceRef_t device, addr_t addr, const uint8_t data) {
@@ -31,53 +174,314 @@ void memory_write(deviceRef_t device, addr_t addr, const uint8_t data) {
 		return;
 	}
 
-	if (GET_DATA(device)->size < addr.relative) {
+	if (GET_DATA(device)->size <= addr.relative) {
 		printf("outside of ram range\n");
 		return;
 	}
 
-	GET_DATA(device)->data[addr.relative] = data;
+	uint8_t* page = writablePage(GET_DATA(device), addr.relative >> MEMORY_PAGE_BITS);
+	if (page)
+		page[addr.relative & MEMORY_PAGE_MASK] = data;
+}
+
+uint8_t* memory_data(deviceRef_t device, addr_t addr, size_t* size) {
+	if (GET_DATA(device) == NULL)
+		return NULL;
+
+	if (GET_DATA(device)->size <= addr.relative)
+		return NULL;
+
+	// only the rest of the page is contiguous
+	const size_t page = addr.relative >> MEMORY_PAGE_BITS;
+	const size_t end = (page + 1) << MEMORY_PAGE_BITS;
+	*size = (end < GET_DATA(device)->size ? end : GET_DATA(device)->size) - addr.relative;
+	return GET_DATA(device)->data[page] + (addr.relative & MEMORY_PAGE_MASK);
+}
+
+// clean pages are reported as shared too, so the bus lets memory_write notice their first write
+bool memory_shared(deviceRef_t device, addr_t addr) {
+	if (GET_DATA(device) == NULL || GET_DATA(device)->size <= addr.relative)
+		return false;
+
+	const size_t page = addr.relative >> MEMORY_PAGE_BITS;
+	return !IS_DIRTY(GET_DATA(device), page) || isShared(GET_DATA(device), page);
+}
+
+size_t memory_serialize(deviceRef_t device, uint8_t* data, const size_t size) {
+	const struct memory* memory = GET_DATA(device);
+	if (memory == NULL)
+		return 0;
+
+	if (data && size >= memory->size)
+		for (size_t i = 0; i < memory->pageCount; i++) {
+			const size_t left = memory->size - (i << MEMORY_PAGE_BITS);
+			memcpy(data + (i << MEMORY_PAGE_BITS), memory->data[i], left < MEMORY_PAGE_SIZE ? left : MEMORY_PAGE_SIZE);
+		}
+
+	return memory->size;
+}
+
+bool memory_deserialize(deviceRef_t device, const uint8_t* data, const size_t size, struct memoryMapping* mapping) {
+	struct memory* memory = GET_DATA(device);
+	if (memory == NULL || size != memory->size)
+		return false;
+
+	// without a mapping, or with data not starting a page, the contents are copied
+	// roms get their state too
+	if (mapping == NULL || ((uintptr_t) data & MEMORY_PAGE_MASK)) {
+		for (size_t i = 0; i < memory->pageCount; i++) {
+			uint8_t* page = ownPage(memory, i);
+			if (page == NULL)
+				return false;
+			memory->dirty[i / 8] |= 1 << (i % 8);
+
+			const size_t left = memory->size - (i << MEMORY_PAGE_BITS);
+			memcpy(page, data + (i << MEMORY_PAGE_BITS), left < MEMORY_PAGE_SIZE ? left : MEMORY_PAGE_SIZE);
+		}
+		return true;
+	}
+
+	// the pages are taken from the mapping as they are, and copied once written
+	memory_retainMapping(mapping);
+	memory_releaseMapping(memory->mapping);
+	memory->mapping = mapping;
+
+	for (size_t i = 0; i < memory->pageCount; i++) {
+		releasePage(memory->pages[i]);
+		memory->pages[i] = NULL;
+		memory->data[i] = (uint8_t*) data + (i << MEMORY_PAGE_BITS);
+	}
+	memset(memory->dirty, 0xFF, (memory->pageCount + 7) / 8);
+
+	return true;
+}
+
+// the device of memory, with the functions of the device it is cloned from
+static device_t memoryDevice(struct memory* memory, const char* name, const bool canWrite) {
+	if (canWrite)
+		return (device_t) {
+			.device_data = memory, .name = name, .readFunc = memory_read, .writeFunc = memory_write, .memoryFunc = memory_data, .sharedFunc = memory_shared,
+			.serializeFunc = memory_serialize, .deserializeFunc = memory_deserialize,
+		};
+	// roms can still be placed
+	else if (memory->writable)
+		return (device_t) {
+			.device_data = memory, .name = name, .readFunc = memory_read, .placeFunc = memory_write, .memoryFunc = memory_data, .sharedFunc = memory_shared,
+			.serializeFunc = memory_serialize, .deserializeFunc = memory_deserialize,
+		};
+	// unless they are mapped read only, placing into them then fails
+	else
+		return (device_t) {
+			.device_data = memory, .name = name, .readFunc = memory_read, .memoryFunc = memory_data, .sharedFunc = memory_shared,
+			.serializeFunc = memory_serialize, .deserializeFunc = memory_deserialize,
+		};
 }
 
 device_t memory_init(const size_t size, const bool canWrite) {
-	struct memory* memory = malloc(sizeof(struct memory));
+	struct memory* memory = newMemory(size);
 	if (memory == NULL)
 		return (device_t) { 0 };
-	memory->data = malloc(size * sizeof(uint8_t));
-	if (memory->data == NULL) {
-		free(memory);
+
+	for (size_t i = 0; i < memory->pageCount; i++) {
+		memory->pages[i] = newPage();
+		if (memory->pages[i] == NULL) {
+			freeMemory(memory);
+			return (device_t) { 0 };
+		}
+		memory->data[i] = memory->pages[i]->data;
+	}
+
+	return memoryDevice(memory, "memory", canWrite);
+}
+
+// maps size bytes of the open file, shared with every other mapping of it until a page is written
+// a read only mapping can't be written at all, a writable one copies a page on its first write, leaving the file as is
+// returns NULL if the file can't be mapped
+#ifdef _WIN32
+static uint8_t* mapFile(HANDLE file, const size_t size, const bool writable) {
+	HANDLE mapping = CreateFileMappingA(file, NULL, writable ? PAGE_WRITECOPY : PAGE_READONLY, 0, 0, NULL);
+	if (mapping == NULL)
+		return NULL;
+
+	// the view keeps the mapping alive
+	uint8_t* data = MapViewOfFile(mapping, writable ? FILE_MAP_COPY : FILE_MAP_READ, 0, 0, size);
+	CloseHandle(mapping);
+
+	return data;
+}
+#else
+static uint8_t* mapFile(int file, const size_t size, const bool writable) {
+	uint8_t* data = mmap(NULL, size, writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_PRIVATE, file, 0);
+	return data == MAP_FAILED ? NULL : data;
+}
+#endif
+
+struct memoryMapping* memory_openMapping(const char* fileName, const bool canWrite) {
+	uint8_t* data = NULL;
+	size_t size = 0;
+
+#ifdef _WIN32
+	HANDLE file = CreateFileA(fileName, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE) {
+		printf("could not open file %s\n", fileName);
+		return NULL;
+	}
+
+	LARGE_INTEGER fileSize;
+	if (GetFileSizeEx(file, &fileSize) && fileSize.QuadPart > 0) {
+		size = (size_t) fileSize.QuadPart;
+		data = mapFile(file, size, canWrite);
+	}
+	// the mapping keeps the file open
+	CloseHandle(file);
+#else
+	const int file = open(fileName, O_RDONLY);
+	if (file < 0) {
+		printf("could not open file %s\n", fileName);
+		return NULL;
+	}
+
+	struct stat status;
+	if (fstat(file, &status) == 0 && status.st_size > 0) {
+		size = (size_t) status.st_size;
+		data = mapFile(file, size, canWrite);
+	}
+	// the mapping keeps the file open
+	close(file);
+#endif
+
+	if (data == NULL) {
+		printf("could not map file %s\n", fileName);
+		return NULL;
+	}
+
+	struct memoryMapping* mapping = malloc(sizeof(struct memoryMapping));
+	if (mapping == NULL) {
+#ifdef _WIN32
+		UnmapViewOfFile(data);
+#else
+		munmap(data, size);
+#endif
+		return NULL;
+	}
+	atomic_init(&mapping->references, 1);
+	mapping->data = data;
+	mapping->size = size;
+
+	return mapping;
+}
+
+device_t memory_mapFile(const char* fileName, const bool canWrite) {
+	struct memoryMapping* mapping = memory_openMapping(fileName, canWrite);
+	if (mapping == NULL)
+		return (device_t) { 0 };
+
+	struct memory* memory = newMemory(mapping->size);
+	if (memory == NULL) {
+		memory_releaseMapping(mapping);
 		return (device_t) { 0 };
 	}
-	memory->size = size;
 
-	if (canWrite)
-		return (device_t) { .device_data = memory, .name = "memory", .readFunc =  memory_read, .writeFunc = memory_write };
-	else
-		return (device_t) { .device_data = memory, .name = "memory", .readFunc =  memory_read };
+	memory->mapping = mapping;
+	memory->writable = canWrite;
+	for (size_t i = 0; i < memory->pageCount; i++)
+		memory->data[i] = mapping->data + (i << MEMORY_PAGE_BITS);
+
+	return memoryDevice(memory, "mapped memory", canWrite);
+}
+
+device_t memory_clone(deviceRef_t device) {
+	const struct memory* original = GET_DATA(device);
+	if (original == NULL)
+		return (device_t) { 0 };
+
+	struct memory* memory = newMemory(original->size);
+	if (memory == NULL)
+		return (device_t) { 0 };
+
+	// every page is shared, until one of the memories writes to it
+	for (size_t i = 0; i < memory->pageCount; i++) {
+		memory->data[i] = original->data[i];
+		memory->pages[i] = original->pages[i];
+		if (memory->pages[i])
+			atomic_fetch_add(&memory->pages[i]->references, 1);
+	}
+
+	memory->mapping = original->mapping;
+	if (memory->mapping)
+		memory_retainMapping(memory->mapping);
+	memory->writable = original->writable;
+
+	return memoryDevice(memory, device->name, device->writeFunc != NULL);
 }
 
 bool memory_destroy(device_t device) {
 	if (GET_DATA((&device)) == NULL)
 		return false;
 
-	free(GET_DATA((&device))->data);
-	free(GET_DATA((&device)));
+	freeMemory(GET_DATA((&device)));
 
 	return true;
 }
 
+size_t memory_pageCount(deviceRef_t device) {
+	return GET_DATA(device) ? GET_DATA(device)->pageCount : 0;
+}
+
+const uint8_t* memory_page(deviceRef_t device, const size_t page, size_t* size) {
+	if (GET_DATA(device) == NULL || page >= GET_DATA(device)->pageCount)
+		return NULL;
+
+	const size_t left = GET_DATA(device)->size - (page << MEMORY_PAGE_BITS);
+	*size = left < MEMORY_PAGE_SIZE ? left : MEMORY_PAGE_SIZE;
+	return GET_DATA(device)->data[page];
+}
+
+bool memory_setPage(deviceRef_t device, const size_t page, const uint8_t* data) {
+	if (GET_DATA(device) == NULL || page >= GET_DATA(device)->pageCount)
+		return false;
+
+	uint8_t* memory = writablePage(GET_DATA(device), page);
+	if (memory == NULL)
+		return false;
+
+	const size_t size = GET_DATA(device)->size - (page << MEMORY_PAGE_BITS);
+	memcpy(memory, data, size < MEMORY_PAGE_SIZE ? size : MEMORY_PAGE_SIZE);
+
+	return true;
+}
+
+bool memory_isDirty(deviceRef_t device, const size_t page) {
+	if (GET_DATA(device) == NULL || page >= GET_DATA(device)->pageCount)
+		return false;
+
+	return IS_DIRTY(GET_DATA(device), page);
+}
+
+void memory_clearDirty(deviceRef_t device) {
+	if (GET_DATA(device))
+		memset(GET_DATA(device)->dirty, 0, (GET_DATA(device)->pageCount + 7) / 8);
+}
+
 bool memory_randomize(deviceRef_t device) {
-	if (GET_DATA(device) == NULL)
+	if (GET_DATA(device) == NULL || !GET_DATA(device)->writable)
 		return false;
 
-	for (size_t i = 0; i < GET_DATA(device)->size; i++)
-		GET_DATA(device)->data[i] = (uint8_t) ((rand() / (float) RAND_MAX) * 0xFF);
+	for (size_t i = 0; i < GET_DATA(device)->pageCount; i++) {
+		uint8_t* page = writablePage(GET_DATA(device), i);
+		if (page == NULL)
+			return false;
+
+		const size_t size = GET_DATA(device)->size - (i << MEMORY_PAGE_BITS);
+		for (size_t j = 0; j < MEMORY_PAGE_SIZE && j < size; j++)
+			page[j] = (uint8_t) ((rand() / (float) RAND_MAX) * 0xFF);
+	}
 
 	return true;
 }
 
 bool memory_set(deviceRef_t device, const uint16_t addr, const size_t size, const uint8_t* data) {
-	if (GET_DATA(device) == NULL)
+	if (GET_DATA(device) == NULL || !GET_DATA(device)->writable)
 		return false;
 
 	if (addr > GET_DATA(device)->size)
@@ -86,13 +490,25 @@ bool memory_set(deviceRef_t device, const uint16_t addr, const size_t size, cons
 	if (GET_DATA(device)->size - addr < size)
 		return false;
 
-	memcpy(GET_DATA(device)->data + addr, data, size);
+	// copied page by page, each of them could be shared
+	for (size_t done = 0; done < size; ) {
+		const size_t address = addr + done;
+		uint8_t* page = writablePage(GET_DATA(device), address >> MEMORY_PAGE_BITS);
+		if (page == NULL)
+			return false;
+
+		size_t count = MEMORY_PAGE_SIZE - (address & MEMORY_PAGE_MASK);
+		if (count > size - done)
+			count = size - done;
+		memcpy(page + (address & MEMORY_PAGE_MASK), data + done, count);
+		done += count;
+	}
 
 	return true;
 }
 
 bool memory_loadFile(deviceRef_t device, const char* fileName, const uint16_t addr) {
-	if (GET_DATA(device) == NULL)
+	if (GET_DATA(device) == NULL || !GET_DATA(device)->writable)
 		return false;
 
 	if (addr > GET_DATA(device)->size)
@@ -113,7 +529,21 @@ bool memory_loadFile(deviceRef_t device, const char* fileName, const uint16_t ad
 		return false;
 	}
 
-	fread(GET_DATA(device)->data + addr, 1, fileSize, file);
+	for (size_t done = 0; done < fileSize; ) {
+		const size_t address = addr + done;
+		uint8_t* page = writablePage(GET_DATA(device), address >> MEMORY_PAGE_BITS);
+		if (page == NULL) {
+			fclose(file);
+			return false;
+		}
+
+		size_t count = MEMORY_PAGE_SIZE - (address & MEMORY_PAGE_MASK);
+		if (count > fileSize - done)
+			count = fileSize - done;
+		if (fread(page + (address & MEMORY_PAGE_MASK), 1, count, file) != count)
+			break;
+		done += count;
+	}
 	fclose(file);
 
 	return true;
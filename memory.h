@@ -2,12 +2,65 @@
 
 #include "device.h"
 
+#include <stdatomic.h>
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
+
+// memory is kept in pages, which clones share until they write to them
+// a page should span at least a page of the bus, smaller pages can't be handed out to its page table
+#ifndef MEMORY_PAGE_BITS
+#define MEMORY_PAGE_BITS 8
+#endif
+#define MEMORY_PAGE_SIZE (1 << MEMORY_PAGE_BITS)
+#define MEMORY_PAGE_MASK (MEMORY_PAGE_SIZE - 1)
+
+/// a file mapped into memory, which stays mapped as long as anything refers to it
+/// the file itself is never changed, with canWrite its pages are copied by the system on their first write
+struct memoryMapping {
+	atomic_uint references;
+	uint8_t* data;
+	size_t size;
+};
+
+/// maps fileName, returns NULL if it can't be mapped
+/// the mapping starts with a single reference, held by the caller
+struct memoryMapping* memory_openMapping(const char* fileName, const bool canWrite);
+void memory_retainMapping(struct memoryMapping* mapping);
+/// unmaps the file once the last reference is released
+void memory_releaseMapping(struct memoryMapping* mapping);
 
 device_t memory_init(const size_t size, const bool canWrite);
+/// creates memory holding the contents of fileName, spanning the whole file, without copying it
+/// the file is mapped into memory, so every instance mapping the same file shares its pages through the page cache
+/// without canWrite this is a rom, which can't be changed by memory_set, memory_loadFile or memory_randomize either
+/// with canWrite a page is copied on its first write, the file itself is never changed
+/// returns a device without device_data if the file can't be mapped
+device_t memory_mapFile(const char* fileName, const bool canWrite);
+/// creates memory sharing every page with device, which has to be created by memory_init or memory_mapFile
+/// costs a pointer per page, a page is only copied by the first write to it, from either memory
+/// every bus holding device has to call bus_remap afterwards, so it stops writing the shared pages directly
+/// the same goes for memory_set, memory_loadFile and memory_randomize on memory holding shared pages
+/// memory can be cloned and destroyed on any thread, a single memory should only be accessed by one thread at a time
+device_t memory_clone(deviceRef_t device);
 bool memory_destroy(device_t device);
 
+/// memory is split into memory_pageCount pages of MEMORY_PAGE_SIZE bytes, the last one can be shorter
+size_t memory_pageCount(deviceRef_t device);
+/// the contents of a page, only valid until the page is written
+/// size is set to the amount of bytes in the page
+const uint8_t* memory_page(deviceRef_t device, const size_t page, size_t* size);
+/// replaces the contents of a page, which is marked dirty, the same rules as for memory_set apply
+bool memory_setPage(deviceRef_t device, const size_t page, const uint8_t* data);
+
+/// every page written by memory_write, bus_place or any of the memory functions since memory_clearDirty is dirty
+/// all pages are dirty until the first memory_clearDirty
+bool memory_isDirty(deviceRef_t device, const size_t page);
+/// clean pages are only read directly by the bus, their first write goes through the device to mark them dirty
+/// every bus holding device has to call bus_remap afterwards, so it stops writing the cleared pages directly
+/// until then, its writes to them don't mark them dirty
+void memory_clearDirty(deviceRef_t device);
+
 bool memory_randomize(deviceRef_t device);
 bool memory_set(deviceRef_t device, const uint16_t addr, const size_t size, const uint8_t* data);
 bool memory_loadFile(deviceRef_t device, const char* fileName, const uint16_t addr);
\ No newline at end of file
@@ -0,0 +1,286 @@
+#include "profile.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define INITIAL_NODES 64
+#define NO_PARENT UINT32_MAX
+
+// the longest name of a function or address, with the offset from its label
+#define NAME_LENGTH 64
+
+// opcodes which enter and leave functions, the same on every variant
+#define OPCODE_BRK 0x00
+#define OPCODE_JSR 0x20
+#define OPCODE_RTI 0x40
+#define OPCODE_RTS 0x60
+
+bool profile_init(profile_t* profile, const cpuVariant_t variant) {
+	if (profile == NULL)
+		return false;
+
+	*profile = (profile_t) {
+		.variant = variant,
+		.executions = calloc(0x10000, sizeof(uint64_t)),
+		.cycles = calloc(0x10000, sizeof(uint64_t)),
+		.nodes = malloc(INITIAL_NODES * sizeof(struct profileNode)),
+		.nodeCapacity = INITIAL_NODES,
+		.children = calloc(INITIAL_NODES * 2, sizeof(uint32_t)),
+		.childrenMask = INITIAL_NODES * 2 - 1,
+	};
+
+	if (profile->executions == NULL || profile->cycles == NULL || profile->nodes == NULL || profile->children == NULL) {
+		profile_destroy(profile);
+		return false;
+	}
+
+	return true;
+}
+
+bool profile_destroy(profile_t* profile) {
+	if (profile == NULL)
+		return false;
+
+	free(profile->executions);
+	free(profile->cycles);
+	free(profile->nodes);
+	free(profile->children);
+
+	*profile = (profile_t) { 0 };
+
+	return true;
+}
+
+void profile_clear(profile_t* profile) {
+	memset(profile->opcodeExecutions, 0, sizeof(profile->opcodeExecutions));
+	memset(profile->opcodeCycles, 0, sizeof(profile->opcodeCycles));
+	memset(profile->opcodeExtraCycles, 0, sizeof(profile->opcodeExtraCycles));
+	memset(profile->executions, 0, 0x10000 * sizeof(uint64_t));
+	memset(profile->cycles, 0, 0x10000 * sizeof(uint64_t));
+	memset(profile->children, 0, (profile->childrenMask + 1) * sizeof(uint32_t));
+
+	profile->nodeCount = 0;
+	profile->depth = 0;
+}
+
+static uint32_t hashChild(const uint32_t parent, const uint16_t address) {
+	uint32_t hash = parent * 0x9E3779B1u ^ address;
+	hash ^= hash >> 15;
+	return hash * 0x85EBCA77u;
+}
+
+// doubles the hash table of children, returns false if it couldn't be allocated
+static bool growChildren(profile_t* profile) {
+	const uint32_t mask = profile->childrenMask * 2 + 1;
+	uint32_t* children = calloc((size_t) mask + 1, sizeof(uint32_t));
+	if (children == NULL)
+		return false;
+
+	for (uint32_t i = 1; i < profile->nodeCount; i++) {
+		uint32_t slot = hashChild(profile->nodes[i].parent, profile->nodes[i].address) & mask;
+		while (children[slot])
+			slot = (slot + 1) & mask;
+		children[slot] = i;
+	}
+
+	free(profile->children);
+	profile->children = children;
+	profile->childrenMask = mask;
+
+	return true;
+}
+
+// returns the node of address called from parent, creating it on the first call
+// returns NO_PARENT if it couldn't be created
+static uint32_t findChild(profile_t* profile, const uint32_t parent, const uint16_t address) {
+	uint32_t slot = hashChild(parent, address) & profile->childrenMask;
+	for (uint32_t node; (node = profile->children[slot]); slot = (slot + 1) & profile->childrenMask)
+		if (profile->nodes[node].parent == parent && profile->nodes[node].address == address)
+			return node;
+
+	if (profile->nodeCount == profile->nodeCapacity) {
+		struct profileNode* nodes = realloc(profile->nodes, profile->nodeCapacity * 2 * sizeof(struct profileNode));
+		if (nodes == NULL)
+			return NO_PARENT;
+		profile->nodes = nodes;
+		profile->nodeCapacity *= 2;
+	}
+
+	// the table is kept at most half full, so lookups stay short
+	if ((profile->nodeCount + 1) * 2 > profile->childrenMask + 1) {
+		if (!growChildren(profile))
+			return NO_PARENT;
+		slot = hashChild(parent, address) & profile->childrenMask;
+		while (profile->children[slot])
+			slot = (slot + 1) & profile->childrenMask;
+	}
+
+	const uint32_t node = profile->nodeCount++;
+	profile->nodes[node] = (struct profileNode) { .address = address, .parent = parent };
+	profile->children[slot] = node;
+
+	return node;
+}
+
+// enters the function at address, which returns once the stack pointer is back at returnSP
+static void call(profile_t* profile, const uint16_t address, const uint8_t returnSP) {
+	// too deep, or out of memory, the call is counted in the current function
+	if (profile->depth == PROFILE_MAX_DEPTH)
+		return;
+
+	const uint32_t node = findChild(profile, profile->stack[profile->depth - 1].node, address);
+	if (node == NO_PARENT)
+		return;
+
+	profile->nodes[node].calls++;
+	profile->stack[profile->depth++] = (struct profileFrame) { node, returnSP };
+}
+
+void profile_jump(profile_t* profile, const uint16_t pc, const uint8_t sp) {
+	if (profile->depth == 0) {
+		// the first instruction starts the root of the call tree
+		if (profile->nodeCount == 0)
+			profile->nodes[profile->nodeCount++] = (struct profileNode) { .address = pc, .parent = NO_PARENT };
+		profile->nodes[0].calls++;
+		profile->stack[profile->depth++] = (struct profileFrame) { 0, sp };
+	} else if (sp == (uint8_t) (profile->nextSP - 3)) {
+		// an interrupt pushed PC and the flags
+		call(profile, pc, profile->nextSP);
+	}
+
+	profile->nextPC = pc;
+	profile->nextSP = sp;
+}
+
+void profile_flow(profile_t* profile, const uint8_t opcode, const uint16_t pc, const uint8_t spBefore, const uint8_t spAfter) {
+	switch (opcode) {
+	case OPCODE_JSR:
+	case OPCODE_BRK:
+		call(profile, pc, spBefore);
+		break;
+	case OPCODE_RTS:
+	case OPCODE_RTI:
+		// every function whose return address got pulled is left, a return into the middle of a function (used as a jump) leaves nothing
+		while (profile->depth > 1 && profile->stack[profile->depth - 1].returnSP <= spAfter)
+			profile->depth--;
+		break;
+	}
+}
+
+struct ranked {
+	uint32_t index;
+	uint64_t cycles;
+};
+
+struct modeCounts {
+	const char* name;
+	uint64_t executions;
+	uint64_t cycles;
+	uint64_t extraCycles;
+};
+
+static int compareRanked(const void* a, const void* b) {
+	const uint64_t cyclesA = ((const struct ranked*) a)->cycles;
+	const uint64_t cyclesB = ((const struct ranked*) b)->cycles;
+	return cyclesA < cyclesB ? 1 : cyclesA > cyclesB ? -1 : 0;
+}
+
+static double percentage(const uint64_t part, const uint64_t total) {
+	return total ? 100.0 * part / total : 0.0;
+}
+
+void profile_report(const profile_t* profile, const symbols_t* symbols, FILE* file, const size_t count) {
+	uint64_t executions = 0;
+	uint64_t cycles = 0;
+	for (int i = 0; i < 256; i++) {
+		executions += profile->opcodeExecutions[i];
+		cycles += profile->opcodeCycles[i];
+	}
+
+	fprintf(file, "%llu instructions, %llu cycles\n", (unsigned long long) executions, (unsigned long long) cycles);
+
+	struct ranked ranked[256];
+	size_t rankedCount = 0;
+	for (uint32_t i = 0; i < 256; i++)
+		if (profile->opcodeExecutions[i])
+			ranked[rankedCount++] = (struct ranked) { i, profile->opcodeCycles[i] };
+	qsort(ranked, rankedCount, sizeof(struct ranked), compareRanked);
+
+	fprintf(file, "\nopcode              executions          cycles    extra cycles\n");
+	for (size_t i = 0; i < rankedCount; i++) {
+		const uint8_t opcode = (uint8_t) ranked[i].index;
+		const cpuOpcodeInfo_t info = cpu_opcodeInfo(profile->variant, opcode);
+		fprintf(file, "%02X %-4s %-4s %16llu %15llu %15llu %5.1f%%\n", opcode, info.instruction, info.addressMode,
+			(unsigned long long) profile->opcodeExecutions[opcode], (unsigned long long) profile->opcodeCycles[opcode],
+			(unsigned long long) profile->opcodeExtraCycles[opcode], percentage(profile->opcodeCycles[opcode], cycles));
+	}
+
+	// addressing modes are named the same on every variant, so they are summed up by name
+	struct modeCounts modes[32];
+	size_t modeCount = 0;
+	for (size_t i = 0; i < rankedCount; i++) {
+		const uint8_t opcode = (uint8_t) ranked[i].index;
+		const char* name = cpu_opcodeInfo(profile->variant, opcode).addressMode;
+		size_t mode = 0;
+		while (mode < modeCount && strcmp(modes[mode].name, name) != 0)
+			mode++;
+		if (mode == modeCount)
+			modes[modeCount++] = (struct modeCounts) { .name = name };
+		modes[mode].executions += profile->opcodeExecutions[opcode];
+		modes[mode].cycles += profile->opcodeCycles[opcode];
+		modes[mode].extraCycles += profile->opcodeExtraCycles[opcode];
+	}
+
+	fprintf(file, "\nmode                executions          cycles    extra cycles\n");
+	for (size_t i = 0; i < modeCount; i++)
+		fprintf(file, "%-9s %16llu %15llu %15llu %5.1f%%\n", modes[i].name, (unsigned long long) modes[i].executions,
+			(unsigned long long) modes[i].cycles, (unsigned long long) modes[i].extraCycles, percentage(modes[i].cycles, cycles));
+
+	struct ranked* addresses = malloc(0x10000 * sizeof(struct ranked));
+	if (addresses == NULL)
+		return;
+
+	size_t addressCount = 0;
+	for (uint32_t i = 0; i < 0x10000; i++)
+		if (profile->executions[i])
+			addresses[addressCount++] = (struct ranked) { i, profile->cycles[i] };
+	qsort(addresses, addressCount, sizeof(struct ranked), compareRanked);
+
+	fprintf(file, "\naddress                             executions          cycles\n");
+	for (size_t i = 0; i < addressCount && i < count; i++) {
+		const uint16_t address = (uint16_t) addresses[i].index;
+		char name[NAME_LENGTH];
+		fprintf(file, "$%04X %-24s %16llu %15llu %5.1f%%", address, symbols_name(symbols, address, name, sizeof(name)),
+			(unsigned long long) profile->executions[address], (unsigned long long) profile->cycles[address],
+			percentage(profile->cycles[address], cycles));
+
+		const struct sourceLine* line = symbols_line(symbols, address);
+		if (line)
+			fprintf(file, "  %s:%u %s", line->file, line->line, line->text);
+		fprintf(file, "\n");
+	}
+
+	free(addresses);
+}
+
+bool profile_writeCollapsed(const profile_t* profile, const symbols_t* symbols, FILE* file) {
+	uint32_t path[PROFILE_MAX_DEPTH];
+
+	for (uint32_t i = 0; i < profile->nodeCount; i++) {
+		if (profile->nodes[i].cycles == 0)
+			continue;
+
+		// the path is collected from the node up, and written from the root down
+		uint32_t depth = 0;
+		for (uint32_t node = i; node != NO_PARENT && depth < PROFILE_MAX_DEPTH; node = profile->nodes[node].parent)
+			path[depth++] = node;
+
+		while (depth-- > 0) {
+			char name[NAME_LENGTH];
+			fprintf(file, "%s%c", symbols_name(symbols, profile->nodes[path[depth]].address, name, sizeof(name)), depth ? ';' : ' ');
+		}
+		fprintf(file, "%llu\n", (unsigned long long) profile->nodes[i].cycles);
+	}
+
+	return !ferror(file);
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "cpu.h"
+#include "symbols.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/// deepest call stack that is followed, deeper calls are counted in the deepest function
+#define PROFILE_MAX_DEPTH 256
+
+/// a function in the call tree, entered at address from its parent
+/// cycles and executions are of the instructions run in the function itself, not in the functions it called
+struct profileNode {
+	uint16_t address;
+	uint32_t parent;
+	uint64_t calls;
+	uint64_t cycles;
+	uint64_t executions;
+};
+
+/// a function on the call stack, and the stack pointer it returns to
+struct profileFrame {
+	uint32_t node;
+	uint8_t returnSP;
+};
+
+/// counts of the instructions run by a cpu, per opcode, per address and per call stack
+/// extra cycles are the cycles taken above those in the opcode table, by page crossings, taken branches and decimal mode
+/// calls are followed through JSR, BRK and interrupts, and end when the stack pointer returns above them by RTS or RTI
+typedef struct profile {
+	cpuVariant_t variant;
+
+	uint64_t opcodeExecutions[256];
+	uint64_t opcodeCycles[256];
+	uint64_t opcodeExtraCycles[256];
+
+	// indexed by the address of the opcode
+	uint64_t* executions;
+	uint64_t* cycles;
+
+	// node 0 is the function the profile started in, every other node is called from its parent
+	struct profileNode* nodes;
+	uint32_t nodeCount;
+	uint32_t nodeCapacity;
+	// node indices, hashed on parent and address, 0 is an empty slot
+	uint32_t* children;
+	uint32_t childrenMask;
+
+	struct profileFrame stack[PROFILE_MAX_DEPTH];
+	uint32_t depth;
+
+	// where the next instruction is expected, anything else means the cpu was interrupted or moved
+	uint16_t nextPC;
+	uint8_t nextSP;
+} profile_t;
+
+/// prepares an empty profile for a cpu of the given variant
+bool profile_init(profile_t* profile, const cpuVariant_t variant);
+bool profile_destroy(profile_t* profile);
+/// forgets all counts, the call stack starts over at the next instruction
+void profile_clear(profile_t* profile);
+
+/// used by the cpu, around every instruction it runs
+/// jump is called when the instruction about to run isn't where the previous one left the cpu
+/// flow is called after every JSR, BRK, RTS and RTI with the stack pointer from before and after it
+void profile_jump(profile_t* profile, const uint16_t pc, const uint8_t sp);
+void profile_flow(profile_t* profile, const uint8_t opcode, const uint16_t pc, const uint8_t spBefore, const uint8_t spAfter);
+
+static inline void profile_count(profile_t* profile, const uint16_t pc, const uint8_t opcode, const uint8_t cycles, const uint8_t extraCycles) {
+	profile->opcodeExecutions[opcode]++;
+	profile->opcodeCycles[opcode] += cycles;
+	profile->opcodeExtraCycles[opcode] += extraCycles;
+	profile->executions[pc]++;
+	profile->cycles[pc] += cycles;
+
+	struct profileNode* node = &profile->nodes[profile->stack[profile->depth - 1].node];
+	node->executions++;
+	node->cycles += cycles;
+}
+
+/// prints the opcodes, addressing modes and the count hottest addresses, ordered by cycles
+/// addresses are named by symbols if it isn't NULL
+void profile_report(const profile_t* profile, const symbols_t* symbols, FILE* file, const size_t count);
+/// writes every call stack with the cycles spent in it, one per line as "outer;inner cycles"
+/// this is the collapsed stack format read by flamegraph.pl and most flame graph viewers
+/// functions are named by symbols if it isn't NULL
+bool profile_writeCollapsed(const profile_t* profile, const symbols_t* symbols, FILE* file);
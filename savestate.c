@@ -0,0 +1,369 @@
+#include "savestate.h"
+
+#include "memory.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ALIGN(offset) (((offset) + SAVESTATE_ALIGNMENT - 1) & ~(uint64_t) (SAVESTATE_ALIGNMENT - 1))
+
+static void put16(uint8_t* data, const uint16_t value) {
+	data[0] = (uint8_t) value;
+	data[1] = (uint8_t) (value >> 8);
+}
+
+static void put32(uint8_t* data, const uint32_t value) {
+	put16(data, (uint16_t) value);
+	put16(data + 2, (uint16_t) (value >> 16));
+}
+
+static void put64(uint8_t* data, const uint64_t value) {
+	put32(data, (uint32_t) value);
+	put32(data + 4, (uint32_t) (value >> 32));
+}
+
+static uint16_t get16(const uint8_t* data) {
+	return (uint16_t) (data[0] | (data[1] << 8));
+}
+
+static uint32_t get32(const uint8_t* data) {
+	return get16(data) | ((uint32_t) get16(data + 2) << 16);
+}
+
+static uint64_t get64(const uint8_t* data) {
+	return get32(data) | ((uint64_t) get32(data + 4) << 32);
+}
+
+static void putCpu(uint8_t* header, const cpuState_t* state) {
+	put16(header + 40, state->registers.PC);
+	header[42] = state->registers.A;
+	header[43] = state->registers.X;
+	header[44] = state->registers.Y;
+	header[45] = state->registers.flags.byte;
+	header[46] = state->registers.SP;
+	header[47] = (uint8_t) (state->signals.irq | (state->signals.reset << 1) | (state->signals.nmi << 2) | (state->signals.WAI << 3) | (state->signals.STP << 4));
+	put32(header + 48, state->irqSources);
+	header[52] = state->pendingControl;
+	header[53] = (uint8_t) state->cycles;
+	header[54] = (uint8_t) state->breakReason;
+	header[55] = state->skipBreakpoint;
+	put16(header + 56, state->breakAddress);
+	put64(header + 64, state->totalCycles);
+	put64(header + 72, state->instructionCount);
+}
+
+static void getCpu(const uint8_t* header, cpuState_t* state) {
+	*state = (cpuState_t) { 0 };
+	state->registers.PC = get16(header + 40);
+	state->registers.A = header[42];
+	state->registers.X = header[43];
+	state->registers.Y = header[44];
+	state->registers.flags.byte = header[45];
+	state->registers.SP = header[46];
+	state->signals.irq = header[47] & 0x01;
+	state->signals.reset = header[47] & 0x02;
+	state->signals.nmi = header[47] & 0x04;
+	state->signals.WAI = header[47] & 0x08;
+	state->signals.STP = header[47] & 0x10;
+	state->irqSources = get32(header + 48);
+	state->pendingControl = header[52];
+	state->cycles = (int8_t) header[53];
+	state->breakReason = (cpuBreak_t) header[54];
+	state->skipBreakpoint = header[55];
+	state->breakAddress = get16(header + 56);
+	state->totalCycles = get64(header + 64);
+	state->instructionCount = get64(header + 72);
+}
+
+// the devices on the bus, each once, in the order they first appear
+// returns the amount of devices, or SIZE_MAX if the list couldn't be allocated
+static size_t listDevices(const bus_t* bus, deviceRef_t** devices) {
+	*devices = malloc(bus->size * sizeof(deviceRef_t));
+	if (*devices == NULL)
+		return SIZE_MAX;
+
+	size_t count = 0;
+	for (size_t i = 0; i < bus->size; i++) {
+		deviceRef_t device = bus->regions[i].device;
+		if (device == bus_nullDevice())
+			continue;
+
+		size_t j = 0;
+		while (j < count && (*devices)[j] != device)
+			j++;
+		if (j == count)
+			(*devices)[count++] = device;
+	}
+
+	return count;
+}
+
+static size_t indexOf(deviceRef_t* devices, const size_t count, deviceRef_t device) {
+	for (size_t i = 0; i < count; i++)
+		if (devices[i] == device)
+			return i;
+	return SAVESTATE_NULL_DEVICE;
+}
+
+static bool writePadding(FILE* file, uint64_t offset, const uint64_t end) {
+	static const uint8_t zeros[256] = { 0 };
+	while (offset < end) {
+		const size_t count = end - offset < sizeof(zeros) ? (size_t) (end - offset) : sizeof(zeros);
+		if (fwrite(zeros, 1, count, file) != count)
+			return false;
+		offset += count;
+	}
+	return true;
+}
+
+bool savestate_save(const machine_t* machine, const char* fileName) {
+	deviceRef_t* devices;
+	const size_t deviceCount = listDevices(&machine->bus, &devices);
+	if (deviceCount == SIZE_MAX)
+		return false;
+	if (deviceCount >= SAVESTATE_NULL_DEVICE) {
+		free(devices);
+		return false;
+	}
+
+	// the tables and names, followed by the states
+	const uint64_t deviceTable = SAVESTATE_HEADER_SIZE;
+	const uint64_t regionTable = deviceTable + deviceCount * SAVESTATE_DEVICE_SIZE;
+	const uint64_t names = regionTable + machine->bus.size * SAVESTATE_REGION_SIZE;
+
+	uint64_t namesSize = 0;
+	for (size_t i = 0; i < deviceCount; i++)
+		namesSize += devices[i]->name ? strlen(devices[i]->name) : 0;
+
+	const size_t tableSize = (size_t) (names + namesSize);
+	uint8_t* table = calloc(tableSize, 1);
+	if (table == NULL) {
+		free(devices);
+		return false;
+	}
+
+	memcpy(table, SAVESTATE_MAGIC, 8);
+	put32(table + 8, SAVESTATE_VERSION);
+	put32(table + 12, (uint32_t) machine->cpu.variant);
+	put32(table + 16, (uint32_t) deviceCount);
+	put32(table + 20, (uint32_t) machine->bus.size);
+	put64(table + 24, deviceTable);
+	put64(table + 32, regionTable);
+
+	cpuState_t cpu;
+	cpu_saveState(&machine->cpu, &cpu);
+	putCpu(table, &cpu);
+
+	uint64_t name = names;
+	uint64_t state = ALIGN(tableSize);
+	for (size_t i = 0; i < deviceCount; i++) {
+		uint8_t* entry = table + deviceTable + i * SAVESTATE_DEVICE_SIZE;
+		const size_t nameLength = devices[i]->name ? strlen(devices[i]->name) : 0;
+		const size_t stateSize = devices[i]->serializeFunc ? devices[i]->serializeFunc(devices[i], NULL, 0) : 0;
+
+		memcpy(table + name, devices[i]->name, nameLength);
+		put64(entry, name);
+		put64(entry + 8, nameLength);
+		put64(entry + 16, state);
+		put64(entry + 24, stateSize);
+
+		name += nameLength;
+		state = ALIGN(state + stateSize);
+	}
+
+	for (size_t i = 0; i < machine->bus.size; i++) {
+		const region_t* region = machine->bus.regions + i;
+		uint8_t* entry = table + regionTable + i * SAVESTATE_REGION_SIZE;
+		put16(entry, region->begin);
+		put16(entry + 2, region->end);
+		put16(entry + 4, region->base);
+		put16(entry + 6, (uint16_t) indexOf(devices, deviceCount, region->device));
+	}
+
+	FILE* file = fopen(fileName, "wb");
+	if (!file) {
+		printf("could not open file %s\n", fileName);
+		free(table);
+		free(devices);
+		return false;
+	}
+
+	bool success = fwrite(table, 1, tableSize, file) == tableSize;
+	uint64_t offset = tableSize;
+
+	for (size_t i = 0; i < deviceCount && success; i++) {
+		const uint8_t* entry = table + deviceTable + i * SAVESTATE_DEVICE_SIZE;
+		const size_t stateSize = (size_t) get64(entry + 24);
+		if (stateSize == 0)
+			continue;
+
+		uint8_t* data = malloc(stateSize);
+		success = data && writePadding(file, offset, get64(entry + 16));
+		success = success && devices[i]->serializeFunc(devices[i], data, stateSize) == stateSize;
+		success = success && fwrite(data, 1, stateSize, file) == stateSize;
+		offset = get64(entry + 16) + stateSize;
+		free(data);
+	}
+
+	// the last state is padded too, so all of it can be mapped
+	success = success && writePadding(file, offset, ALIGN(offset));
+	success = fclose(file) == 0 && success;
+	free(table);
+	free(devices);
+
+	if (!success)
+		printf("could not write file %s\n", fileName);
+
+	return success;
+}
+
+// true if [offset, offset + size) lies within the mapping
+static bool inFile(const struct memoryMapping* mapping, const uint64_t offset, const uint64_t size) {
+	return offset <= mapping->size && size <= mapping->size - offset;
+}
+
+// true if device has the name of length bytes, a device without a name has the empty one
+static bool hasName(deviceRef_t device, const char* name, const size_t length) {
+	const char* deviceName = device->name ? device->name : "";
+	return strlen(deviceName) == length && memcmp(deviceName, name, length) == 0;
+}
+
+// finds the devices of the file in devices, matched by name in order
+// returns false if any of them is missing
+static bool matchDevices(const struct memoryMapping* mapping, const uint64_t deviceTable, const size_t count, const deviceRef_t* devices, const size_t deviceCount, deviceRef_t* matched) {
+	for (size_t i = 0; i < count; i++) {
+		const uint8_t* entry = mapping->data + deviceTable + i * SAVESTATE_DEVICE_SIZE;
+		const uint64_t nameOffset = get64(entry);
+		const uint64_t nameLength = get64(entry + 8);
+		if (!inFile(mapping, nameOffset, nameLength) || !inFile(mapping, get64(entry + 16), get64(entry + 24))) {
+			printf("save state is damaged\n");
+			return false;
+		}
+		const char* name = (const char*) mapping->data + nameOffset;
+
+		// the devices of the same name before this one are matched already
+		size_t skip = 0;
+		for (size_t j = 0; j < i; j++)
+			skip += hasName(matched[j], name, nameLength);
+
+		matched[i] = NULL;
+		for (size_t j = 0; j < deviceCount && matched[i] == NULL; j++)
+			if (hasName(devices[j], name, nameLength) && skip-- == 0)
+				matched[i] = devices[j];
+
+		if (matched[i] == NULL) {
+			printf("no device named %.*s\n", (int) nameLength, name);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+// checks the header and tables of the file, and matches its devices
+// returns false if the file doesn't fit
+static bool checkFile(const machine_t* machine, const struct memoryMapping* mapping, const deviceRef_t* devices, const size_t deviceCount, deviceRef_t** matched) {
+	const uint8_t* header = mapping->data;
+	if (mapping->size < SAVESTATE_HEADER_SIZE || memcmp(header, SAVESTATE_MAGIC, 8) != 0) {
+		printf("not a save state\n");
+		return false;
+	}
+
+	if (get32(header + 8) != SAVESTATE_VERSION) {
+		printf("save state version %u is not supported\n", get32(header + 8));
+		return false;
+	}
+
+	if (get32(header + 12) != (uint32_t) machine->cpu.variant) {
+		printf("save state is of another cpu variant\n");
+		return false;
+	}
+
+	const uint32_t count = get32(header + 16);
+	const uint32_t regionCount = get32(header + 20);
+	if (!inFile(mapping, get64(header + 24), (uint64_t) count * SAVESTATE_DEVICE_SIZE) || !inFile(mapping, get64(header + 32), (uint64_t) regionCount * SAVESTATE_REGION_SIZE)) {
+		printf("save state is damaged\n");
+		return false;
+	}
+
+	for (uint32_t i = 0; i < regionCount; i++) {
+		const uint16_t device = get16(mapping->data + get64(header + 32) + i * SAVESTATE_REGION_SIZE + 6);
+		if (device != SAVESTATE_NULL_DEVICE && device >= count) {
+			printf("save state is damaged\n");
+			return false;
+		}
+	}
+
+	*matched = malloc((count ? count : 1) * sizeof(deviceRef_t));
+	if (*matched == NULL)
+		return false;
+
+	if (!matchDevices(mapping, get64(header + 24), count, devices, deviceCount, *matched)) {
+		free(*matched);
+		return false;
+	}
+
+	return true;
+}
+
+bool savestate_load(machine_t* machine, const char* fileName, const deviceRef_t* devices, const size_t deviceCount) {
+	// mapped copy on write, so memory can keep using its pages
+	struct memoryMapping* mapping = memory_openMapping(fileName, true);
+	if (mapping == NULL)
+		return false;
+
+	deviceRef_t* matched;
+	if (!checkFile(machine, mapping, devices, deviceCount, &matched)) {
+		memory_releaseMapping(mapping);
+		return false;
+	}
+
+	const uint8_t* header = mapping->data;
+	const uint32_t count = get32(header + 16);
+	const uint32_t regionCount = get32(header + 20);
+
+	bool success = true;
+	for (uint32_t i = 0; i < count && success; i++) {
+		const uint8_t* entry = mapping->data + get64(header + 24) + i * SAVESTATE_DEVICE_SIZE;
+		const uint64_t size = get64(entry + 24);
+		if (size == 0)
+			continue;
+
+		success = matched[i]->deserializeFunc && matched[i]->deserializeFunc(matched[i], mapping->data + get64(entry + 16), (size_t) size, mapping);
+		if (!success)
+			printf("could not restore device %s\n", matched[i]->name);
+	}
+
+	region_t* regions = success ? malloc(regionCount * sizeof(region_t)) : NULL;
+	if (regions) {
+		for (uint32_t i = 0; i < regionCount; i++) {
+			const uint8_t* entry = mapping->data + get64(header + 32) + i * SAVESTATE_REGION_SIZE;
+			const uint16_t device = get16(entry + 6);
+			regions[i] = (region_t) {
+				.begin = get16(entry),
+				.end = get16(entry + 2),
+				.base = get16(entry + 4),
+				.device = device == SAVESTATE_NULL_DEVICE ? NULL : matched[device],
+			};
+		}
+
+		success = bus_setRegions(&machine->bus, regions, regionCount);
+		free(regions);
+	} else
+		success = false;
+
+	if (success) {
+		cpuState_t cpu;
+		getCpu(header, &cpu);
+		cpu_loadState(&machine->cpu, &cpu);
+		// the memory changed without going through the bus
+		cpu_flushBlockCache(&machine->cpu);
+	}
+
+	free(matched);
+	// the devices hold on to the mapping themselves
+	memory_releaseMapping(mapping);
+
+	return success;
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "device.h"
+#include "machine.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/// a save state holds a machine ready to continue: its cpu, the layout of its bus, and the state of every device on the bus
+/// the states of the devices are aligned, so memory is mapped back in on load instead of being read
+/// the events of the scheduler, and control input changes posted from other threads, are not saved
+///
+/// every number is little endian, offsets are counted from the start of the file
+///
+/// header, SAVESTATE_HEADER_SIZE bytes
+///    0   8  SAVESTATE_MAGIC
+///    8   4  SAVESTATE_VERSION
+///   12   4  variant of the cpu, a cpuVariant_t
+///   16   4  number of devices
+///   20   4  number of regions
+///   24   8  offset of the device table
+///   32   8  offset of the region table
+///   40   2  PC
+///   42   1  A
+///   43   1  X
+///   44   1  Y
+///   45   1  flags
+///   46   1  SP
+///   47   1  control inputs, irq, reset, nmi, WAI and STP in bits 0 to 4
+///   48   4  irq sources
+///   52   1  pending control
+///   53   1  cycles left of the last instruction, signed
+///   54   1  break reason, a cpuBreak_t
+///   55   1  1 if the instruction at the breakpoint runs next
+///   56   2  break address
+///   58   6  0
+///   64   8  total cycles
+///   72   8  instruction count
+///
+/// device table, SAVESTATE_DEVICE_SIZE bytes per device, in the order they first appear on the bus
+///    0   8  offset of its name, which isn't terminated
+///    8   8  length of its name
+///   16   8  offset of its state, a multiple of SAVESTATE_ALIGNMENT
+///   24   8  size of its state, 0 for a device without one
+///
+/// region table, SAVESTATE_REGION_SIZE bytes per region, sorted on address
+///    0   2  first address
+///    2   2  last address
+///    4   2  address of the first address relative to the device
+///    6   2  index in the device table, SAVESTATE_NULL_DEVICE where no device was added
+///
+/// the names and states follow, the states are written by the serializeFunc of the devices
+#define SAVESTATE_MAGIC "6502STAT"
+#define SAVESTATE_VERSION 1
+#define SAVESTATE_HEADER_SIZE 80
+#define SAVESTATE_DEVICE_SIZE 32
+#define SAVESTATE_REGION_SIZE 8
+#define SAVESTATE_NULL_DEVICE 0xFFFF
+// the page size of most systems, enough for memory pages to be used straight from the mapped file
+#define SAVESTATE_ALIGNMENT 4096
+
+/// writes machine to fileName, which should not be running
+/// returns false if the file can't be written, or the bus holds more than SAVESTATE_NULL_DEVICE devices
+bool savestate_save(const machine_t* machine, const char* fileName);
+
+/// restores machine from fileName, which has to be of the same variant
+/// the devices of the file are matched to devices by name, in order
+/// the first device named "memory" in the file gets restored into the first device named "memory" in devices, and so on
+/// devices keeps the devices, which have to outlive their time on the bus, as the bus only points to them
+/// the bus gets the regions of the file, the devices on it before are forgotten
+/// memory takes its pages from the mapped file, copying a page on its first write, the file itself is never changed
+/// returns false if the file is not a save state of this version, or doesn't fit machine or devices
+/// once the devices are being restored, a failing device leaves the machine partially restored
+bool savestate_load(machine_t* machine, const char* fileName, const deviceRef_t* devices, const size_t deviceCount);
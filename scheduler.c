@@ -0,0 +1,159 @@
+#include "scheduler.h"
+
+#include <stdlib.h>
+
+#define NO_SLOT SIZE_MAX
+
+// true if the event in slot a has to run before the event in slot b
+static bool before(const scheduler_t* scheduler, const size_t a, const size_t b) {
+	const struct event* first = scheduler->slots + a;
+	const struct event* second = scheduler->slots + b;
+
+	if (first->cycle != second->cycle)
+		return first->cycle < second->cycle;
+	return first->order < second->order;
+}
+
+static void place(scheduler_t* scheduler, const size_t index, const size_t slot) {
+	scheduler->heap[index] = slot;
+	scheduler->slots[slot].heapIndex = index;
+}
+
+static void siftUp(scheduler_t* scheduler, size_t index) {
+	const size_t slot = scheduler->heap[index];
+	while (index > 0) {
+		const size_t parent = (index - 1) / 2;
+		if (!before(scheduler, slot, scheduler->heap[parent]))
+			break;
+		place(scheduler, index, scheduler->heap[parent]);
+		index = parent;
+	}
+	place(scheduler, index, slot);
+}
+
+static void siftDown(scheduler_t* scheduler, size_t index) {
+	const size_t slot = scheduler->heap[index];
+	while (true) {
+		size_t child = index * 2 + 1;
+		if (child >= scheduler->count)
+			break;
+		if (child + 1 < scheduler->count && before(scheduler, scheduler->heap[child + 1], scheduler->heap[child]))
+			child++;
+		if (!before(scheduler, scheduler->heap[child], slot))
+			break;
+		place(scheduler, index, scheduler->heap[child]);
+		index = child;
+	}
+	place(scheduler, index, slot);
+}
+
+// takes the event at index out of the heap, and frees its slot
+static void removeAt(scheduler_t* scheduler, const size_t index) {
+	const size_t slot = scheduler->heap[index];
+
+	scheduler->count--;
+	if (index != scheduler->count) {
+		// the last event takes its place, and moves whichever way keeps the heap ordered
+		const size_t moved = scheduler->heap[scheduler->count];
+		place(scheduler, index, moved);
+		if (index > 0 && before(scheduler, moved, scheduler->heap[(index - 1) / 2]))
+			siftUp(scheduler, index);
+		else
+			siftDown(scheduler, index);
+	}
+
+	struct event* event = scheduler->slots + slot;
+	event->generation++;
+	event->func = NULL;
+	event->heapIndex = scheduler->freeSlot;
+	scheduler->freeSlot = slot;
+}
+
+static bool grow(scheduler_t* scheduler) {
+	const size_t capacity = scheduler->capacity ? scheduler->capacity * 2 : 16;
+
+	struct event* slots = realloc(scheduler->slots, sizeof(struct event) * capacity);
+	if (slots == NULL)
+		return false;
+	scheduler->slots = slots;
+
+	size_t* heap = realloc(scheduler->heap, sizeof(size_t) * capacity);
+	if (heap == NULL)
+		return false;
+	scheduler->heap = heap;
+
+	// the new slots are chained in front of the free list
+	for (size_t slot = capacity; slot-- > scheduler->capacity;) {
+		scheduler->slots[slot] = (struct event) { .heapIndex = scheduler->freeSlot };
+		scheduler->freeSlot = slot;
+	}
+	scheduler->capacity = capacity;
+
+	return true;
+}
+
+bool scheduler_init(scheduler_t* scheduler) {
+	if (scheduler->slots)
+		return false;
+
+	*scheduler = (scheduler_t) { .freeSlot = NO_SLOT };
+	return grow(scheduler);
+}
+
+bool scheduler_destroy(scheduler_t* scheduler) {
+	if (!scheduler->slots)
+		return false;
+
+	free(scheduler->slots);
+	free(scheduler->heap);
+	*scheduler = (scheduler_t) { .freeSlot = NO_SLOT };
+
+	return true;
+}
+
+eventId_t scheduler_add(scheduler_t* scheduler, const uint64_t cycle, eventFunc func, void* context) {
+	if (func == NULL)
+		return 0;
+
+	if (scheduler->freeSlot == NO_SLOT && !grow(scheduler))
+		return 0;
+
+	const size_t slot = scheduler->freeSlot;
+	struct event* event = scheduler->slots + slot;
+	scheduler->freeSlot = event->heapIndex;
+
+	event->cycle = cycle;
+	event->order = scheduler->nextOrder++;
+	event->func = func;
+	event->context = context;
+
+	place(scheduler, scheduler->count, slot);
+	siftUp(scheduler, scheduler->count++);
+
+	// the generation starts at 1 in the id, so no id is 0
+	return ((uint64_t) (event->generation + 1) << 32) | slot;
+}
+
+bool scheduler_cancel(scheduler_t* scheduler, const eventId_t id) {
+	const size_t slot = (size_t) (id & 0xFFFFFFFF);
+	const uint32_t generation = (uint32_t) (id >> 32) - 1;
+	if (id == 0 || slot >= scheduler->capacity)
+		return false;
+
+	const struct event* event = scheduler->slots + slot;
+	if (event->func == NULL || event->generation != generation)
+		return false;
+
+	removeAt(scheduler, event->heapIndex);
+	return true;
+}
+
+void scheduler_run(scheduler_t* scheduler, const uint64_t cycle) {
+	while (scheduler->count && scheduler->slots[scheduler->heap[0]].cycle <= cycle) {
+		const struct event event = scheduler->slots[scheduler->heap[0]];
+
+		// the slot is freed before the call, so the event can reschedule itself
+		removeAt(scheduler, 0);
+		event.func(event.context, event.cycle);
+	}
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/// called once the cpu reached cycle, the cycle the event was scheduled for
+/// the cpu could already be a few cycles further, as events are handled between instructions
+/// a periodic event reschedules itself at cycle + period, so it doesn't drift
+typedef void (*eventFunc)(void* context, const uint64_t cycle);
+
+/// identifies a scheduled event, 0 is never a valid id
+typedef uint64_t eventId_t;
+
+struct event {
+	uint64_t cycle;
+	// order in which events were scheduled, events at the same cycle run in that order
+	uint64_t order;
+	eventFunc func;
+	void* context;
+	// position of this event in the heap, or SIZE_MAX if the slot is free
+	size_t heapIndex;
+	// incremented every time the slot is reused, so an old id doesn't cancel a new event
+	uint32_t generation;
+};
+
+/// events of a single machine, ordered on the absolute cycle of the cpu they are due at
+/// a min-heap of slot indices, so the next event is found in constant time, and scheduling and canceling take O(log n)
+/// a scheduler should be zero initialized before calling scheduler_init
+typedef struct scheduler {
+	struct event* slots;
+	size_t* heap;
+	size_t count;
+	size_t capacity;
+	// free slots are chained through their heapIndex
+	size_t freeSlot;
+	uint64_t nextOrder;
+} scheduler_t;
+
+bool scheduler_init(scheduler_t* scheduler);
+bool scheduler_destroy(scheduler_t* scheduler);
+
+/// schedules func to be called with context once the cpu reached cycle
+/// returns 0 if the event could not be stored
+eventId_t scheduler_add(scheduler_t* scheduler, const uint64_t cycle, eventFunc func, void* context);
+/// returns false if the event already ran or was canceled
+bool scheduler_cancel(scheduler_t* scheduler, const eventId_t id);
+
+/// the cycle the next event is due at, UINT64_MAX if there are none
+static inline uint64_t scheduler_next(const scheduler_t* scheduler) {
+	return scheduler->count ? scheduler->slots[scheduler->heap[0]].cycle : UINT64_MAX;
+}
+
+/// calls every event due at or before cycle, in order
+/// events can schedule and cancel other events, those due by cycle also run
+void scheduler_run(scheduler_t* scheduler, const uint64_t cycle);
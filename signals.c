@@ -0,0 +1,56 @@
+#include "signals.h"
+
+#define SIGNAL_QUEUE_MASK (SIGNAL_QUEUE_SIZE - 1)
+
+void signals_init(signalQueue_t* queue) {
+	for (size_t i = 0; i < SIGNAL_QUEUE_SIZE; i++)
+		atomic_init(&queue->cells[i].sequence, i);
+	atomic_init(&queue->head, 0);
+	queue->tail = 0;
+}
+
+bool signals_post(signalQueue_t* queue, const signalChange_t* change) {
+	size_t position = atomic_load_explicit(&queue->head, memory_order_relaxed);
+	struct signalCell* cell;
+
+	while (true) {
+		cell = queue->cells + (position & SIGNAL_QUEUE_MASK);
+		const size_t sequence = atomic_load_explicit(&cell->sequence, memory_order_acquire);
+		const ptrdiff_t lap = (ptrdiff_t) (sequence - position);
+
+		// the cell is free in this lap, claim it before another thread does
+		if (lap == 0) {
+			if (atomic_compare_exchange_weak_explicit(&queue->head, &position, position + 1, memory_order_relaxed, memory_order_relaxed))
+				break;
+		// the cell still holds a change of the previous lap
+		} else if (lap < 0)
+			return false;
+		// another thread claimed the cell already
+		else
+			position = atomic_load_explicit(&queue->head, memory_order_relaxed);
+	}
+
+	cell->change = *change;
+	// publishes the change to the taking thread
+	atomic_store_explicit(&cell->sequence, position + 1, memory_order_release);
+
+	return true;
+}
+
+bool signals_take(signalQueue_t* queue, signalChange_t* change) {
+	struct signalCell* cell = queue->cells + (queue->tail & SIGNAL_QUEUE_MASK);
+	if (atomic_load_explicit(&cell->sequence, memory_order_acquire) != queue->tail + 1)
+		return false;
+
+	*change = cell->change;
+	// frees the cell for the next lap
+	atomic_store_explicit(&cell->sequence, queue->tail + SIGNAL_QUEUE_SIZE, memory_order_release);
+	queue->tail++;
+
+	return true;
+}
+
+bool signals_waiting(const signalQueue_t* queue) {
+	const struct signalCell* cell = queue->cells + (queue->tail & SIGNAL_QUEUE_MASK);
+	return atomic_load_explicit(&cell->sequence, memory_order_acquire) == queue->tail + 1;
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/// amount of control input changes that can wait to be taken, must be a power of 2
+#ifndef SIGNAL_QUEUE_SIZE
+#define SIGNAL_QUEUE_SIZE 256
+#endif
+
+/// the control inputs of the cpu
+typedef enum {
+	SIGNAL_IRQ,
+	SIGNAL_NMI,
+	SIGNAL_RESET,
+} signalLine_t;
+
+/// a change of a control input, which should happen once the cpu reached cycle
+/// source is the irq source driving the line, only used for SIGNAL_IRQ
+typedef struct {
+	uint64_t cycle;
+	uint8_t line;
+	uint8_t source;
+	bool active;
+} signalChange_t;
+
+// sequence tells which lap of the ring the cell belongs to, and if it holds a change
+struct signalCell {
+	atomic_size_t sequence;
+	signalChange_t change;
+};
+
+/// control input changes posted by any amount of threads, taken by the single thread running the machine
+/// a bounded ring of cells with their own sequence numbers, so neither side ever takes a lock or waits on the other
+/// a queue should be initialized with signals_init before it is used
+typedef struct signalQueue {
+	struct signalCell cells[SIGNAL_QUEUE_SIZE];
+	// next cell to post to, shared by all posting threads
+	atomic_size_t head;
+	// next cell to take from, only used by the taking thread
+	size_t tail;
+} signalQueue_t;
+
+void signals_init(signalQueue_t* queue);
+
+/// can be called from any thread
+/// returns false if the queue is full
+bool signals_post(signalQueue_t* queue, const signalChange_t* change);
+
+/// takes the oldest change, should only be called from a single thread
+/// returns false if the queue is empty
+bool signals_take(signalQueue_t* queue, signalChange_t* change);
+/// true if signals_take would take a change, should only be called from the taking thread
+bool signals_waiting(const signalQueue_t* queue);
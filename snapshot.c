@@ -0,0 +1,190 @@
+#include "snapshot.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// true if device is in one of the regions of bus
+static bool isOnBus(const bus_t* bus, deviceRef_t device) {
+	for (size_t i = 0; i < bus->size; i++)
+		if (bus->regions[i].device == device)
+			return true;
+
+	return false;
+}
+
+bool snapshot_init(snapshotChain_t* chain, machine_t* machine, const deviceRef_t* memories, const size_t memoryCount) {
+	if (chain == NULL || machine == NULL || chain->memories)
+		return false;
+
+	// only the bus of machine is remapped once the dirty pages are cleared, see startDelta
+	for (size_t i = 0; i < memoryCount; i++) {
+		if (!isOnBus(&machine->bus, memories[i]))
+			return false;
+		for (size_t j = 0; j < i; j++)
+			if (memories[j] == memories[i])
+				return false;
+	}
+
+	*chain = (snapshotChain_t) { .machine = machine, .memoryCount = memoryCount };
+
+	chain->memories = malloc(memoryCount * sizeof(deviceRef_t));
+	if (chain->memories == NULL)
+		return false;
+	memcpy(chain->memories, memories, memoryCount * sizeof(deviceRef_t));
+
+	return true;
+}
+
+bool snapshot_destroy(snapshotChain_t* chain) {
+	if (chain == NULL || chain->memories == NULL)
+		return false;
+
+	for (size_t i = 0; i < chain->count; i++) {
+		free(chain->snapshots[i]->pages);
+		free(chain->snapshots[i]);
+	}
+	free(chain->snapshots);
+	free(chain->memories);
+
+	*chain = (snapshotChain_t) { 0 };
+
+	return true;
+}
+
+// true if page has to be kept by the next snapshot
+static bool isChanged(const snapshotChain_t* chain, const size_t memory, const size_t page) {
+	return chain->current == NULL || memory_isDirty(chain->memories[memory], page);
+}
+
+// keeps snapshot in the chain, returns false if the list couldn't grow
+static bool addSnapshot(snapshotChain_t* chain, snapshot_t* snapshot) {
+	snapshot_t** snapshots = realloc(chain->snapshots, (chain->count + 1) * sizeof(snapshot_t*));
+	if (snapshots == NULL)
+		return false;
+
+	chain->snapshots = snapshots;
+	chain->snapshots[chain->count++] = snapshot;
+
+	return true;
+}
+
+// the pages written from now on make up the next snapshot
+static void startDelta(snapshotChain_t* chain, const snapshot_t* snapshot) {
+	for (size_t i = 0; i < chain->memoryCount; i++)
+		memory_clearDirty(chain->memories[i]);
+
+	// the cleared pages are no longer written directly by the bus
+	bus_remap(&chain->machine->bus);
+
+	chain->current = snapshot;
+}
+
+const snapshot_t* snapshot_take(snapshotChain_t* chain) {
+	size_t pageCount = 0;
+	for (size_t i = 0; i < chain->memoryCount; i++)
+		for (size_t page = 0; page < memory_pageCount(chain->memories[i]); page++)
+			pageCount += isChanged(chain, i, page);
+
+	snapshot_t* snapshot = malloc(sizeof(snapshot_t));
+	if (snapshot == NULL)
+		return NULL;
+
+	*snapshot = (snapshot_t) {
+		.previous = chain->current,
+		.pages = malloc(pageCount * sizeof(struct snapshotPage)),
+		.pageCount = pageCount,
+	};
+
+	if ((pageCount && snapshot->pages == NULL) || !addSnapshot(chain, snapshot)) {
+		free(snapshot->pages);
+		free(snapshot);
+		return NULL;
+	}
+
+	struct snapshotPage* next = snapshot->pages;
+	for (size_t i = 0; i < chain->memoryCount; i++) {
+		deviceRef_t memory = chain->memories[i];
+		const size_t count = memory_pageCount(memory);
+		for (size_t page = 0; page < count; page++) {
+			if (!isChanged(chain, i, page))
+				continue;
+
+			// the last page of a memory can be shorter
+			size_t size;
+			const uint8_t* data = memory_page(memory, page, &size);
+			next->memory = (uint32_t) i;
+			next->page = (uint32_t) page;
+			memcpy(next->data, data, size);
+			memset(next->data + size, 0, MEMORY_PAGE_SIZE - size);
+			next++;
+		}
+	}
+
+	cpu_saveState(&chain->machine->cpu, &snapshot->cpu);
+	startDelta(chain, snapshot);
+
+	return snapshot;
+}
+
+bool snapshot_restore(snapshotChain_t* chain, const snapshot_t* snapshot) {
+	if (snapshot == NULL)
+		return false;
+
+	// the index of the first page of every memory, in the pages of all of them
+	size_t* firstPage = malloc((chain->memoryCount + 1) * sizeof(size_t));
+	if (firstPage == NULL)
+		return false;
+
+	firstPage[0] = 0;
+	for (size_t i = 0; i < chain->memoryCount; i++)
+		firstPage[i + 1] = firstPage[i] + memory_pageCount(chain->memories[i]);
+
+	// one bit per page, set once the newest version of it is restored
+	uint8_t* restored = calloc((firstPage[chain->memoryCount] + 7) / 8, 1);
+	if (restored == NULL) {
+		free(firstPage);
+		return false;
+	}
+
+	bool success = true;
+	bool changed = false;
+	for (const snapshot_t* current = snapshot; current && success; current = current->previous) {
+		for (size_t i = 0; i < current->pageCount; i++) {
+			const struct snapshotPage* page = current->pages + i;
+			const size_t index = firstPage[page->memory] + page->page;
+			if (restored[index / 8] & (1 << (index % 8)))
+				continue;
+			restored[index / 8] |= 1 << (index % 8);
+
+			deviceRef_t memory = chain->memories[page->memory];
+			size_t size;
+			const uint8_t* data = memory_page(memory, page->page, &size);
+			if (memcmp(data, page->data, size) == 0)
+				continue;
+
+			if (!memory_setPage(memory, page->page, page->data)) {
+				success = false;
+				break;
+			}
+			changed = true;
+		}
+	}
+
+	free(restored);
+	free(firstPage);
+
+	if (!success)
+		return false;
+
+	cpu_loadState(&chain->machine->cpu, &snapshot->cpu);
+	// the memory changed without going through the bus
+	if (changed)
+		cpu_flushBlockCache(&chain->machine->cpu);
+	startDelta(chain, snapshot);
+
+	return true;
+}
+
+size_t snapshot_size(const snapshot_t* snapshot) {
+	return sizeof(snapshot_t) + snapshot->pageCount * sizeof(struct snapshotPage);
+}
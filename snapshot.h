@@ -0,0 +1,65 @@
+#pragma once
+
+#include "cpu.h"
+#include "device.h"
+#include "machine.h"
+#include "memory.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/// a page of memory as it was when the snapshot was taken
+struct snapshotPage {
+	// index of the memory in the chain, and of the page in that memory
+	uint32_t memory;
+	uint32_t page;
+	uint8_t data[MEMORY_PAGE_SIZE];
+};
+
+/// the state of a machine at one point in time
+/// a base holds every page, a delta only the pages written since the snapshot it follows
+typedef struct snapshot {
+	// NULL for a base
+	const struct snapshot* previous;
+	cpuState_t cpu;
+	struct snapshotPage* pages;
+	size_t pageCount;
+} snapshot_t;
+
+/// snapshots of a machine and the memories on its bus
+/// the first snapshot is a base, every following one a delta on top of the snapshot the machine was last taken at or restored to
+/// the pages written in between are found through the dirty pages of the memories, see memory_clearDirty
+/// a snapshot only holds the cpu and the memories, the scheduled events and other devices are left as they are
+/// a chain should be zero initialized before calling snapshot_init
+typedef struct snapshotChain {
+	machine_t* machine;
+	deviceRef_t* memories;
+	size_t memoryCount;
+
+	// every snapshot taken, freed with the chain
+	snapshot_t** snapshots;
+	size_t count;
+	// the snapshot the memories are based on, NULL before the first one
+	const snapshot_t* current;
+} snapshotChain_t;
+
+/// takes snapshots of machine, and the memories created by memory_init, memory_mapFile or memory_clone
+/// the memories have to be on the bus of machine, and outlive the chain
+/// they must not be on any other bus, that bus would keep writing their cleared pages directly and the chain would miss those writes
+/// returns false if a memory isn't on the bus of machine, or is listed twice
+bool snapshot_init(snapshotChain_t* chain, machine_t* machine, const deviceRef_t* memories, const size_t memoryCount);
+bool snapshot_destroy(snapshotChain_t* chain);
+
+/// takes a snapshot of the machine, which should not be running
+/// only copies the pages written since the last snapshot taken or restored, the first snapshot copies all of them
+/// returns NULL if the snapshot could not be allocated
+const snapshot_t* snapshot_take(snapshotChain_t* chain);
+/// puts the machine back into the state of snapshot, taken from the same chain
+/// every page is taken from the newest snapshot holding it, following previous down to the base
+/// pages already holding the same data are not written, so memory shared with clones stays shared
+/// the next snapshot is a delta on top of this one
+bool snapshot_restore(snapshotChain_t* chain, const snapshot_t* snapshot);
+
+/// the bytes kept by snapshot, without the ones shared with the snapshots before it
+size_t snapshot_size(const snapshot_t* snapshot);
@@ -0,0 +1,226 @@
+#include "symbols.h"
+#include "util.h"
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// a line of an AS65 listing holding code or a label looks like
+// "0400 : d8               [ 2] start   cld"
+// the address, a colon, the bytes, the cycles and the source text, which starts at SOURCE_COLUMN
+// macro expansions have a '>' right before the source text
+#define SOURCE_COLUMN 29
+#define LINE_LENGTH 512
+
+// the listing ends with a symbol table and a memory map, which look like code lines
+#define SYMBOL_TABLE_HEADER "Symbol Table"
+
+// makes room for one more element of size bytes in list, doubling its capacity when it is full
+// returns the list, or NULL if it couldn't grow, it is left as it was then
+static void* grow(void* list, size_t* capacity, const size_t count, const size_t size) {
+	if (count < *capacity)
+		return list;
+
+	const size_t newCapacity = *capacity ? *capacity * 2 : 64;
+	void* newList = realloc(list, newCapacity * size);
+	if (newList != NULL)
+		*capacity = newCapacity;
+
+	return newList;
+}
+
+// keeps a copy of length characters of text, freed by symbols_destroy
+static char* keep(symbols_t* symbols, const char* text, const size_t length) {
+	char** strings = grow(symbols->strings, &symbols->stringCapacity, symbols->stringCount, sizeof(char*));
+	if (strings == NULL)
+		return NULL;
+	symbols->strings = strings;
+
+	char* copy = malloc(length + 1);
+	if (copy == NULL)
+		return NULL;
+
+	memcpy(copy, text, length);
+	copy[length] = 0;
+	symbols->strings[symbols->stringCount++] = copy;
+
+	return copy;
+}
+
+static bool addSymbol(symbols_t* symbols, const char* name, const size_t length, const uint16_t address) {
+	struct symbol* list = grow(symbols->symbols, &symbols->symbolCapacity, symbols->symbolCount, sizeof(struct symbol));
+	if (list == NULL)
+		return false;
+	symbols->symbols = list;
+
+	char* copy = keep(symbols, name, length);
+	if (copy == NULL)
+		return false;
+
+	symbols->symbols[symbols->symbolCount] = (struct symbol) { copy, address, symbols->symbolCount };
+	symbols->symbolCount++;
+	return true;
+}
+
+static int compareSymbols(const void* a, const void* b) {
+	const struct symbol* first = a;
+	const struct symbol* second = b;
+	if (first->address != second->address)
+		return first->address < second->address ? -1 : 1;
+	return first->index < second->index ? -1 : first->index > second->index;
+}
+
+// sorts on address, labels at the same address keep the order they were read in
+static void sortSymbols(symbols_t* symbols) {
+	if (symbols->symbolCount)
+		qsort(symbols->symbols, symbols->symbolCount, sizeof(struct symbol), compareSymbols);
+}
+
+// reads the address of a code line, returns false for any other line
+static bool parseAddress(const char* line, uint16_t* address) {
+	int value = 0;
+	for (int i = 0; i < 4; i++) {
+		const int digit = hexDigit(line[i]);
+		if (digit < 0)
+			return false;
+		value = (value << 4) | digit;
+	}
+
+	if (line[4] != ' ' || line[5] != ':')
+		return false;
+
+	*address = (uint16_t) value;
+	return true;
+}
+
+bool symbols_loadListing(symbols_t* symbols, const char* fileName) {
+	FILE* file = fopen(fileName, "r");
+	if (!file) {
+		printf("could not open file %s\n", fileName);
+		return false;
+	}
+
+	if (symbols->lines == NULL) {
+		symbols->lines = calloc(0x10000, sizeof(struct sourceLine));
+		if (symbols->lines == NULL) {
+			fclose(file);
+			return false;
+		}
+	}
+
+	const char* listing = keep(symbols, fileName, strlen(fileName));
+	if (listing == NULL) {
+		fclose(file);
+		return false;
+	}
+
+	char line[LINE_LENGTH];
+	uint32_t number = 0;
+	bool success = true;
+	while (success && fgets(line, sizeof(line), file)) {
+		number++;
+
+		size_t length = strlen(line);
+		// the rest of a line that didn't fit is skipped
+		if (length > 0 && line[length - 1] != '\n') {
+			int c;
+			while ((c = fgetc(file)) != EOF && c != '\n');
+		}
+		while (length > 0 && isspace((unsigned char) line[length - 1]))
+			length--;
+		line[length] = 0;
+
+		if (strstr(line, SYMBOL_TABLE_HEADER))
+			break;
+
+		uint16_t address;
+		if (length <= SOURCE_COLUMN || !parseAddress(line, &address))
+			continue;
+
+		const char* source = line + SOURCE_COLUMN;
+
+		// a label starts right at the source column
+		if (isalpha((unsigned char) source[0]) || source[0] == '_' || source[0] == '.') {
+			size_t nameLength = 0;
+			while (isalnum((unsigned char) source[nameLength]) || source[nameLength] == '_' || source[nameLength] == '.')
+				nameLength++;
+			success = addSymbol(symbols, source, nameLength, address);
+		}
+
+		// only lines which assembled bytes are code, the others just place a label
+		if (hexDigit(line[7]) < 0)
+			continue;
+
+		const char* text = keep(symbols, source, strlen(source));
+		if (text == NULL)
+			success = false;
+		else
+			symbols->lines[address] = (struct sourceLine) { listing, number, text };
+	}
+
+	fclose(file);
+	sortSymbols(symbols);
+
+	return success;
+}
+
+bool symbols_destroy(symbols_t* symbols) {
+	if (symbols == NULL)
+		return false;
+
+	for (size_t i = 0; i < symbols->stringCount; i++)
+		free(symbols->strings[i]);
+	free(symbols->strings);
+	free(symbols->symbols);
+	free(symbols->lines);
+
+	*symbols = (symbols_t) { 0 };
+
+	return true;
+}
+
+const struct symbol* symbols_find(const symbols_t* symbols, const uint16_t address, uint16_t* offset) {
+	if (symbols == NULL)
+		return NULL;
+
+	// the first symbol placed after address
+	size_t low = 0;
+	size_t high = symbols->symbolCount;
+	while (low < high) {
+		const size_t middle = low + (high - low) / 2;
+		if (symbols->symbols[middle].address <= address)
+			low = middle + 1;
+		else
+			high = middle;
+	}
+
+	if (low == 0)
+		return NULL;
+
+	const struct symbol* symbol = &symbols->symbols[low - 1];
+	if (offset)
+		*offset = address - symbol->address;
+	return symbol;
+}
+
+const struct sourceLine* symbols_line(const symbols_t* symbols, const uint16_t address) {
+	if (symbols == NULL || symbols->lines == NULL || symbols->lines[address].file == NULL)
+		return NULL;
+
+	return &symbols->lines[address];
+}
+
+const char* symbols_name(const symbols_t* symbols, const uint16_t address, char* name, const size_t size) {
+	uint16_t offset;
+	const struct symbol* symbol = symbols_find(symbols, address, &offset);
+
+	if (symbol == NULL)
+		snprintf(name, size, "$%04X", address);
+	else if (offset == 0)
+		snprintf(name, size, "%s", symbol->name);
+	else
+		snprintf(name, size, "%s+%u", symbol->name, offset);
+
+	return name;
+}
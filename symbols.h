@@ -0,0 +1,54 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/// a label from a listing, and the address it is placed at
+struct symbol {
+	char* name;
+	uint16_t address;
+	// how many labels were read before this one, labels at the same address stay in this order
+	size_t index;
+};
+
+/// where an address was assembled from
+struct sourceLine {
+	// the listing, NULL if nothing was assembled at the address
+	const char* file;
+	uint32_t line;
+	// the source text of the line, without the address, bytes and cycles in front of it
+	const char* text;
+};
+
+/// labels and source lines of the code in memory, read from AS65 listings (-l, the .lst files next to the tests)
+/// multiple listings can be loaded into the same symbols, later listings override earlier ones
+/// a symbols should be zero initialized before loading the first listing
+typedef struct symbols {
+	// sorted by address
+	struct symbol* symbols;
+	size_t symbolCount;
+	size_t symbolCapacity;
+
+	// every address that was assembled, indexed by address
+	struct sourceLine* lines;
+
+	// the file names and source texts, freed with the symbols
+	char** strings;
+	size_t stringCount;
+	size_t stringCapacity;
+} symbols_t;
+
+/// reads the labels and code lines of an AS65 listing
+/// returns false if the file can't be read
+bool symbols_loadListing(symbols_t* symbols, const char* fileName);
+bool symbols_destroy(symbols_t* symbols);
+
+/// the last label placed at or before address, NULL if there is none
+/// offset is set to the distance from the label if it isn't NULL
+const struct symbol* symbols_find(const symbols_t* symbols, const uint16_t address, uint16_t* offset);
+/// the line address was assembled from, NULL if it isn't known
+const struct sourceLine* symbols_line(const symbols_t* symbols, const uint16_t address);
+/// writes the label of address to name, with +offset if it isn't placed at the label itself, or $XXXX if it has no label
+/// returns name
+const char* symbols_name(const symbols_t* symbols, const uint16_t address, char* name, const size_t size);
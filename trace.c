@@ -0,0 +1,335 @@
+#include "trace.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define TRACE_BUFFER_MASK (TRACE_BUFFER_RECORDS - 1)
+
+// the file starts with a header, followed by the records
+// the header is TRACE_MAGIC, TRACE_VERSION, the compression and the cpu variant
+#define TRACE_MAGIC "6502TRC"
+#define TRACE_VERSION 1
+#define HEADER_BYTES 11
+
+// a record in the file, all values little endian
+// cycle, PC, opcode, operands, A, X, Y, flags, SP, access count, then every access as address, data and write
+#define ACCESS_BYTES 4
+#define RECORD_BYTES (8 + 2 + 1 + 2 + 5 + 1 + TRACE_MAX_ACCESSES * ACCESS_BYTES)
+
+static void serialize(const traceRecord_t* record, uint8_t* bytes) {
+	for (int i = 0; i < 8; i++)
+		*bytes++ = (uint8_t) (record->cycle >> (i * 8));
+	*bytes++ = record->PC & 0xFF;
+	*bytes++ = record->PC >> 8;
+	*bytes++ = record->opcode;
+	*bytes++ = record->operands[0];
+	*bytes++ = record->operands[1];
+	*bytes++ = record->A;
+	*bytes++ = record->X;
+	*bytes++ = record->Y;
+	*bytes++ = record->flags;
+	*bytes++ = record->SP;
+	*bytes++ = record->accessCount;
+	// unused accesses are written as zeros, so they compress away
+	for (int i = 0; i < TRACE_MAX_ACCESSES; i++) {
+		const bool used = i < record->accessCount;
+		*bytes++ = used ? record->accesses[i].address & 0xFF : 0;
+		*bytes++ = used ? record->accesses[i].address >> 8 : 0;
+		*bytes++ = used ? record->accesses[i].data : 0;
+		*bytes++ = used ? record->accesses[i].write : 0;
+	}
+}
+
+static void deserialize(const uint8_t* bytes, traceRecord_t* record) {
+	record->cycle = 0;
+	for (int i = 0; i < 8; i++)
+		record->cycle |= (uint64_t) *bytes++ << (i * 8);
+	record->PC = bytes[0] | (bytes[1] << 8);
+	bytes += 2;
+	record->opcode = *bytes++;
+	record->operands[0] = *bytes++;
+	record->operands[1] = *bytes++;
+	record->A = *bytes++;
+	record->X = *bytes++;
+	record->Y = *bytes++;
+	record->flags = *bytes++;
+	record->SP = *bytes++;
+	record->accessCount = *bytes++;
+	if (record->accessCount > TRACE_MAX_ACCESSES)
+		record->accessCount = TRACE_MAX_ACCESSES;
+	for (int i = 0; i < TRACE_MAX_ACCESSES; i++) {
+		record->accesses[i].address = bytes[0] | (bytes[1] << 8);
+		record->accesses[i].data = bytes[2];
+		record->accesses[i].write = bytes[3];
+		bytes += ACCESS_BYTES;
+	}
+}
+
+// a control byte with the high bit set is followed by nothing, and stands for (low bits + 1) zero bytes
+// otherwise (control byte + 1) bytes are copied as they are
+// returns the length of the encoding, at most RECORD_BYTES + RECORD_BYTES / 128 + 1
+static size_t encodeZeroRuns(const uint8_t* bytes, uint8_t* encoded) {
+	size_t length = 0;
+	size_t i = 0;
+	while (i < RECORD_BYTES) {
+		size_t run = 0;
+		while (i + run < RECORD_BYTES && bytes[i + run] == 0 && run < 128)
+			run++;
+		if (run) {
+			encoded[length++] = (uint8_t) (0x80 | (run - 1));
+			i += run;
+			continue;
+		}
+
+		size_t literal = 0;
+		while (i + literal < RECORD_BYTES && bytes[i + literal] != 0 && literal < 128)
+			literal++;
+		encoded[length++] = (uint8_t) (literal - 1);
+		memcpy(encoded + length, bytes + i, literal);
+		length += literal;
+		i += literal;
+	}
+
+	return length;
+}
+
+// returns false if the file ended, or holds something that isn't an encoded record
+static bool decodeZeroRuns(FILE* file, uint8_t* bytes) {
+	size_t i = 0;
+	while (i < RECORD_BYTES) {
+		const int control = fgetc(file);
+		if (control == EOF)
+			return false;
+
+		const size_t count = (control & 0x7F) + 1;
+		if (i + count > RECORD_BYTES)
+			return false;
+
+		if (control & 0x80)
+			memset(bytes + i, 0, count);
+		else if (fread(bytes + i, 1, count, file) != count)
+			return false;
+		i += count;
+	}
+
+	return true;
+}
+
+static int writer(void* context) {
+	trace_t* trace = context;
+
+	uint8_t previous[RECORD_BYTES] = { 0 };
+	uint8_t bytes[RECORD_BYTES];
+	uint8_t encoded[RECORD_BYTES + RECORD_BYTES / 128 + 1];
+
+	while (true) {
+		size_t tail = atomic_load_explicit(&trace->tail, memory_order_relaxed);
+		size_t head = atomic_load(&trace->head);
+
+		if (tail == head) {
+			// trace_end wakes the writer when it puts a record in the empty buffer
+			mtx_lock(&trace->lock);
+			while ((head = atomic_load(&trace->head)) == tail && !atomic_load(&trace->closing))
+				cnd_wait(&trace->wake, &trace->lock);
+			mtx_unlock(&trace->lock);
+
+			// the cpu doesn't add records anymore once closing is set, so an empty buffer stays empty
+			if (head == tail)
+				break;
+		}
+
+		for (; tail != head; tail++) {
+			// after a failed write the records are still taken, so the cpu never waits for a full buffer
+			if (atomic_load_explicit(&trace->failed, memory_order_relaxed))
+				continue;
+
+			serialize(trace->records + (tail & TRACE_BUFFER_MASK), bytes);
+
+			const uint8_t* data = bytes;
+			size_t length = RECORD_BYTES;
+			if (trace->compression == TRACE_DELTA) {
+				for (size_t i = 0; i < RECORD_BYTES; i++) {
+					const uint8_t delta = bytes[i] ^ previous[i];
+					previous[i] = bytes[i];
+					bytes[i] = delta;
+				}
+				data = encoded;
+				length = encodeZeroRuns(bytes, encoded);
+			}
+
+			if (fwrite(data, 1, length, trace->file) == length)
+				trace->written++;
+			else
+				atomic_store_explicit(&trace->failed, true, memory_order_relaxed);
+		}
+
+		// hands the records back to the cpu
+		// sequentially consistent, so either trace_end sees the buffer empty, or the writer sees its record, see there
+		atomic_store(&trace->tail, tail);
+	}
+
+	if (fflush(trace->file) != 0)
+		atomic_store_explicit(&trace->failed, true, memory_order_relaxed);
+	return 0;
+}
+
+bool trace_open(trace_t* trace, const char* fileName, const cpuVariant_t variant, const traceCompression_t compression) {
+	if (trace->records)
+		return false;
+
+	trace->records = malloc(sizeof(traceRecord_t) * TRACE_BUFFER_RECORDS);
+	if (trace->records == NULL)
+		return false;
+
+	trace->file = fopen(fileName, "wb");
+	if (!trace->file) {
+		printf("could not open file %s\n", fileName);
+		free(trace->records);
+		trace->records = NULL;
+		return false;
+	}
+
+	uint8_t header[HEADER_BYTES] = { 0 };
+	memcpy(header, TRACE_MAGIC, sizeof(TRACE_MAGIC));
+	header[8] = TRACE_VERSION;
+	header[9] = (uint8_t) compression;
+	header[10] = (uint8_t) variant;
+
+	atomic_init(&trace->head, 0);
+	atomic_init(&trace->tail, 0);
+	atomic_init(&trace->closing, false);
+	atomic_init(&trace->failed, false);
+	trace->recording = false;
+	trace->compression = compression;
+	trace->written = 0;
+
+	if (fwrite(header, 1, HEADER_BYTES, trace->file) != HEADER_BYTES || mtx_init(&trace->lock, mtx_plain) != thrd_success) {
+		fclose(trace->file);
+		free(trace->records);
+		trace->records = NULL;
+		return false;
+	}
+
+	if (cnd_init(&trace->wake) != thrd_success) {
+		mtx_destroy(&trace->lock);
+		fclose(trace->file);
+		free(trace->records);
+		trace->records = NULL;
+		return false;
+	}
+
+	if (thrd_create(&trace->writer, writer, trace) != thrd_success) {
+		cnd_destroy(&trace->wake);
+		mtx_destroy(&trace->lock);
+		fclose(trace->file);
+		free(trace->records);
+		trace->records = NULL;
+		return false;
+	}
+
+	return true;
+}
+
+bool trace_close(trace_t* trace) {
+	if (!trace->records)
+		return false;
+
+	mtx_lock(&trace->lock);
+	atomic_store(&trace->closing, true);
+	cnd_signal(&trace->wake);
+	mtx_unlock(&trace->lock);
+	thrd_join(trace->writer, NULL);
+
+	cnd_destroy(&trace->wake);
+	mtx_destroy(&trace->lock);
+	const bool closed = fclose(trace->file) == 0;
+	free(trace->records);
+	trace->records = NULL;
+
+	return closed && !atomic_load(&trace->failed);
+}
+
+void trace_begin(trace_t* trace, const traceRecord_t* state) {
+	trace->current = *state;
+	trace->current.accessCount = 0;
+	trace->recording = true;
+}
+
+void trace_end(trace_t* trace) {
+	trace->recording = false;
+
+	const size_t head = atomic_load_explicit(&trace->head, memory_order_relaxed);
+	// a full buffer waits for the writer, records are never dropped
+	while (head - atomic_load_explicit(&trace->tail, memory_order_acquire) >= TRACE_BUFFER_RECORDS)
+		thrd_yield();
+
+	trace->records[head & TRACE_BUFFER_MASK] = trace->current;
+	atomic_store(&trace->head, head + 1);
+
+	// the writer waits for a record once the buffer is empty, so only the first record after that wakes it
+	// it checks head while holding the lock, so it either sees the record, or already waits when it is signaled
+	if (atomic_load(&trace->tail) == head) {
+		mtx_lock(&trace->lock);
+		cnd_signal(&trace->wake);
+		mtx_unlock(&trace->lock);
+	}
+}
+
+void trace_access(void* context, const uint16_t fullAddr, const uint8_t data, const bool write) {
+	trace_t* trace = context;
+
+	// accesses outside of an instruction, like those of an interrupt, don't belong to a record
+	if (!trace->recording || trace->current.accessCount == TRACE_MAX_ACCESSES)
+		return;
+
+	trace->current.accesses[trace->current.accessCount++] = (struct traceAccess) { fullAddr, data, write };
+}
+
+bool trace_decode(const char* fileName, const bool registers) {
+	FILE* file = fopen(fileName, "rb");
+	if (!file) {
+		printf("could not open file %s\n", fileName);
+		return false;
+	}
+
+	uint8_t header[HEADER_BYTES];
+	if (fread(header, 1, HEADER_BYTES, file) != HEADER_BYTES || memcmp(header, TRACE_MAGIC, sizeof(TRACE_MAGIC)) != 0 ||
+		header[8] != TRACE_VERSION || header[9] > TRACE_DELTA || header[10] >= CPU_VARIANT_COUNT) {
+		printf("%s is not a trace\n", fileName);
+		fclose(file);
+		return false;
+	}
+
+	const traceCompression_t compression = header[9];
+	const cpuVariant_t variant = header[10];
+
+	uint8_t bytes[RECORD_BYTES] = { 0 };
+	uint8_t delta[RECORD_BYTES];
+	traceRecord_t record;
+	while (true) {
+		if (compression == TRACE_DELTA) {
+			if (!decodeZeroRuns(file, delta))
+				break;
+			for (size_t i = 0; i < RECORD_BYTES; i++)
+				bytes[i] ^= delta[i];
+		} else if (fread(bytes, 1, RECORD_BYTES, file) != RECORD_BYTES)
+			break;
+
+		deserialize(bytes, &record);
+
+		const uint8_t data[3] = { record.opcode, record.operands[0], record.operands[1] };
+		cpu_printInstruction(variant, record.PC, data);
+
+		if (!registers)
+			continue;
+
+		printf("       %llu A:%02X X:%02X Y:%02X P:%02X SP:%02X",
+			(unsigned long long) record.cycle, record.A, record.X, record.Y, record.flags, record.SP);
+		for (uint8_t i = 0; i < record.accessCount; i++)
+			printf(" %c$%04X=%02X", record.accesses[i].write ? 'w' : 'r', record.accesses[i].address, record.accesses[i].data);
+		printf("\n");
+	}
+
+	fclose(file);
+	return true;
+}
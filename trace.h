@@ -0,0 +1,95 @@
+#pragma once
+
+#include "cpu.h"
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <threads.h>
+
+/// records that can wait in memory for the writer thread, must be a power of 2
+#ifndef TRACE_BUFFER_RECORDS
+#define TRACE_BUFFER_RECORDS 65536
+#endif
+
+/// most bus accesses kept for a single instruction, the longest instruction (BRK) does 6
+#define TRACE_MAX_ACCESSES 8
+
+/// how records are stored in the trace file
+typedef enum {
+	TRACE_RAW, // every record as is
+	TRACE_DELTA, // every record xor'ed with the one before, with runs of zero bytes shortened
+} traceCompression_t;
+
+/// a single read or write on the bus
+struct traceAccess {
+	uint16_t address;
+	uint8_t data;
+	bool write;
+};
+
+/// a single executed instruction, with the registers from before it ran
+/// accesses holds the reads and writes it did on the bus, in order, starting with the fetch of the opcode
+typedef struct {
+	uint64_t cycle;
+	uint16_t PC;
+	uint8_t opcode;
+	uint8_t operands[2];
+	uint8_t A;
+	uint8_t X;
+	uint8_t Y;
+	uint8_t flags;
+	uint8_t SP;
+	uint8_t accessCount;
+	struct traceAccess accesses[TRACE_MAX_ACCESSES];
+} traceRecord_t;
+
+/// a trace of the instructions run by a single cpu, streamed to a file
+/// the cpu puts records in a ring buffer without taking a lock, a writer thread moves them to the file
+/// the cpu only waits when the buffer is full, so nothing is lost
+/// a trace should be zero initialized before calling trace_open
+typedef struct trace {
+	traceRecord_t* records;
+	// next record the cpu writes, only changed by the cpu
+	atomic_size_t head;
+	// next record the writer thread takes, only changed by the writer
+	atomic_size_t tail;
+
+	// the instruction being recorded
+	traceRecord_t current;
+	bool recording;
+
+	FILE* file;
+	traceCompression_t compression;
+	thrd_t writer;
+	// the writer waits on wake while the buffer is empty
+	mtx_t lock;
+	cnd_t wake;
+	atomic_bool closing;
+	// set by the writer once writing to the file failed, nothing is written after that
+	atomic_bool failed;
+
+	uint64_t written;
+} trace_t;
+
+/// creates fileName and starts the writer thread
+/// variant is stored in the file, so it can be decoded without knowing what produced it
+bool trace_open(trace_t* trace, const char* fileName, const cpuVariant_t variant, const traceCompression_t compression);
+/// writes the remaining records and closes the file
+/// the trace should no longer be set on a cpu
+/// returns false if writing the file failed, the records after the failed write are dropped
+bool trace_close(trace_t* trace);
+
+/// used by the cpu, from a single thread
+/// begin starts a record with the state before the instruction runs, end puts it in the buffer
+/// bus accesses in between are added to the record
+void trace_begin(trace_t* trace, const traceRecord_t* state);
+void trace_end(trace_t* trace);
+/// a busObserver for the bus of the traced cpu
+void trace_access(void* context, const uint16_t fullAddr, const uint8_t data, const bool write);
+
+/// prints every record of a trace file, with its instruction in the format of cpu_printOpcode
+/// with registers set, every instruction is followed by a line holding the cycle, registers and bus accesses
+/// returns false if the file can't be read, or isn't a trace
+bool trace_decode(const char* fileName, const bool registers);
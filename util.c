@@ -3,7 +3,12 @@
 #include <string.h>
 
 const char* byteToBinStr(const uint8_t byte) {
-	static char str[9] = { 0 };
+	// every thread gets its own buffer, so machines on different threads can print at the same time
+#ifdef _MSC_VER
+	static __declspec(thread) char str[9] = { 0 };
+#else
+	static _Thread_local char str[9] = { 0 };
+#endif
 	str[0] = 0;
 
 	for (int i = 7; i >= 0; i--)
@@ -15,3 +20,13 @@ const char* byteToBinStr(const uint8_t byte) {
 
 	return str;
 }
+
+int hexDigit(const char c) {
+	if (c >= '0' && c <= '9')
+		return c - '0';
+	if (c >= 'a' && c <= 'f')
+		return c - 'a' + 10;
+	if (c >= 'A' && c <= 'F')
+		return c - 'A' + 10;
+	return -1;
+}
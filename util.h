@@ -2,4 +2,6 @@
 
 #include <stdint.h>
 
-const char* byteToBinStr(const uint8_t byte);
\ No newline at end of file
+const char* byteToBinStr(const uint8_t byte);
+/// the value of a hex digit, or -1 if c isn't one
+int hexDigit(const char c);
\ No newline at end of file